@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Keeps the compiler from optimizing away results that are never used
+template<typename T>
+inline void do_not_optimize(const T &value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T *sink;
+    sink = &value;
+#endif
+}
+
+struct BenchmarkResult
+{
+    std::string name;
+    uint64_t iterations;
+    double ns_per_op;
+    double min_ns_per_op;
+    double max_ns_per_op;
+    // Items processed per op, e.g. points converted, 0 if not meaningful
+    uint64_t items_per_op;
+};
+
+/*
+    Minimal benchmark harness. Every benchmark is calibrated until one batch
+    takes at least BENCHMARK_BATCH_MS, then BENCHMARK_SAMPLES batches are
+    timed and the median is reported.
+*/
+class Benchmark
+{
+private:
+    static const int BENCHMARK_BATCH_MS = 20;
+    static const int BENCHMARK_SAMPLES = 7;
+
+    std::string filter;
+    std::vector<BenchmarkResult> results;
+
+    template<typename F>
+    static double time_batch(F &f, uint64_t iterations) {
+        auto begin = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; i++) {
+            f();
+        }
+        auto end = std::chrono::steady_clock::now();
+        return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+    }
+public:
+    // Only benchmarks whose name contains filter are run
+    Benchmark(std::string filter) : filter(filter) {}
+
+    template<typename F>
+    void run(std::string name, F f, uint64_t items_per_op = 0) {
+        if (name.find(filter) == std::string::npos) {
+            return;
+        }
+
+        // Warm up and calibrate
+        uint64_t iterations = 1;
+        while (time_batch(f, iterations) < BENCHMARK_BATCH_MS * 1.0e6 && iterations < (1ull << 40)) {
+            iterations *= 2;
+        }
+
+        std::vector<double> samples;
+        for (int i = 0; i < BENCHMARK_SAMPLES; i++) {
+            samples.push_back(time_batch(f, iterations) / (double) iterations);
+        }
+        std::sort(samples.begin(), samples.end());
+
+        BenchmarkResult result = {
+            name,
+            iterations,
+            samples[samples.size() / 2],
+            samples.front(),
+            samples.back(),
+            items_per_op
+        };
+        results.push_back(result);
+
+        // Progress goes to stderr, stdout may be the JSON output
+        std::cerr << name << ": " << result.ns_per_op << " ns/op" << std::endl;
+    }
+
+    void write_json(std::ostream &out) const {
+        out << "{\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchmarkResult &result = results[i];
+            out << (i > 0 ? "," : "") << "\n    {"
+                << "\"name\": \"" << result.name << "\", "
+                << "\"iterations\": " << result.iterations << ", "
+                << "\"ns_per_op\": " << result.ns_per_op << ", "
+                << "\"min_ns_per_op\": " << result.min_ns_per_op << ", "
+                << "\"max_ns_per_op\": " << result.max_ns_per_op;
+            if (result.items_per_op > 0) {
+                out << ", \"items_per_second\": " << (double) result.items_per_op / result.ns_per_op * 1.0e9;
+            }
+            out << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+};
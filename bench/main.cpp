@@ -0,0 +1,870 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Benchmark.hpp"
+#include "Camera.hpp"
+#include "CellIndex.hpp"
+#include "Constants.hpp"
+#include "Ellipsoid.hpp"
+#include "Geo.hpp"
+#include "Globe.hpp"
+#include "GlyphAtlas.hpp"
+#include "HeatmapLayer.hpp"
+#include "Image.hpp"
+#include "LabelLayer.hpp"
+#include "LineLayer.hpp"
+#include "MarkerBuffer.hpp"
+#include "MarkerLayer.hpp"
+#include "Mesh.hpp"
+#include "PatchPool.hpp"
+#include "Picker.hpp"
+#include "ProgramCache.hpp"
+#include "RenderState.hpp"
+#include "RenderTarget.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "Sphere.hpp"
+#include "StorageBuffer.hpp"
+#include "Terrain.hpp"
+#include "ThreadPool.hpp"
+#include "UniformBuffer.hpp"
+
+/*
+    Microbenchmarks for the CPU kernels and texture processing.
+    Usage: cge-bench [--filter <substring>] [--out <file.json>] [--img <dir>] [--dem <dir>]
+    Results are written as JSON to stdout or the given file, progress to stderr.
+    Run from the directory that contains img/, like the main executable.
+    Everything but the *_gl benchmarks runs headless on cge_core.
+*/
+
+static void bench_sphere(Benchmark &benchmark)
+{
+    static const uint64_t resolutions[] = { 20, 64, 256, 1024 };
+    for (uint64_t resolution : resolutions) {
+        Sphere sphere(glm::vec3(0.0f), EARTH_RADIUS, resolution, resolution);
+        std::string name = "sphere_generate/" + std::to_string(resolution) + "x" + std::to_string(resolution);
+        benchmark.run(name, [&]() {
+            sphere.generate();
+            do_not_optimize(sphere.get_vertices().data());
+        }, (resolution + 1) * (resolution + 1));
+    }
+}
+
+static void bench_globe(Benchmark &benchmark, std::string dem_dir)
+{
+    Terrain smooth;
+    benchmark.run("globe_generate/smooth", [&]() {
+        Globe globe(Ellipsoid::wgs84(), smooth, GLOBE_PATCH_ROWS, GLOBE_PATCH_COLUMNS, GLOBE_PATCH_RESOLUTION);
+        do_not_optimize(globe.get_patches().data());
+    }, GLOBE_PATCH_ROWS * GLOBE_PATCH_COLUMNS);
+
+    // Tiles stay mapped, so after the first run this measures resampling,
+    // not disk I/O
+    Terrain terrain;
+    if (terrain.load_directory(dem_dir) == 0) {
+        std::cerr << "No DEM tiles in " << dem_dir << ", skipping globe_generate/terrain" << std::endl;
+        return;
+    }
+    benchmark.run("globe_generate/terrain", [&]() {
+        Globe globe(Ellipsoid::wgs84(), terrain, GLOBE_PATCH_ROWS, GLOBE_PATCH_COLUMNS, GLOBE_PATCH_RESOLUTION);
+        do_not_optimize(globe.get_patches().data());
+    }, GLOBE_PATCH_ROWS * GLOBE_PATCH_COLUMNS);
+}
+
+static void bench_images(Benchmark &benchmark, std::string img_dir, bool has_gl)
+{
+    std::vector<std::filesystem::path> paths;
+    for (const auto &entry : std::filesystem::directory_iterator(img_dir)) {
+        if (entry.path().extension() == ".jpg") {
+            paths.push_back(entry.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    for (const std::filesystem::path &path : paths) {
+        // Decode from memory so disk I/O is not part of the measurement
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        std::string data = contents.str();
+
+        Image image;
+        if (image.load_from_memory((const uint8_t*) data.data(), data.size(), 3) != LOAD_IMAGE_SUCCESS) {
+            continue;
+        }
+
+        benchmark.run("jpeg_decode/" + path.filename().string(), [&]() {
+            Image decoded;
+            decoded.load_from_memory((const uint8_t*) data.data(), data.size(), 3);
+            do_not_optimize(decoded.get_pixels());
+        });
+
+        benchmark.run("mip_generate/" + path.filename().string(), [&]() {
+            std::vector<Image> mips = image.generate_mips();
+            do_not_optimize(mips.data());
+        });
+
+        benchmark.run("equirect_to_cube/" + path.filename().string(), [&]() {
+            std::vector<Image> faces = image.equirect_to_cube(SKYBOX_FACE_SIZE);
+            do_not_optimize(faces.data());
+        });
+
+        if (!has_gl) {
+            continue;
+        }
+
+        GLuint texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image.get_width(), image.get_height(), 0, GL_RGB, GL_UNSIGNED_BYTE, image.get_pixels());
+
+        // glFinish, the driver generates mips asynchronously
+        benchmark.run("mip_generate_gl/" + path.filename().string(), [&]() {
+            glGenerateMipmap(GL_TEXTURE_2D);
+            glFinish();
+        });
+
+        glDeleteTextures(1, &texture);
+    }
+}
+
+// Fragment shader invocations of one call, 0 without pipeline statistics queries
+template<typename F>
+static uint64_t count_fragments(F f)
+{
+    if (!GLAD_GL_VERSION_4_6 && !GLAD_GL_ARB_pipeline_statistics_query) {
+        return 0;
+    }
+
+    GLuint query = 0;
+    glGenQueries(1, &query);
+    glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS, query);
+    f();
+    glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS);
+
+    GLuint64 fragments = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &fragments);
+    glDeleteQueries(1, &query);
+
+    return fragments;
+}
+
+static void bench_culling(Benchmark &benchmark)
+{
+    // Offscreen, the benchmark window is tiny
+    static const int size = 1024;
+
+    ProgramCache program_cache(PROGRAM_CACHE_DIR);
+    Program program;
+    // Logarithmic depth needs no clip control state
+    if (program_cache.load_program(program, VERTEX_SHADER_SRC, FRAGMENT_SHADER_SRC, FEATURE_LOG_DEPTH) != LOAD_PROGRAM_SUCCESS) {
+        return;
+    }
+
+    RenderTarget render_target;
+    render_target.bind(size, size);
+    glViewport(0, 0, size, size);
+
+    Mesh earth(Sphere(glm::vec3(0.0f), EARTH_RADIUS, 256, 256));
+    earth.set_attributes(POS_ATTR_LOCATION, TEX_ATTR_LOCATION);
+
+    // The earth from the default camera position
+    Camera camera(EARTH_RADIUS, CAMERA_MIN_ALTITUDE, SPACE_RADIUS);
+    camera.set_viewport(size, size);
+    camera.set_depth_mode(DEPTH_LOGARITHMIC);
+    UniformBuffer frame_uniforms(FRAME_UNIFORM_BINDING, sizeof(FrameUniforms));
+    UniformBuffer object_uniforms(OBJECT_UNIFORM_BINDING, sizeof(ObjectUniforms));
+    FrameUniforms frame_data = {};
+    frame_data.view = camera.get_view_rotation();
+    frame_data.proj = camera.get_proj();
+    frame_data.view_proj = frame_data.proj * frame_data.view;
+    split_double(camera.get_position(), frame_data.camera_high, frame_data.camera_low);
+    frame_data.log_depth_coefficient = camera.get_log_depth_coefficient();
+    ObjectUniforms object_data = {};
+    object_data.model = glm::mat4(1.0f);
+    frame_uniforms.set(0, &frame_data);
+    frame_uniforms.upload(1);
+    frame_uniforms.bind(0);
+    object_uniforms.set(0, &object_data);
+    object_uniforms.upload(1);
+    object_uniforms.bind(0);
+
+    program.use();
+    RenderStateCache render_states;
+    for (bool cull : { false, true }) {
+        RenderState state;
+        state.cull = cull;
+
+        auto draw = [&]() {
+            render_states.apply(RenderState());
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            render_states.apply(state);
+            earth.draw();
+        };
+
+        // Reported as items, so the JSON shows how many fragments culling saves
+        uint64_t fragments = count_fragments(draw);
+        std::cerr << "earth_draw_gl/" << (cull ? "cull" : "no_cull") << ": " << fragments << " fragments" << std::endl;
+
+        // glFinish, otherwise only the submission is measured
+        benchmark.run(std::string("earth_draw_gl/") + (cull ? "cull" : "no_cull"), [&]() {
+            draw();
+            glFinish();
+        }, fragments);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+static void bench_patch_pool(Benchmark &benchmark)
+{
+    // Many small patches, so the draw calls dominate and not the pixels
+    static const int size = 256;
+    static const uint32_t rows = 32;
+    static const uint32_t columns = 64;
+
+    ProgramCache program_cache(PROGRAM_CACHE_DIR);
+    Program per_patch_program;
+    Program multi_draw_program;
+    if (program_cache.load_program(per_patch_program, VERTEX_SHADER_SRC, FRAGMENT_SHADER_SRC, FEATURE_LOG_DEPTH) != LOAD_PROGRAM_SUCCESS
+        || program_cache.load_program(multi_draw_program, VERTEX_SHADER_SRC, FRAGMENT_SHADER_SRC, FEATURE_LOG_DEPTH | FEATURE_MULTI_DRAW) != LOAD_PROGRAM_SUCCESS) {
+        return;
+    }
+
+    RenderTarget render_target;
+    render_target.bind(size, size);
+    glViewport(0, 0, size, size);
+
+    Terrain terrain;
+    Globe globe(Ellipsoid::wgs84(), terrain, rows, columns, 16);
+    const std::vector<GlobePatch> &patches = globe.get_patches();
+
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    PatchPool pool((uint32_t) patches[0].vertices.size() / 3, (uint32_t) patches[0].indices.size(), (uint32_t) patches.size());
+    std::vector<uint32_t> slots;
+    for (const GlobePatch &patch : patches) {
+        meshes.emplace_back(new Mesh(patch));
+        meshes.back()->set_attributes(POS_ATTR_LOCATION, TEX_ATTR_LOCATION, MORPH_ATTR_LOCATION);
+        slots.push_back((uint32_t) pool.allocate(patch));
+    }
+    pool.set_attributes(POS_ATTR_LOCATION, TEX_ATTR_LOCATION, MORPH_ATTR_LOCATION);
+
+    Camera camera(EARTH_RADIUS, CAMERA_MIN_ALTITUDE, SPACE_RADIUS);
+    camera.set_viewport(size, size);
+    camera.set_depth_mode(DEPTH_LOGARITHMIC);
+    UniformBuffer frame_uniforms(FRAME_UNIFORM_BINDING, sizeof(FrameUniforms));
+    FrameUniforms frame_data = {};
+    frame_data.view = camera.get_view_rotation();
+    frame_data.proj = camera.get_proj();
+    frame_data.view_proj = frame_data.proj * frame_data.view;
+    split_double(camera.get_position(), frame_data.camera_high, frame_data.camera_low);
+    frame_data.log_depth_coefficient = camera.get_log_depth_coefficient();
+    frame_uniforms.set(0, &frame_data);
+    frame_uniforms.upload(1);
+    frame_uniforms.bind(0);
+
+    // The same data as uniform blocks per draw and as one storage buffer
+    UniformBuffer object_uniforms(OBJECT_UNIFORM_BINDING, sizeof(ObjectUniforms));
+    StorageBuffer draw_objects(DRAW_OBJECT_STORAGE_BINDING);
+    std::vector<ObjectUniforms> objects(patches.size());
+    for (size_t i = 0; i < patches.size(); i++) {
+        objects[i] = {};
+        objects[i].model = glm::mat4(1.0f);
+        split_double(patches[i].center, objects[i].center_high, objects[i].center_low);
+        object_uniforms.set(i, &objects[i]);
+    }
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // glFinish, otherwise only the submission is measured
+    per_patch_program.use();
+    benchmark.run("globe_draw_gl/per_patch", [&]() {
+        object_uniforms.upload(patches.size());
+        for (size_t i = 0; i < patches.size(); i++) {
+            object_uniforms.bind(i);
+            meshes[i]->draw(patches[i].lods[0].first_index, patches[i].lods[0].index_count);
+        }
+        glFinish();
+    }, patches.size());
+
+    multi_draw_program.use();
+    benchmark.run("globe_draw_gl/multi_draw", [&]() {
+        draw_objects.upload(objects.data(), objects.size() * sizeof(ObjectUniforms));
+        for (size_t i = 0; i < patches.size(); i++) {
+            pool.add_draw(slots[i], patches[i].lods[0].first_index, patches[i].lods[0].index_count);
+        }
+        pool.draw();
+        glFinish();
+    }, patches.size());
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+static void bench_markers(Benchmark &benchmark, bool has_gl)
+{
+    static const size_t count = 5000000;
+    // Changed per update in marker_update_gl, like a batch of sensors reporting
+    static const size_t changed = count / 100;
+
+    MarkerLayer markers(Ellipsoid::wgs84());
+    markers.resize(count);
+    srand(1);
+    for (size_t i = 0; i < count; i++) {
+        double lat = std::asin((double) rand() / RAND_MAX * 2.0 - 1.0);
+        double lon = (double) rand() / RAND_MAX * 2.0 * PI;
+        markers.set(i, { lat, lon, 0.0 }, 0xFF0080FF);
+    }
+
+    // Everything is dirty again after the first update, so set it each time
+    benchmark.run("marker_convert/5M", [&]() {
+        markers.set(0, { 0.0, 0.0, 0.0 }, 0xFF0080FF);
+        markers.set(count - 1, { 0.0, 0.0, 0.0 }, 0xFF0080FF);
+        markers.update();
+        do_not_optimize(markers.get_instances().data());
+    }, count);
+
+    if (!has_gl) {
+        return;
+    }
+
+    ProgramCache program_cache(PROGRAM_CACHE_DIR);
+    Program program;
+    if (program_cache.load_program(program, MARKER_VERTEX_SHADER_SRC, MARKER_FRAGMENT_SHADER_SRC, FEATURE_LOG_DEPTH) != LOAD_PROGRAM_SUCCESS) {
+        return;
+    }
+
+    // A typical window, the whole earth in view
+    static const int width = 1280;
+    static const int height = 720;
+    RenderTarget render_target;
+    render_target.bind(width, height);
+    glViewport(0, 0, width, height);
+
+    Camera camera(EARTH_RADIUS, CAMERA_MIN_ALTITUDE, SPACE_RADIUS);
+    camera.set_viewport(width, height);
+    camera.set_depth_mode(DEPTH_LOGARITHMIC);
+    UniformBuffer frame_uniforms(FRAME_UNIFORM_BINDING, sizeof(FrameUniforms));
+    UniformBuffer object_uniforms(OBJECT_UNIFORM_BINDING, sizeof(ObjectUniforms));
+    FrameUniforms frame_data = {};
+    frame_data.view = camera.get_view_rotation();
+    frame_data.proj = camera.get_proj();
+    frame_data.view_proj = frame_data.proj * frame_data.view;
+    split_double(camera.get_position(), frame_data.camera_high, frame_data.camera_low);
+    // The model is the identity
+    split_double(camera.get_position(), frame_data.earth_camera_high, frame_data.earth_camera_low);
+    frame_data.log_depth_coefficient = camera.get_log_depth_coefficient();
+    frame_data.viewport_size = glm::vec2(width, height);
+    ObjectUniforms object_data = {};
+    object_data.model = glm::mat4(1.0f);
+    frame_uniforms.set(0, &frame_data);
+    frame_uniforms.upload(1);
+    frame_uniforms.bind(0);
+    object_uniforms.set(0, &object_data);
+    object_uniforms.upload(1);
+    object_uniforms.bind(0);
+
+    MarkerBuffer buffer;
+    buffer.upload(markers);
+
+    program.use();
+    RenderStateCache render_states;
+    render_states.apply(MarkerBuffer::get_render_state(DEPTH_LOGARITHMIC));
+
+    // glFinish, otherwise only the submission is measured. Items are
+    // markers, ns per op shows whether a frame fits into 16.7 ms.
+    for (float size : { 1.0f, 2.0f, 4.0f }) {
+        glUniform1f(program.get_uniform_location("marker_size"), size);
+        std::string name = "marker_draw_gl/5M_" + std::to_string((int) size) + "px";
+        benchmark.run(name, [&]() {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            buffer.draw();
+            glFinish();
+        }, count);
+    }
+
+    size_t offset = 0;
+    benchmark.run("marker_update_gl/1pct", [&]() {
+        for (size_t i = offset; i < offset + changed; i++) {
+            markers.set(i, { 0.0, (double) i / count * 2.0 * PI, 0.0 }, 0xFF00FF00);
+        }
+        offset = (offset + changed) % count;
+        buffer.upload(markers);
+        glFinish();
+    }, changed);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+static void bench_lines(Benchmark &benchmark)
+{
+    static const size_t lines = 2000;
+    static const size_t points = 500;
+
+    // Random walks of 5 km steps, about as dense as detailed coastlines
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "cge-bench-lines.geojson";
+    // The cameras look down on the start of the first line
+    Geodetic first = {};
+    {
+        std::ofstream out(path);
+        out.precision(8);
+        out << "{\"type\":\"FeatureCollection\",\"features\":[";
+        srand(1);
+        for (size_t line = 0; line < lines; line++) {
+            double lon = (double) rand() / RAND_MAX * 360.0 - 180.0;
+            double lat = (double) rand() / RAND_MAX * 140.0 - 70.0;
+            if (line == 0) {
+                first = { lat * PI / 180.0, lon * PI / 180.0 + GLOBE_LONGITUDE_OFFSET, 0.0 };
+            }
+            out << (line > 0 ? "," : "") << "{\"type\":\"Feature\",\"properties\":{\"id\":" << line
+                << "},\"geometry\":{\"type\":\"LineString\",\"coordinates\":[";
+            for (size_t point = 0; point < points; point++) {
+                lon += ((double) rand() / RAND_MAX - 0.5) * 0.09;
+                lat += ((double) rand() / RAND_MAX - 0.5) * 0.09;
+                out << (point > 0 ? "," : "") << "[" << lon << "," << lat << "]";
+            }
+            out << "]}}";
+        }
+        out << "]}";
+    }
+
+    Terrain terrain;
+    std::unique_ptr<LineLayer> layer;
+    benchmark.run("geojson_parse/1M", [&]() {
+        layer.reset(new LineLayer(Ellipsoid::wgs84(), terrain));
+        layer->load_geojson(path.string());
+        do_not_optimize(layer->get_point_count());
+    }, lines * points);
+    std::filesystem::remove(path);
+
+    // Builds for a camera 10000, 100 and 1 km up, in the globe's model
+    // space, splitting every line again. Items are input points.
+    static const double pixel_scale = 400.0;
+    for (int km : { 10000, 100, 1 }) {
+        glm::dvec3 camera = Ellipsoid::wgs84().to_ecef({ first.lat, first.lon, km * 1000.0 });
+        benchmark.run("line_build/cold_" + std::to_string(km) + "km", [&]() {
+            layer->clear_cache();
+            layer->build(camera, pixel_scale);
+            do_not_optimize(layer->get_vertices().data());
+        }, lines * points);
+    }
+
+    // Between two cached views, only selecting tiers and assembling
+    glm::dvec3 space(SPACE_RADIUS, 0.0, 0.0);
+    glm::dvec3 near = Ellipsoid::wgs84().to_ecef({ first.lat, first.lon, 1000.0 });
+    bool at_near = false;
+    benchmark.run("line_build/cached", [&]() {
+        at_near = !at_near;
+        layer->build(at_near ? near : space, pixel_scale);
+        do_not_optimize(layer->get_vertices().data());
+    }, lines * points);
+}
+
+static void bench_labels(Benchmark &benchmark)
+{
+    static const size_t count = 10000;
+
+    Font font;
+    if (!std::filesystem::exists(FONT_SRC) || font.load(FONT_SRC) != LOAD_FONT_SUCCESS) {
+        std::cerr << "No font at " << FONT_SRC << ", skipping label benchmarks" << std::endl;
+        return;
+    }
+
+    // Items are glyphs of the atlas
+    GlyphAtlas atlas;
+    atlas.build(font);
+    benchmark.run("glyph_atlas_build", [&]() {
+        atlas.build(font);
+        do_not_optimize(atlas.get_image().get_pixels());
+    }, atlas.get_glyph_count());
+
+    LabelLayer labels(Ellipsoid::wgs84(), atlas);
+    srand(1);
+    for (size_t i = 0; i < count; i++) {
+        double lat = std::asin((double) rand() / RAND_MAX * 2.0 - 1.0);
+        double lon = (double) rand() / RAND_MAX * 2.0 * PI;
+        labels.add({ lat, lon, 0.0 }, "Place " + std::to_string(i), (uint32_t) rand() % 8);
+    }
+
+    // The whole earth in a typical window, about half of the labels face
+    // the camera and compete for space. Items are candidate labels.
+    static const int width = 1280;
+    static const int height = 720;
+    Camera camera(EARTH_RADIUS, CAMERA_MIN_ALTITUDE, SPACE_RADIUS);
+    camera.set_viewport(width, height);
+    glm::mat4 view_proj = camera.get_proj() * camera.get_view_rotation();
+    benchmark.run("label_layout/10k", [&]() {
+        labels.layout(view_proj, glm::mat4(1.0f), camera.get_position(), width, height, LABEL_SIZE);
+        do_not_optimize(labels.get_instances().data());
+    }, count);
+}
+
+static void bench_heatmap(Benchmark &benchmark)
+{
+    static const size_t count = 10000000;
+    // Added per update in heatmap_update, like a second of a busy feed
+    static const size_t batch = 1000000;
+
+    std::vector<double> lat(count), lon(count);
+    srand(1);
+    for (size_t i = 0; i < count; i++) {
+        lat[i] = std::asin((double) rand() / RAND_MAX * 2.0 - 1.0);
+        lon[i] = (double) rand() / RAND_MAX * 2.0 * PI - PI;
+    }
+
+    // Cells of the vectorized binning against cell_from_point() of the
+    // ECEF position, off by rounding at most
+    {
+        static const size_t checked = 100000;
+        HeatmapLayer check(Ellipsoid::wgs84());
+        check.add_events(lat.data(), lon.data(), checked);
+        check.update(glm::dvec3(SPACE_RADIUS, 0.0, 0.0), 1.0);
+        const std::vector<uint64_t> &counts = check.get_counts(HEATMAP_MAX_LEVEL);
+        std::vector<int64_t> expected(counts.begin(), counts.end());
+        uint32_t size = HeatmapLayer::level_size(HEATMAP_MAX_LEVEL);
+        for (size_t i = 0; i < checked; i++) {
+            glm::dvec3 position = Ellipsoid::wgs84().to_ecef({ lat[i], lon[i] + GLOBE_LONGITUDE_OFFSET, 0.0 });
+            int face = 0;
+            uint32_t cell_i = 0, cell_j = 0;
+            cell_to_face_ij(cell_parent(cell_from_point(position), HEATMAP_MAX_LEVEL), face, cell_i, cell_j);
+            cell_i >>= CELL_MAX_LEVEL - HEATMAP_MAX_LEVEL;
+            cell_j >>= CELL_MAX_LEVEL - HEATMAP_MAX_LEVEL;
+            expected[((size_t) face * size + cell_j) * size + cell_i]--;
+        }
+        int64_t misplaced = 0;
+        for (int64_t difference : expected) {
+            misplaced += std::abs(difference);
+        }
+        std::cerr << "heatmap: " << misplaced / 2 << " of " << checked << " events in another cell than cell_from_point" << std::endl;
+    }
+
+    // Binning only, items are events
+    HeatmapLayer heatmap(Ellipsoid::wgs84());
+    benchmark.run("heatmap_ingest/10M", [&]() {
+        heatmap.add_events(lat.data(), lon.data(), count);
+        do_not_optimize(heatmap.get_event_count());
+    }, count);
+
+    // Merging, summing the levels and log scaling the shown one for a
+    // camera 10000 km up, items are events
+    glm::dvec3 camera(EARTH_RADIUS + 1.0e7, 0.0, 0.0);
+    heatmap.update(camera, 400.0);
+    benchmark.run("heatmap_update/1M", [&]() {
+        heatmap.add_events(lat.data(), lon.data(), batch);
+        heatmap.update(camera, 400.0);
+        do_not_optimize(heatmap.get_image().data());
+    }, batch);
+}
+
+static void bench_pick(Benchmark &benchmark, std::string dem_dir)
+{
+    static const size_t count = 256;
+    // Over the tile N46E007
+    static const double lat = 46.5 * PI / 180.0;
+    static const double lon = 7.5 * PI / 180.0;
+
+    const Ellipsoid &ellipsoid = Ellipsoid::wgs84();
+    glm::dvec3 up = ellipsoid.normal(lat, lon + GLOBE_LONGITUDE_OFFSET);
+    glm::dvec3 east = glm::normalize(glm::cross(glm::dvec3(0.0, 0.0, 1.0), up));
+    glm::dvec3 north = glm::cross(up, east);
+
+    // Cursor rays of a camera looking straight down over a 90 degree view,
+    // and of one close to the ground looking at the horizon, the worst case
+    // for marching
+    srand(1);
+    glm::dvec3 high = ellipsoid.to_ecef({ lat, lon + GLOBE_LONGITUDE_OFFSET, 20000.0 });
+    glm::dvec3 low = ellipsoid.to_ecef({ lat, lon + GLOBE_LONGITUDE_OFFSET, 4000.0 });
+    std::vector<glm::dvec3> down_rays(count);
+    std::vector<glm::dvec3> horizon_rays(count);
+    for (size_t i = 0; i < count; i++) {
+        double x = (double) rand() / RAND_MAX * 2.0 - 1.0;
+        double y = (double) rand() / RAND_MAX * 2.0 - 1.0;
+        down_rays[i] = glm::normalize(-up + x * east + y * north);
+        double azimuth = (double) rand() / RAND_MAX * 2.0 * PI;
+        double pitch = (double) rand() / RAND_MAX * 10.0 * PI / 180.0;
+        horizon_rays[i] = glm::normalize(-std::sin(pitch) * up
+            + std::cos(pitch) * (std::cos(azimuth) * north + std::sin(azimuth) * east));
+    }
+
+    PickHit hit;
+    Terrain smooth;
+    Picker smooth_picker(ellipsoid, smooth);
+    benchmark.run("pick/smooth", [&]() {
+        for (const glm::dvec3 &direction : down_rays) {
+            smooth_picker.intersect(high, direction, hit);
+            do_not_optimize(hit);
+        }
+    }, count);
+
+    Terrain terrain;
+    if (terrain.load_directory(dem_dir) == 0) {
+        std::cerr << "No DEM tiles in " << dem_dir << ", skipping pick/terrain_*" << std::endl;
+        return;
+    }
+    Picker picker(ellipsoid, terrain);
+    // The height tree is built by the first ray, not measured
+    picker.intersect(high, -up, hit);
+    benchmark.run("pick/terrain_down", [&]() {
+        for (const glm::dvec3 &direction : down_rays) {
+            picker.intersect(high, direction, hit);
+            do_not_optimize(hit);
+        }
+    }, count);
+    benchmark.run("pick/terrain_horizon", [&]() {
+        for (const glm::dvec3 &direction : horizon_rays) {
+            picker.intersect(low, direction, hit);
+            do_not_optimize(hit);
+        }
+    }, count);
+}
+
+static void bench_cell_index(Benchmark &benchmark)
+{
+    static const size_t count = 10000000;
+    static const size_t queries = 64;
+
+    EcefArrays positions;
+    positions.resize(count);
+    srand(1);
+    for (size_t i = 0; i < count; i++) {
+        double lat = std::asin((double) rand() / RAND_MAX * 2.0 - 1.0);
+        double lon = (double) rand() / RAND_MAX * 2.0 * PI;
+        glm::dvec3 p = lat_lon_to_ecef({ lat, lon }, EARTH_RADIUS);
+        positions.x[i] = p.x;
+        positions.y[i] = p.y;
+        positions.z[i] = p.z;
+    }
+
+    CellIndex index;
+    benchmark.run("cell_index_build/10M", [&]() {
+        index.build(positions);
+        do_not_optimize(index.get_cell_ids().data());
+    }, count);
+
+    // Same query centers for every radius, items are queries
+    std::vector<glm::dvec3> centers(queries);
+    for (glm::dvec3 &center : centers) {
+        size_t k = rand() % count;
+        center = glm::dvec3(positions.x[k], positions.y[k], positions.z[k]);
+    }
+    std::vector<uint32_t> result;
+    for (int km : { 10, 100, 1000 }) {
+        benchmark.run("cell_index_query_cap/" + std::to_string(km) + "km", [&]() {
+            for (const glm::dvec3 &center : centers) {
+                result.clear();
+                index.query_radius(center, km * 1000.0, EARTH_RADIUS, result);
+                do_not_optimize(result.data());
+            }
+        }, queries);
+    }
+
+    // The ranges the points in view are in, from a camera 1000 km up
+    glm::dvec3 eye = glm::dvec3(0.0, 0.0, EARTH_RADIUS + 1.0e6);
+    glm::dmat4 view = glm::lookAt(eye, glm::dvec3(0.0), glm::dvec3(0.0, 1.0, 0.0));
+    glm::dmat4 proj = glm::perspective(glm::radians((double) FOV), 16.0 / 9.0, 1.0, 1.0e8);
+    Frustum frustum = Frustum::from_view_proj(proj * view);
+    SphereCap horizon = SphereCap::horizon(eye, EARTH_RADIUS);
+    benchmark.run("cell_index_cover_view", [&]() {
+        std::vector<std::pair<size_t, size_t>> ranges = index.query_ranges(index.cover_view(horizon, frustum, EARTH_RADIUS));
+        do_not_optimize(ranges.data());
+    });
+}
+
+static void bench_geo(Benchmark &benchmark)
+{
+    static const size_t count = 1 << 16;
+
+    std::vector<LatLon> coords(count);
+    std::vector<glm::dvec3> positions(count);
+    srand(1);
+    for (size_t i = 0; i < count; i++) {
+        coords[i].lat = ((double) rand() / RAND_MAX - 0.5) * PI;
+        coords[i].lon = ((double) rand() / RAND_MAX - 0.5) * 2.0 * PI;
+    }
+
+    benchmark.run("lat_lon_to_ecef", [&]() {
+        for (size_t i = 0; i < count; i++) {
+            positions[i] = lat_lon_to_ecef(coords[i], EARTH_RADIUS);
+        }
+        do_not_optimize(positions.data());
+    }, count);
+
+    benchmark.run("ecef_to_lat_lon", [&]() {
+        for (size_t i = 0; i < count; i++) {
+            coords[i] = ecef_to_lat_lon(positions[i]);
+        }
+        do_not_optimize(coords.data());
+    }, count);
+
+    // WGS84 conversions: one point at a time, the SIMD kernel on one
+    // thread, and the SIMD kernel split across the pool
+    const Ellipsoid &ellipsoid = Ellipsoid::wgs84();
+    GeodeticArrays geodetic;
+    EcefArrays ecef;
+    geodetic.resize(count);
+    ecef.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        geodetic.lat[i] = coords[i].lat;
+        geodetic.lon[i] = coords[i].lon;
+        geodetic.height[i] = ((double) rand() / RAND_MAX) * 1.0e5;
+    }
+    ellipsoid.to_ecef(geodetic, ecef);
+
+    benchmark.run("geodetic_to_ecef/scalar", [&]() {
+        for (size_t i = 0; i < count; i++) {
+            glm::dvec3 p = ellipsoid.to_ecef({ geodetic.lat[i], geodetic.lon[i], geodetic.height[i] });
+            ecef.x[i] = p.x;
+            ecef.y[i] = p.y;
+            ecef.z[i] = p.z;
+        }
+        do_not_optimize(ecef.x.data());
+    }, count);
+
+    benchmark.run("geodetic_to_ecef/simd", [&]() {
+        ellipsoid.to_ecef(geodetic.lat.data(), geodetic.lon.data(), geodetic.height.data(),
+            ecef.x.data(), ecef.y.data(), ecef.z.data(), count);
+        do_not_optimize(ecef.x.data());
+    }, count);
+
+    benchmark.run("geodetic_to_ecef/simd_parallel", [&]() {
+        ellipsoid.to_ecef(geodetic, ecef);
+        do_not_optimize(ecef.x.data());
+    }, count);
+
+    GeodeticArrays result;
+    result.resize(count);
+
+    benchmark.run("ecef_to_geodetic/scalar", [&]() {
+        for (size_t i = 0; i < count; i++) {
+            Geodetic g = ellipsoid.to_geodetic(glm::dvec3(ecef.x[i], ecef.y[i], ecef.z[i]));
+            result.lat[i] = g.lat;
+            result.lon[i] = g.lon;
+            result.height[i] = g.height;
+        }
+        do_not_optimize(result.lat.data());
+    }, count);
+
+    benchmark.run("ecef_to_geodetic/simd", [&]() {
+        ellipsoid.to_geodetic(ecef.x.data(), ecef.y.data(), ecef.z.data(),
+            result.lat.data(), result.lon.data(), result.height.data(), count);
+        do_not_optimize(result.lat.data());
+    }, count);
+
+    benchmark.run("ecef_to_geodetic/simd_parallel", [&]() {
+        ellipsoid.to_geodetic(ecef, result);
+        do_not_optimize(result.lat.data());
+    }, count);
+}
+
+static void bench_matrices(Benchmark &benchmark)
+{
+    // The work the update thread does per tick while rotating and zooming
+    glm::mat4 model = glm::mat4(1.0f);
+    float pos_x = 2.0f;
+    benchmark.run("matrix_update", [&]() {
+        model = glm::rotate(model, glm::radians(ROTATION_SPEED), glm::vec3(0.0f, 0.0f, 1.0f));
+        pos_x = pos_x > 10.0f ? 2.0f : pos_x + 0.01f;
+        glm::mat4 view = glm::lookAt(
+            glm::vec3(pos_x, 0.0f, 0.0f),
+            glm::vec3(0.0f, 0.0f, 0.0f),
+            glm::vec3(0.0f, 0.0f, 1.0f)
+        );
+        glm::mat4 proj = glm::perspective(glm::radians(FOV), 1.0f, 0.1f, 1000.0f);
+        glm::mat4 mvp = proj * view * model;
+        do_not_optimize(mvp);
+    });
+}
+
+int main(int argc, char **argv)
+{
+    std::string filter;
+    std::string out_path;
+    std::string img_dir = "img";
+    std::string dem_dir = DEM_DIR;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--filter") == 0) {
+            filter = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--out") == 0) {
+            out_path = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--img") == 0) {
+            img_dir = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--dem") == 0) {
+            dem_dir = argv[i + 1];
+        }
+        else {
+            std::cerr << "Unknown argument " << argv[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cerr << "Using " << ThreadPool::shared().get_thread_count() << " worker threads" << std::endl;
+
+    // Only the GPU mip generation needs a context, skip it on headless machines
+    GLFWwindow *window = nullptr;
+    if (glfwInit()) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        window = glfwCreateWindow(64, 64, "cge-bench", nullptr, nullptr);
+    }
+    if (window != nullptr) {
+        glfwMakeContextCurrent(window);
+        if (!gladLoadGL()) {
+            glfwDestroyWindow(window);
+            window = nullptr;
+        }
+    }
+    if (window == nullptr) {
+        std::cerr << "No OpenGL context, skipping GL benchmarks" << std::endl;
+    }
+
+    Benchmark benchmark(filter);
+    bench_sphere(benchmark);
+    bench_globe(benchmark, dem_dir);
+    bench_pick(benchmark, dem_dir);
+    bench_images(benchmark, img_dir, window != nullptr);
+    if (window != nullptr) {
+        bench_culling(benchmark);
+        bench_patch_pool(benchmark);
+    }
+    bench_geo(benchmark);
+    bench_cell_index(benchmark);
+    bench_markers(benchmark, window != nullptr);
+    bench_lines(benchmark);
+    bench_labels(benchmark);
+    bench_heatmap(benchmark);
+    bench_matrices(benchmark);
+
+    if (window != nullptr) {
+        glfwDestroyWindow(window);
+    }
+    glfwTerminate();
+
+    if (out_path.empty()) {
+        benchmark.write_json(std::cout);
+    }
+    else {
+        std::ofstream out(out_path);
+        if (!out) {
+            std::cerr << "Could not open " << out_path << "!" << std::endl;
+            return EXIT_FAILURE;
+        }
+        benchmark.write_json(out);
+    }
+
+    return EXIT_SUCCESS;
+}
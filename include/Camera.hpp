@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Constants.hpp"
+
+enum depth_mode {
+    // glClipControl with a [0, 1] depth range and a float depth buffer.
+    // Depth is 1 at the near plane and goes to 0 at an infinite far plane,
+    // so the float exponent covers the distant range.
+    DEPTH_REVERSED,
+    // Fallback without glClipControl. The vertex shader replaces depth with
+    // log2(1 + w) scaled to the far plane.
+    DEPTH_LOGARITHMIC
+};
+
+/*
+    Orbit camera on the X axis looking at the origin, the center of the
+    globe. Its altitude is measured from the ground right below it, at
+    surface_radius from the center, which changes as the globe turns. Positions are doubles so the camera stays
+    precise at planetary distances. For rendering, get_view_rotation() is
+    the view with the camera at the origin: positions are made relative to
+    the eye first, see shaders/transforms.glsl.
+    GL-free, the matrices can be used with any backend.
+*/
+class Camera
+{
+private:
+    // Position of camera on X axis
+    double distance;
+    float aspect = 1.0f;
+    depth_mode depth = DEPTH_REVERSED;
+    double surface_radius;
+    double min_altitude;
+    double max_distance;
+
+    glm::dmat4 view_transform;
+    glm::mat4 view_rotation;
+    glm::mat4 proj_transform;
+
+    void update_view();
+    void update_proj();
+public:
+    Camera(double surface_radius, double min_altitude, double max_distance);
+
+    void set_depth_mode(depth_mode mode);
+
+    // Moves the camera out to min_altitude above the new ground if it is
+    // closer. Returns true if it moved.
+    bool set_surface_radius(double radius);
+
+    // Scales the altitude by exp(delta), so zooming feels the same at any
+    // height, down to min_altitude. Returns false and keeps the position if
+    // it would go beyond max_distance or not move.
+    bool zoom(float delta);
+    void set_viewport(int width, int height);
+
+    inline double get_distance() const {
+        return distance;
+    }
+
+    inline double get_altitude() const {
+        return distance - surface_radius;
+    }
+
+    inline glm::dvec3 get_position() const {
+        return glm::dvec3(distance, 0.0, 0.0);
+    }
+
+    inline const glm::dmat4 &get_view() const {
+        return view_transform;
+    }
+
+    inline const glm::mat4 &get_view_rotation() const {
+        return view_rotation;
+    }
+
+    inline const glm::mat4 &get_proj() const {
+        return proj_transform;
+    }
+
+    // Direction in world space from get_position() through a point of the
+    // viewport, x and y in normalized device coordinates. The same for
+    // both depth modes.
+    glm::dvec3 get_ray_direction(double x, double y) const;
+
+    // Scale of log2(1 + w) for DEPTH_LOGARITHMIC, see shaders/transforms.glsl
+    inline float get_log_depth_coefficient() const {
+        return (float) (2.0 / std::log2(2.0 * max_distance + 1.0));
+    }
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Constants.hpp"
+#include "Ellipsoid.hpp"
+#include "Profiler.hpp"
+#include "SphereCell.hpp"
+#include "ThreadPool.hpp"
+
+// Planes of a view frustum with the normals pointing inside, as
+// (normal, distance) with normalized normals
+struct Frustum
+{
+    glm::dvec4 planes[6];
+
+    // Gribb and Hartmann. With an infinite far plane that plane is
+    // degenerate and lets everything through.
+    static Frustum from_view_proj(const glm::dmat4 &view_proj);
+
+    inline bool intersects_sphere(const glm::dvec3 &center, double radius) const {
+        for (const glm::dvec4 &plane : planes) {
+            if (glm::dot(glm::dvec3(plane), center) + plane.w < -radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    inline bool contains_sphere(const glm::dvec3 &center, double radius) const {
+        for (const glm::dvec4 &plane : planes) {
+            if (glm::dot(glm::dvec3(plane), center) + plane.w < radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/*
+    Spatial index of points on a sphere by the SphereCell of their
+    direction. The points are sorted by leaf cell id, so every cell covers
+    a contiguous range of them and a region of the sphere becomes a short
+    list of ranges: cover it with cells, then binary search each cell's id
+    range. Radius, horizon and frustum queries all work like that.
+
+    Bulk loading computes the cell ids and sorts in parallel on the thread
+    pool. Only ids and the original point indices are stored, 12 bytes per
+    point; leaf cells are about a centimeter on the earth, so exact tests
+    use the leaf's center instead of the original position. GL-free.
+*/
+class CellIndex
+{
+private:
+    std::vector<uint64_t> cell_ids;
+    // Index of the point in the arrays given to build()
+    std::vector<uint32_t> point_indices;
+
+    // Breadth first from the faces down to max_level. classify returns 0
+    // for cells outside the region, 1 for cells partially inside and 2 for
+    // cells completely inside.
+    template<typename F>
+    std::vector<uint64_t> cover(int max_level, F classify) const;
+public:
+    CellIndex() = default;
+
+    // Any positions relative to the center of the sphere, e.g. ECEF
+    void build(const double *x, const double *y, const double *z, size_t count, ThreadPool &pool = ThreadPool::shared());
+    void build(const EcefArrays &positions, ThreadPool &pool = ThreadPool::shared());
+
+    inline size_t size() const {
+        return cell_ids.size();
+    }
+
+    inline const std::vector<uint64_t> &get_cell_ids() const {
+        return cell_ids;
+    }
+
+    inline const std::vector<uint32_t> &get_point_indices() const {
+        return point_indices;
+    }
+
+    // Cells covering a cap, down to max_level, -1 picks the level from the
+    // size of the cap. Sorted and without cells inside other cells.
+    std::vector<uint64_t> cover_cap(const SphereCap &cap, int max_level = -1) const;
+    // Cells covering the part of a sphere of radius that is within the
+    // horizon cap and the frustum, both relative to the center of the sphere
+    std::vector<uint64_t> cover_view(const SphereCap &horizon, const Frustum &frustum, double radius, int max_level = -1) const;
+
+    // Ranges [begin, end) into get_cell_ids() and get_point_indices() of
+    // the points inside the cells, merged where they touch
+    std::vector<std::pair<size_t, size_t>> query_ranges(const std::vector<uint64_t> &cells) const;
+    // Appends the indices of every point inside the cap
+    void query_cap(const SphereCap &cap, std::vector<uint32_t> &out) const;
+    // Same for a great circle distance in meters on a sphere of sphere_radius
+    void query_radius(const glm::dvec3 &center, double distance, double sphere_radius, std::vector<uint32_t> &out) const;
+};
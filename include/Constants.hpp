@@ -1,9 +1,55 @@
 #pragma once
 
+#include <cstddef>
+#include <string>
+
 #define DEBUG 0
 
+static const double PI = 3.14159265358979323846264338327950288;
+
 static const std::string EARTH_TEXTURE_SRC = "img/earth_4096.jpg";
 static const std::string SPACE_TEXTURE_SRC = "img/space.jpg";
+// SRTM .hgt elevation tiles, e.g. N46E007.hgt, the globe is smooth without
+static const std::string DEM_DIR = "dem";
+// Points shown as markers, lines of lat,lon[,height[,rrggbb]], optional
+static const std::string MARKERS_SRC = "data/markers.csv";
+// Width of a marker in pixels, smaller is cheaper with millions of them
+static const float MARKER_SIZE = 4.0f;
+// Lines drawn over the globe, the line geometry of GeoJSON files, optional
+static const std::string COASTLINES_SRC = "data/coastlines.geojson";
+static const std::string BORDERS_SRC = "data/borders.geojson";
+// Width of lines in pixels, they are anti-aliased over one more pixel
+static const float LINE_WIDTH = 1.5f;
+// Files are parsed in chunks of this many bytes
+static const size_t JSON_READ_CHUNK = 1 << 16;
+// Place names, lines of lat,lon,rank,name in degrees, lower ranks win
+// where labels overlap. Drawn with the TrueType font, both optional.
+static const std::string LABELS_SRC = "data/labels.csv";
+static const std::string FONT_SRC = "data/font.ttf";
+// Height of an em of label text in pixels, and of its dark halo
+static const float LABEL_SIZE = 14.0f;
+static const float LABEL_HALO = 1.5f;
+// Cells of the grid labels are tested for overlap in, and the gap kept
+// around each label, in pixels
+static const int LABEL_GRID_CELL = 32;
+static const float LABEL_PADDING = 2.0f;
+// Glyph distance fields have this many texels per em and reach this many
+// texels beyond the outline, in an atlas this wide
+static const int GLYPH_SDF_EM = 32;
+static const int GLYPH_SDF_SPREAD = 6;
+static const int GLYPH_ATLAS_WIDTH = 512;
+// Events shown as a density heatmap over the globe, lines of lat,lon in
+// degrees, optional
+static const std::string HEATMAP_SRC = "data/events.csv";
+// Finest level of heatmap cells, 6 * 4^level of them, see SphereCell.
+// Level 8 cells are about 40 km across.
+static const int HEATMAP_MAX_LEVEL = 8;
+// The finest level whose cells are at least this many pixels across is shown
+static const double HEATMAP_CELL_PIXELS = 4.0;
+// Batches of fewer events are binned on the calling thread
+static const size_t HEATMAP_INGEST_GRAIN = 1 << 16;
+// Cube map faces of the skybox, converted from the space texture on load
+static const int SKYBOX_FACE_SIZE = 1024;
 
 static const float FOV = 90.0f;
 
@@ -12,5 +58,91 @@ static const float ROTATION_SPEED = 5.0f;
 // The LOWER the FASTER
 static const float SCROLL_SPEED = 5.0f;
 
-static const float EARTH_RADIUS = 1.0f;
-static const float SPACE_RADIUS = 100.0f;
+// Linked shader programs are stored here, safe to delete
+static const std::string PROGRAM_CACHE_DIR = "cache";
+// Generated glyph atlases, also safe to delete
+static const std::string GLYPH_CACHE_DIR = "cache";
+
+// Shaders are reloaded when files in here change
+static const std::string SHADER_DIR = "shaders";
+static const std::string VERTEX_SHADER_SRC = "shaders/vertex_shader.vert";
+static const std::string FRAGMENT_SHADER_SRC = "shaders/fragment_shader.frag";
+static const std::string SKYBOX_VERTEX_SHADER_SRC = "shaders/skybox.vert";
+static const std::string SKYBOX_FRAGMENT_SHADER_SRC = "shaders/skybox.frag";
+static const std::string MARKER_VERTEX_SHADER_SRC = "shaders/marker.vert";
+static const std::string MARKER_FRAGMENT_SHADER_SRC = "shaders/marker.frag";
+static const std::string LINE_VERTEX_SHADER_SRC = "shaders/line.vert";
+static const std::string LINE_FRAGMENT_SHADER_SRC = "shaders/line.frag";
+static const std::string LABEL_VERTEX_SHADER_SRC = "shaders/label.vert";
+static const std::string LABEL_FRAGMENT_SHADER_SRC = "shaders/label.frag";
+// Stop check interval of the file watcher, also the polling interval without inotify
+static const int FILE_WATCHER_POLL_MS = 250;
+
+// Period of the update thread
+static const int SIMULATION_TICK_MS = 16;
+
+// Frames in flight the GPU profiler keeps queries for, i.e. result latency
+static const size_t GPU_PROFILER_LATENCY = 4;
+static const size_t GPU_PROFILER_MAX_SCOPES = 16;
+static const size_t GPU_PROFILER_AVERAGE_SAMPLES = 60;
+static const double GPU_PROFILER_BUDGET_MS = 1000.0 / 60.0;
+
+// Per thread ring buffer size of the CPU profiler, older zones are overwritten
+static const size_t PROFILER_EVENTS_PER_THREAD = 1 << 16;
+
+// WGS84 reference ellipsoid
+static const double WGS84_SEMI_MAJOR_AXIS = 6378137.0;
+static const double WGS84_INVERSE_FLATTENING = 298.257223563;
+
+// World units are meters, positions are doubles until they are made
+// relative to the eye. Equatorial radius.
+static const double EARTH_RADIUS = WGS84_SEMI_MAJOR_AXIS;
+// Geodetic conversions in batches of this many points per task
+static const size_t GEODETIC_BATCH_GRAIN = 4096;
+// Farthest the camera can zoom out
+static const double SPACE_RADIUS = 100.0 * EARTH_RADIUS;
+// Closest the camera can get to the surface
+static const double CAMERA_MIN_ALTITUDE = 20.0;
+// Near plane in meters. The depth modes keep their precision over the
+// whole range from here to beyond SPACE_RADIUS.
+static const float CAMERA_NEAR = 0.1f;
+
+// The earth is split into rows x columns patches of resolution x resolution
+// quads, each with its vertices relative to its own center. Powers of two
+// give the most levels of detail.
+static const unsigned GLOBE_PATCH_ROWS = 8;
+static const unsigned GLOBE_PATCH_COLUMNS = 16;
+#if DEBUG
+static const unsigned GLOBE_PATCH_RESOLUTION = 2;
+#else
+static const unsigned GLOBE_PATCH_RESOLUTION = 64;
+#endif
+// Patches use the coarsest level that is off by at most this many pixels
+static const double GLOBE_LOD_PIXEL_ERROR = 2.0;
+// Fraction of the distance range of a level after which it starts to
+// morph into the next coarser one
+static const double GLOBE_LOD_MORPH_START = 0.5;
+// The earth texture starts at 180 degrees west and the earth model is
+// turned around by that, so model longitudes are half a turn ahead of
+// geographic ones
+static const double GLOBE_LONGITUDE_OFFSET = PI;
+
+// Great circle segments of lines are split into pieces that are off by at
+// most this many pixels. Lines pick one of a few tiers of piece length,
+// from the maximum angle in radians down by the step per tier.
+static const double LINE_PIXEL_ERROR = 0.5;
+static const double LINE_MAX_SEGMENT_ANGLE = 1.0 / 8.0;
+static const unsigned LINE_TIER_COUNT = 5;
+static const double LINE_TIER_STEP = 4.0;
+// Line vertices are floats relative to the origin of their chunk, at most
+// this many meters away, so they are off by less than a centimeter
+static const double LINE_CHUNK_RADIUS = 100000.0;
+
+// No terrain is higher or lower, in meters above the ellipsoid
+static const double TERRAIN_MAX_HEIGHT = 9000.0;
+static const double TERRAIN_MIN_HEIGHT = -500.0;
+// Leaves of the min/max height tree of a DEM tile are blocks of this many
+// sample intervals
+static const int TERRAIN_TREE_LEAF = 8;
+// Shortest step of the picking ray march in meters, half an SRTM1 sample
+static const double PICK_MIN_STEP = 15.0;
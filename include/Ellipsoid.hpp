@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Constants.hpp"
+#include "Profiler.hpp"
+#include "SimdMath.hpp"
+#include "ThreadPool.hpp"
+
+// Angles in radians, height in meters above the ellipsoid
+struct Geodetic
+{
+    double lat;
+    double lon;
+    double height;
+};
+
+// Structure of arrays, so batches can be converted with SIMD
+struct GeodeticArrays
+{
+    std::vector<double> lat;
+    std::vector<double> lon;
+    std::vector<double> height;
+
+    inline void resize(size_t count) {
+        lat.resize(count);
+        lon.resize(count);
+        height.resize(count);
+    }
+
+    inline size_t size() const {
+        return lat.size();
+    }
+};
+
+struct EcefArrays
+{
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+
+    inline void resize(size_t count) {
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+    }
+
+    inline size_t size() const {
+        return x.size();
+    }
+};
+
+/*
+    Oblate ellipsoid of revolution around Z, like WGS84. Converts between
+    geodetic coordinates and earth-centered, earth-fixed (ECEF) positions.
+    Longitude 0 lies on the positive X axis, like Sphere and Geo.hpp.
+
+    The single point functions use libm as a reference. The batched ones
+    work on structures of arrays with the branch-free kernels of
+    SimdMath.hpp, vectorized across points. ECEF to geodetic iterates
+    Bowring's formula GEODETIC_ITERATIONS times. That is accurate to well
+    below a millimeter from the center of the earth to beyond geostationary
+    orbit, except within meters of the center itself.
+*/
+class Ellipsoid
+{
+private:
+    static const int GEODETIC_ITERATIONS = 2;
+
+    double semi_major;
+    double semi_minor;
+    // First and second eccentricity squared
+    double e2;
+    double ep2;
+public:
+    Ellipsoid(double semi_major, double inverse_flattening);
+
+    static const Ellipsoid &wgs84();
+
+    inline double get_semi_major() const {
+        return semi_major;
+    }
+
+    inline double get_semi_minor() const {
+        return semi_minor;
+    }
+
+    glm::dvec3 to_ecef(Geodetic geodetic) const;
+    Geodetic to_geodetic(glm::dvec3 ecef) const;
+
+    // Outward normal of the surface at a geodetic position
+    glm::dvec3 normal(double lat, double lon) const;
+    // Position at height above the surface point with that normal. Like
+    // to_ecef, but without trigonometry.
+    glm::dvec3 from_normal(const glm::dvec3 &normal, double height) const;
+
+    // Batched kernels on count points, the arrays must not overlap
+    void to_ecef(const double *lat, const double *lon, const double *height,
+        double *x, double *y, double *z, size_t count) const;
+    void to_geodetic(const double *x, const double *y, const double *z,
+        double *lat, double *lon, double *height, size_t count) const;
+
+    // Resize out and convert in chunks of GEODETIC_BATCH_GRAIN on the pool
+    void to_ecef(const GeodeticArrays &in, EcefArrays &out, ThreadPool &pool = ThreadPool::shared()) const;
+    void to_geodetic(const EcefArrays &in, GeodeticArrays &out, ThreadPool &pool = ThreadPool::shared()) const;
+};
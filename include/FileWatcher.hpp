@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Constants.hpp"
+#include "Profiler.hpp"
+
+/*
+    Watches the files of one directory (not recursive) on a background
+    thread and collects the paths of changed files until they are taken.
+    Uses inotify on Linux and falls back to polling modification times
+    every FILE_WATCHER_POLL_MS elsewhere. GL-free.
+*/
+class FileWatcher
+{
+private:
+    std::string directory;
+    // Called on the watcher thread after a change, e.g. to wake up the render thread
+    void (*notify)() = nullptr;
+
+    std::thread thread;
+    std::atomic<bool> running{ false };
+
+    std::mutex mutex;
+    std::vector<std::string> changes;
+
+    void add_change(std::string path);
+#if defined(__linux__)
+    void run_inotify();
+#endif
+    void run_polling();
+public:
+    FileWatcher(std::string directory, void (*notify)());
+    ~FileWatcher();
+
+    void start();
+    void stop();
+
+    // Paths of files changed since the last call, each at most once
+    std::vector<std::string> take_changes();
+};
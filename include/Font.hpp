@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "MappedFile.hpp"
+#include "Profiler.hpp"
+
+static const int LOAD_FONT_SUCCESS = 0;
+static const int LOAD_FONT_FAILURE = 1;
+
+// Closed contours of straight segments in em units, y up from the baseline
+struct GlyphOutline
+{
+    std::vector<glm::vec2> points;
+    // One past the last point of every contour, which joins its first
+    std::vector<uint32_t> contour_ends;
+    float advance = 0.0f;
+};
+
+/*
+    Glyph outlines of a TrueType font (.ttf with glyf outlines, no
+    hinting). Only the cmap, head, hhea, hmtx, maxp, loca and glyf tables
+    are read, straight from the memory mapped file. Quadratic curves are
+    flattened to segments within a given tolerance, which is all a distance
+    field needs.
+*/
+class Font
+{
+private:
+    MappedFile file;
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+    uint32_t cmap = 0;
+    uint32_t loca = 0;
+    uint32_t glyf = 0;
+    uint32_t glyf_size = 0;
+    uint32_t hmtx = 0;
+    uint16_t glyph_count = 0;
+    uint16_t h_metric_count = 0;
+    uint16_t units_per_em = 0;
+    bool long_loca = false;
+    float ascent = 0.0f;
+    float descent = 0.0f;
+
+    // Big-endian reads that return 0 past the end instead of reading it
+    uint16_t u16(size_t offset) const;
+    uint32_t u32(size_t offset) const;
+    inline int16_t i16(size_t offset) const {
+        return (int16_t) u16(offset);
+    }
+
+    uint32_t find_table(const char *tag) const;
+    bool glyph_range(uint16_t glyph, uint32_t &begin, uint32_t &end) const;
+    // Appends the glyph transformed by m, composite glyphs recurse
+    bool append_outline(uint16_t glyph, const glm::mat3 &m, float tolerance, GlyphOutline &outline, int depth) const;
+public:
+    int load(std::string path);
+
+    // 0, the missing glyph, if the font has none for it
+    uint16_t glyph_index(uint32_t codepoint) const;
+    // Curves are off the segments by at most tolerance em
+    bool outline(uint16_t glyph, float tolerance, GlyphOutline &outline) const;
+
+    // Above and below the baseline in em, descent is negative
+    inline float get_ascent() const {
+        return ascent;
+    }
+
+    inline float get_descent() const {
+        return descent;
+    }
+};
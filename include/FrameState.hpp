@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Constants.hpp"
+#include "Ellipsoid.hpp"
+
+enum scene_object {
+    EARTH,
+    SPACE,
+    MARKERS,
+    LINES,
+    LABELS
+};
+
+// Passes are drawn in this order
+enum render_pass {
+    PASS_OPAQUE,
+    // Layers on the globe, after it so markers behind it are rejected
+    // before they are shaded
+    PASS_OVERLAY,
+    // After all opaque geometry, so the depth test rejects covered pixels
+    PASS_SKY,
+    // 2D in window pixels on top of everything, without depth
+    PASS_SCREEN
+};
+
+/*
+    Sorting draw items by this key orders them by pass, then front to back
+    within a pass so early depth testing rejects as many fragments as
+    possible, then by object to group program and texture changes.
+    depth is the distance to the nearest point of the object, >= 0.
+*/
+inline uint64_t make_sort_key(render_pass pass, float depth, scene_object object)
+{
+    // The bits of non-negative floats sort like the values
+    uint32_t depth_bits = 0;
+    std::memcpy(&depth_bits, &depth, sizeof(depth_bits));
+    return ((uint64_t) pass << 56) | ((uint64_t) depth_bits << 24) | ((uint64_t) object & 0xFFFFFF);
+}
+
+struct DrawItem
+{
+    scene_object object;
+    render_pass pass;
+    uint64_t sort_key;
+    // Which globe patch, its level of detail and how far that is morphed
+    // into the next coarser level, for EARTH
+    uint32_t patch;
+    uint32_t lod;
+    float morph;
+    // Orientation and scale, the translation is in center
+    glm::mat4 model;
+    // World position of the mesh origin in meters. Kept in double until it
+    // is made relative to the eye in the vertex shader.
+    glm::dvec3 center;
+};
+
+/*
+    Everything the render thread needs to draw one frame. Produced by the
+    Simulation on the update thread and handed over through a TripleBuffer,
+    after which it is treated as immutable.
+*/
+struct FrameState
+{
+    uint64_t frame = 0;
+
+    int viewport_width = 0;
+    int viewport_height = 0;
+
+    // Rotation only, for positions relative to the eye
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 proj = glm::mat4(1.0f);
+    glm::mat4 view_proj = glm::mat4(1.0f);
+    glm::dvec3 camera_position = glm::dvec3(0.0);
+    float log_depth_coefficient = 0.0f;
+    // Seconds since the simulation started
+    float time = 0.0f;
+    // What the cursor points at, if it is on the globe
+    bool cursor_on_globe = false;
+    Geodetic cursor_position = {};
+    // For layers on the globe that pick their own level of detail: the
+    // camera in the globe's model space, and pixels per radian of the view
+    glm::dvec3 earth_camera_position = glm::dvec3(0.0);
+    double pixel_scale = 1.0;
+
+    // Objects that survived culling, sorted by sort_key
+    std::vector<DrawItem> visible;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+/*
+    Conversions between geographic coordinates and earth-centered,
+    earth-fixed (ECEF) cartesian coordinates on a sphere.
+    Angles are in radians. Follows the Sphere parameterization: Z points to
+    the north pole, longitude 0 lies on the positive X axis.
+*/
+
+struct LatLon
+{
+    double lat;
+    double lon;
+};
+
+inline glm::dvec3 lat_lon_to_ecef(LatLon coords, double radius)
+{
+    double cos_lat = std::cos(coords.lat);
+    return glm::dvec3(
+        radius * cos_lat * std::cos(coords.lon),
+        radius * cos_lat * std::sin(coords.lon),
+        radius * std::sin(coords.lat)
+    );
+}
+
+inline LatLon ecef_to_lat_lon(glm::dvec3 position)
+{
+    double xy = std::sqrt(position.x * position.x + position.y * position.y);
+    return {
+        std::atan2(position.z, xy),
+        std::atan2(position.y, position.x)
+    };
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "JsonReader.hpp"
+#include "Profiler.hpp"
+
+/*
+    Reads the line geometry of a GeoJSON file: LineStrings, the parts of
+    MultiLineStrings and the rings of Polygons and MultiPolygons, at any
+    nesting of features, feature collections and geometry collections.
+    One pass with a JsonReader, no document is built: only the coordinates
+    of the geometry being read are buffered, since its type may come after
+    them. Points and properties are skipped.
+
+    on_line gets each line as longitude, latitude pairs in degrees.
+    Returns PARSE_JSON_SUCCESS or PARSE_JSON_FAILURE.
+*/
+int read_geojson_lines(std::string path, const std::function<void(const double *lon_lat, size_t count)> &on_line);
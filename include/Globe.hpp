@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Constants.hpp"
+#include "Ellipsoid.hpp"
+#include "Profiler.hpp"
+#include "Terrain.hpp"
+#include "ThreadPool.hpp"
+
+// One level of detail of a patch, a range of its indices
+struct PatchLod
+{
+    uint32_t first_index;
+    uint32_t index_count;
+    // Upper bound of the distance to the full resolution surface in meters
+    double error;
+};
+
+/*
+    One rectangle of latitude and longitude of the globe. Vertices are
+    floats relative to center, which keeps them precise even though the
+    globe itself is millions of meters across.
+
+    Level of detail L draws every 2^L-th row and column of the same
+    vertices. Vertices that disappear in level L + 1 carry the offset to
+    where L + 1 interpolates them, and the vertex shader morphs them there
+    before the switch, so levels change without popping. Every level is
+    surrounded by a skirt hanging down from its border, which covers the
+    cracks towards neighbours at other levels.
+*/
+struct GlobePatch
+{
+    // ECEF in meters
+    glm::dvec3 center;
+    // Largest distance of a vertex from center
+    double bounding_radius = 0.0;
+    // The grid first, row by row, then the skirt
+    std::vector<float> vertices;
+    // Into an equirectangular texture of the whole globe
+    std::vector<float> texcoords;
+    // 4 floats per vertex, the offset to the morph target and the level
+    // in which the vertex morphs, -1 if it is in every level
+    std::vector<float> morphs;
+    // Counter-clockwise seen from outside, all levels after each other
+    std::vector<uint32_t> indices;
+    // Finest first
+    std::vector<PatchLod> lods;
+    // Terrain height of every vertex, quantized between min_height and
+    // max_height in meters. The vertices are displaced by these.
+    std::vector<uint16_t> heights;
+    double min_height = 0.0;
+    double max_height = 0.0;
+    // Smallest distance of the triangles from the center of the earth,
+    // below the vertices because the triangles cut through the curve
+    double min_radius = 0.0;
+
+    inline double get_height(size_t vertex) const {
+        return min_height + heights[vertex] * (max_height - min_height) / 65535.0;
+    }
+};
+
+// What the update thread needs of a patch for sorting and culling
+struct PatchBounds
+{
+    glm::dvec3 center;
+    double radius;
+    double min_height;
+    double max_height;
+    double min_radius;
+    // Of every level, finest first
+    std::vector<double> lod_errors;
+};
+
+/*
+    Ellipsoid surface split into rows x columns patches of geodetic
+    latitude and longitude, row 0 at the north pole and column 0 starting
+    at longitude 0. Terrain is resampled to the vertices of every patch and
+    displaces them along the ellipsoid normal. Positions are computed in
+    double precision with the batched conversion, patches are generated in
+    parallel. GL-free, use a PatchPool to upload and draw all patches.
+*/
+class Globe
+{
+private:
+    const Ellipsoid &ellipsoid;
+    const Terrain &terrain;
+    uint32_t rows;
+    uint32_t columns;
+    uint32_t resolution;
+    // One more than the times resolution can be halved, so a power of two
+    // gives the most
+    uint32_t levels;
+    std::vector<GlobePatch> patches;
+
+    void generate_patch(uint32_t row, uint32_t column, GlobePatch &patch) const;
+    // Appends the triangles of one level of detail with its skirt
+    void generate_lod(uint32_t level, const EcefArrays &ecef, const std::vector<uint32_t> &border, GlobePatch &patch) const;
+public:
+    // The ellipsoid and the terrain have to outlive the globe
+    Globe(const Ellipsoid &ellipsoid, const Terrain &terrain, uint32_t rows, uint32_t columns, uint32_t resolution,
+        ThreadPool &pool = ThreadPool::shared());
+
+    inline const Ellipsoid &get_ellipsoid() const {
+        return ellipsoid;
+    }
+
+    inline uint32_t get_levels() const {
+        return levels;
+    }
+
+    // Row major
+    inline const std::vector<GlobePatch> &get_patches() const {
+        return patches;
+    }
+
+    std::vector<PatchBounds> get_bounds() const;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Constants.hpp"
+#include "Font.hpp"
+#include "Hash.hpp"
+#include "Image.hpp"
+#include "Profiler.hpp"
+#include "ThreadPool.hpp"
+
+static const int LOAD_ATLAS_SUCCESS = 0;
+static const int LOAD_ATLAS_FAILURE = 1;
+
+// Where a glyph is in the atlas and where its quad goes
+struct GlyphMetrics
+{
+    // Quad in em relative to the pen on the baseline, y up
+    float x0;
+    float y0;
+    float x1;
+    float y1;
+    float advance;
+    // Texels of the atlas, the bottom row of the quad at v0
+    uint16_t u0;
+    uint16_t v0;
+    uint16_t u1;
+    uint16_t v1;
+};
+
+/*
+    Signed distance fields of the glyphs of a font in one single channel
+    image, GLYPH_SDF_EM texels per em. Texels hold 0.5 on the outline,
+    rising to 1 GLYPH_SDF_SPREAD texels inside and falling to 0 as far
+    outside, so text renders sharp at any size with a halo for free.
+    Distances are exact to the flattened outlines, computed for the
+    glyphs in parallel. Covers printable ASCII and Latin-1, anything else
+    shows as the replacement glyph.
+    GL-free, a LabelBuffer uploads it.
+*/
+class GlyphAtlas
+{
+private:
+    Image image;
+    std::vector<GlyphMetrics> glyphs;
+    float ascent = 0.0f;
+    float descent = 0.0f;
+
+    // Index into glyphs of every covered codepoint
+    static int glyph_slot(uint32_t codepoint);
+    static std::string cache_path(std::string directory, uint64_t hash);
+    bool read_cache(std::string path, uint64_t hash);
+    void write_cache(std::string path, uint64_t hash) const;
+public:
+    // Builds the atlas of a TrueType font
+    int build(const Font &font, ThreadPool &pool = ThreadPool::shared());
+    // Reads the atlas of the font from the cache directory, or builds and
+    // stores it there. Entries are keyed by the font file and parameters.
+    int load(std::string font_path, std::string cache_directory);
+
+    // Of '?' if the codepoint is not covered
+    const GlyphMetrics &get_glyph(uint32_t codepoint) const;
+
+    inline size_t get_glyph_count() const {
+        return glyphs.size();
+    }
+
+    inline const Image &get_image() const {
+        return image;
+    }
+
+    inline float get_ascent() const {
+        return ascent;
+    }
+
+    inline float get_descent() const {
+        return descent;
+    }
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "Constants.hpp"
+
+static const int OPEN_PROFILER_LOG_SUCCESS = 0;
+static const int OPEN_PROFILER_LOG_FAILURE = 1;
+
+/*
+    Measures GPU time per render pass with GL_TIMESTAMP queries.
+    Queries are kept in a ring of GPU_PROFILER_LATENCY frames and only read
+    back once GL_QUERY_RESULT_AVAILABLE is set, so profiling never stalls
+    the pipeline. Results lag behind by a few frames.
+*/
+class GpuProfiler
+{
+private:
+    struct Pass
+    {
+        std::string name;
+        // Ring of the last GPU_PROFILER_AVERAGE_SAMPLES results in ms
+        std::vector<double> samples;
+        size_t next_sample = 0;
+        // Samples of the ring written so far, at most all of them
+        size_t filled = 0;
+        double sum = 0.0;
+        double last = 0.0;
+    };
+
+    struct Scope
+    {
+        size_t pass;
+        GLuint begin_query;
+        GLuint end_query;
+    };
+
+    struct FrameQueries
+    {
+        uint64_t frame = 0;
+        bool pending = false;
+        // Two per scope, plus two for the whole frame
+        GLuint queries[2 * (GPU_PROFILER_MAX_SCOPES + 1)] = {};
+        std::vector<Scope> scopes;
+    };
+
+    std::vector<Pass> passes;
+    FrameQueries frames[GPU_PROFILER_LATENCY];
+    uint64_t frame = 0;
+    // Index into frames
+    size_t current = 0;
+    // Index into passes of the scope opened by begin()
+    size_t open_pass = 0;
+    bool scope_open = false;
+
+    std::ofstream log;
+
+    size_t find_pass(const char *name);
+    void collect(FrameQueries &queries);
+    void add_sample(Pass &pass, double ms);
+    // Of the samples so far, 0 before the first
+    static double average(const Pass &pass);
+public:
+    GpuProfiler();
+    ~GpuProfiler();
+
+    // Appends one JSON object per resolved frame, e.g.
+    // {"frame":12,"clear":0.0213,"opaque":0.1847,"sky":0.0412}
+    int open_log(std::string path);
+
+    void begin_frame();
+    void end_frame();
+
+    // Scopes must not be nested
+    void begin(const char *pass);
+    void end();
+
+    // Rolling average over the last GPU_PROFILER_AVERAGE_SAMPLES frames, or
+    // the ones so far
+    double get_average_ms(const char *pass) const;
+    std::string summary() const;
+
+    // Draws one bar per pass at the top of the viewport, where the full width
+    // equals a frame budget of GPU_PROFILER_BUDGET_MS. Uses scissored clears
+    // only, so it needs no shader and does not touch any bound state.
+    void draw_overlay(int width, int height) const;
+};
+
+// Brackets a pass for the lifetime of the object
+class GpuScope
+{
+private:
+    GpuProfiler &profiler;
+public:
+    GpuScope(GpuProfiler &profiler, const char *pass) : profiler(profiler) {
+        profiler.begin(pass);
+    }
+    ~GpuScope() {
+        profiler.end();
+    }
+};
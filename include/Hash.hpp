@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+static const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+static const uint64_t FNV_PRIME = 0x100000001b3ull;
+
+// 64 bit FNV-1a, pass the previous result as seed to hash several buffers
+inline uint64_t fnv1a(const void *data, size_t size, uint64_t seed = FNV_OFFSET_BASIS)
+{
+    const uint8_t *bytes = (const uint8_t*) data;
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+inline uint64_t fnv1a(const std::string &text, uint64_t seed = FNV_OFFSET_BASIS)
+{
+    return fnv1a(text.data(), text.size(), seed);
+}
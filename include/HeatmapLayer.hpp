@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Constants.hpp"
+#include "Ellipsoid.hpp"
+#include "Profiler.hpp"
+#include "SimdMath.hpp"
+#include "SphereCell.hpp"
+#include "ThreadPool.hpp"
+
+static const int LOAD_EVENTS_SUCCESS = 0;
+static const int LOAD_EVENTS_FAILURE = 1;
+
+/*
+    Density of events on the globe, counted in the cells of SphereCell
+    levels 0 to HEATMAP_MAX_LEVEL. Cells are indexed by face and (i, j)
+    instead of along the Hilbert curve, so every level is a stack of six
+    square images.
+
+    add_events() splits a batch into one slice per worker thread and every
+    slice counts into its own histogram of the finest level, so binning
+    takes no locks and no atomics. update() merges the histograms into the
+    totals in parallel, each task owning a range of cells, and only visits
+    the blocks of cells a histogram touched. Coarser levels are the sums of
+    their children.
+    The level shown follows the view, its densities are log scaled into 16
+    bit texels for a HeatmapTexture. GL-free. add_events() and update() must
+    not run at the same time.
+*/
+class HeatmapLayer
+{
+private:
+    struct Histogram
+    {
+        std::vector<uint32_t> counts;
+        // Per block of cells, whether a count in it is set
+        std::vector<uint8_t> touched;
+        bool empty = true;
+    };
+
+    ThreadPool &pool;
+    // z of the direction to a surface point over that of the normal at the
+    // same latitude, (b / a)^2
+    double polar_scale;
+    std::vector<Histogram> histograms;
+    // Per level, the count of cell (face, i, j) at (face * size + j) * size + i
+    std::vector<uint64_t> levels[HEATMAP_MAX_LEVEL + 1];
+    uint64_t event_count = 0;
+    int active_level = -1;
+    std::vector<uint16_t> image;
+
+    void bin(const double *lat, const double *lon, size_t count, Histogram &histogram) const;
+    // False if there was nothing to merge
+    bool merge();
+    void build_image();
+public:
+    // Events are binned by the direction of their surface point from the
+    // center, like CellIndex and the globe's fragments
+    HeatmapLayer(const Ellipsoid &ellipsoid, ThreadPool &pool = ThreadPool::shared());
+
+    // Geodetic latitudes and longitudes in radians, finite
+    void add_events(const double *lat, const double *lon, size_t count);
+    // Lines of "lat,lon" in degrees, other lines are skipped
+    int load_csv(std::string path);
+
+    // Merges the events added since the last call and picks the level for a
+    // camera in the globe's model space, see FrameState::pixel_scale. True
+    // when get_image() changed.
+    bool update(const glm::dvec3 &camera, double pixel_scale);
+    // Finest level whose cells are at least HEATMAP_CELL_PIXELS across
+    static int select_level(const glm::dvec3 &camera, double pixel_scale);
+
+    // Cells per side of a face
+    static inline uint32_t level_size(int level) {
+        return 1u << level;
+    }
+
+    inline uint64_t get_event_count() const {
+        return event_count;
+    }
+
+    // Merged by the last update()
+    inline const std::vector<uint64_t> &get_counts(int level) const {
+        return levels[level];
+    }
+
+    // Level of get_image(), -1 before the first update()
+    inline int get_level() const {
+        return active_level;
+    }
+
+    // Six faces of level_size(get_level()) rows from t = 0, 0 where nothing
+    // happened and 65535 at the highest density
+    inline const std::vector<uint16_t> &get_image() const {
+        return image;
+    }
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "HeatmapLayer.hpp"
+#include "Profiler.hpp"
+
+// Fixed with a layout qualifier in shaders/fragment_shader.frag
+static const GLuint HEATMAP_TEXTURE_UNIT = 2;
+
+/*
+    GPU copy of the level a HeatmapLayer shows, one array layer per cube
+    face. Earth programs built with FEATURE_HEATMAP sample it by the face
+    and (s, t) of SphereCell and blend it over the globe.
+    Assumes an OpenGL context is current on construction, use and
+    destruction.
+*/
+class HeatmapTexture
+{
+private:
+    GLuint texture = 0;
+    // Texels per side of the allocated layers
+    GLsizei size = 0;
+public:
+    HeatmapTexture();
+    ~HeatmapTexture();
+
+    HeatmapTexture(const HeatmapTexture&) = delete;
+    HeatmapTexture &operator=(const HeatmapTexture&) = delete;
+
+    // Call when update() of the layer returned true
+    void upload(const HeatmapLayer &layer);
+    // Binds to HEATMAP_TEXTURE_UNIT, unit 0 stays active
+    void use() const;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Profiler.hpp"
+#include "ThreadPool.hpp"
+
+static const int LOAD_IMAGE_SUCCESS = 0;
+static const int LOAD_IMAGE_FAILURE = 1;
+
+/*
+    8 bit per channel image in CPU memory, rows top to bottom.
+    GL-free, use a Texture to upload it.
+*/
+class Image
+{
+private:
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<uint8_t> pixels;
+public:
+    Image() = default;
+    Image(int width, int height, int channels);
+
+    // Decodes to the given channel count (e.g. 3 for RGB) using stb_image
+    int load(std::string path, int channels);
+    int load_from_memory(const uint8_t *data, size_t size, int channels);
+
+    inline int get_width() const {
+        return width;
+    }
+
+    inline int get_height() const {
+        return height;
+    }
+
+    inline int get_channels() const {
+        return channels;
+    }
+
+    inline const uint8_t *get_pixels() const {
+        return pixels.data();
+    }
+
+    inline uint8_t *get_pixels() {
+        return pixels.data();
+    }
+
+    // Box filtered half resolution copy, rows are processed in parallel
+    Image downsample(ThreadPool &pool = ThreadPool::shared()) const;
+    // All levels below this one down to 1x1, like glGenerateMipmap
+    std::vector<Image> generate_mips(ThreadPool &pool = ThreadPool::shared()) const;
+    // Resamples an equirectangular panorama (longitude along x, north pole
+    // in the first row, mapped like a Sphere) to six face_size cube faces
+    // in GL order +X, -X, +Y, -Y, +Z, -Z. Bilinear, rows of all faces are
+    // processed in parallel.
+    std::vector<Image> equirect_to_cube(int face_size, ThreadPool &pool = ThreadPool::shared()) const;
+};
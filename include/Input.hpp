@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+
+enum axis {
+    X,
+    Y,
+    Z
+};
+
+/*
+    Input accumulated by the GLFW callbacks on the main thread and consumed
+    by the update thread. Deltas are summed up until they are taken, so no
+    movement is lost if the update thread runs slower than the event loop.
+*/
+class Input
+{
+private:
+    std::atomic<double> dx{ 0.0 };
+    std::atomic<double> dy{ 0.0 };
+    std::atomic<double> scroll{ 0.0 };
+    // In framebuffer pixels from the top left, negative outside the window
+    std::atomic<double> cursor_x{ -1.0 };
+    std::atomic<double> cursor_y{ -1.0 };
+    std::atomic<bool> mouse_pressed{ false };
+    std::atomic<int> rotation_mode{ Z };
+    std::atomic<int> framebuffer_width{ 0 };
+    std::atomic<int> framebuffer_height{ 0 };
+
+    static void add(std::atomic<double> &value, double delta) {
+        double prev = value.load(std::memory_order_relaxed);
+        while (!value.compare_exchange_weak(prev, prev + delta, std::memory_order_relaxed));
+    }
+public:
+    /* MAIN THREAD */
+
+    inline void add_cursor_delta(double x, double y) {
+        add(dx, x);
+        add(dy, y);
+    }
+
+    inline void set_cursor_pos(double x, double y) {
+        cursor_x.store(x, std::memory_order_relaxed);
+        cursor_y.store(y, std::memory_order_relaxed);
+    }
+
+    inline void add_scroll(double offset) {
+        add(scroll, offset);
+    }
+
+    inline void set_mouse_pressed(bool pressed) {
+        mouse_pressed.store(pressed, std::memory_order_relaxed);
+    }
+
+    inline void set_rotation_mode(axis mode) {
+        rotation_mode.store(mode, std::memory_order_relaxed);
+    }
+
+    inline void set_framebuffer_size(int width, int height) {
+        framebuffer_width.store(width, std::memory_order_relaxed);
+        framebuffer_height.store(height, std::memory_order_relaxed);
+    }
+
+    /* UPDATE THREAD */
+
+    inline double take_dx() {
+        return dx.exchange(0.0, std::memory_order_relaxed);
+    }
+
+    inline double take_dy() {
+        return dy.exchange(0.0, std::memory_order_relaxed);
+    }
+
+    inline double take_scroll() {
+        return scroll.exchange(0.0, std::memory_order_relaxed);
+    }
+
+    inline double get_cursor_x() const {
+        return cursor_x.load(std::memory_order_relaxed);
+    }
+
+    inline double get_cursor_y() const {
+        return cursor_y.load(std::memory_order_relaxed);
+    }
+
+    inline bool is_mouse_pressed() const {
+        return mouse_pressed.load(std::memory_order_relaxed);
+    }
+
+    inline axis get_rotation_mode() const {
+        return (axis) rotation_mode.load(std::memory_order_relaxed);
+    }
+
+    inline int get_framebuffer_width() const {
+        return framebuffer_width.load(std::memory_order_relaxed);
+    }
+
+    inline int get_framebuffer_height() const {
+        return framebuffer_height.load(std::memory_order_relaxed);
+    }
+};
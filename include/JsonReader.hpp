@@ -0,0 +1,101 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Constants.hpp"
+#include "Profiler.hpp"
+
+static const int PARSE_JSON_SUCCESS = 0;
+static const int PARSE_JSON_FAILURE = 1;
+
+// Receives the tokens of a JsonReader in document order. Strings are only
+// valid during the call.
+class JsonHandler
+{
+public:
+    virtual ~JsonHandler() = default;
+
+    virtual void begin_object() {}
+    virtual void end_object() {}
+    virtual void begin_array() {}
+    virtual void end_array() {}
+    virtual void key(const std::string &name) { (void) name; }
+    virtual void string(const std::string &value) { (void) value; }
+    virtual void number(double value) { (void) value; }
+    virtual void boolean(bool value) { (void) value; }
+    virtual void null() {}
+};
+
+/*
+    Streaming, SAX style JSON parser. The document is fed in chunks of any
+    size, tokens may span chunks, and every token goes straight to the
+    handler, so nothing but the nesting and the current token is kept in
+    memory however large the document is. The token buffer is reused, so
+    after the first few tokens parsing allocates nothing.
+*/
+class JsonReader
+{
+private:
+    enum token_state {
+        TOKEN_NONE,
+        TOKEN_STRING,
+        TOKEN_ESCAPE,
+        TOKEN_UNICODE,
+        TOKEN_NUMBER,
+        TOKEN_LITERAL
+    };
+
+    // What may come next outside of a token
+    enum expectation {
+        EXPECT_VALUE,
+        // After [
+        EXPECT_VALUE_OR_END,
+        EXPECT_KEY,
+        // After {
+        EXPECT_KEY_OR_END,
+        EXPECT_COLON,
+        EXPECT_COMMA_OR_END,
+        // After the top-level value
+        EXPECT_NOTHING
+    };
+
+    JsonHandler &handler;
+    token_state state = TOKEN_NONE;
+    expectation expect = EXPECT_VALUE;
+    // { and [ of the open containers
+    std::vector<char> nesting;
+    std::string token;
+    bool token_is_key = false;
+    // \uXXXX escapes, a high surrogate waits for its low half
+    uint32_t code_point = 0;
+    int hex_digits = 0;
+    uint32_t high_surrogate = 0;
+    // Bytes fed so far, for error messages
+    size_t offset = 0;
+    bool failed = false;
+
+    int fail(const char *message);
+    void value_done();
+    // Ends a number or literal at the first byte that is not part of it
+    bool finish_number();
+    bool finish_literal();
+    void append_utf8(uint32_t code);
+    // Returns false on a syntax error
+    bool structural(char c);
+public:
+    JsonReader(JsonHandler &handler);
+
+    // Parses the next chunk of the document
+    int feed(const char *data, size_t size);
+    // After the last chunk, fails if the document is incomplete
+    int finish();
+
+    // Reads and parses a whole file in chunks of JSON_READ_CHUNK bytes
+    int parse_file(std::string path);
+};
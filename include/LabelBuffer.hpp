@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "GlyphAtlas.hpp"
+#include "LabelLayer.hpp"
+#include "Profiler.hpp"
+#include "RenderState.hpp"
+
+// Fixed with layout qualifiers in shaders/label.vert
+static const GLint LABEL_RECT_ATTR_LOCATION = 0;
+static const GLint LABEL_TEXELS_ATTR_LOCATION = 1;
+
+/*
+    GPU copy of a glyph atlas and of the glyphs a LabelLayer laid out,
+    drawn with one instanced draw of four vertices per glyph. The atlas is
+    sampled linearly and the distance turned into coverage in
+    shaders/label.frag, so the text stays sharp at any size. Needs a
+    program built from shaders/label.vert and shaders/label.frag and
+    get_render_state().
+    Assumes an OpenGL context is current on construction, use and
+    destruction.
+*/
+class LabelBuffer
+{
+private:
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLuint texture = 0;
+    // In glyphs
+    size_t count = 0;
+public:
+    LabelBuffer();
+    ~LabelBuffer();
+
+    LabelBuffer(const LabelBuffer&) = delete;
+    LabelBuffer &operator=(const LabelBuffer&) = delete;
+
+    // Once, before the first draw
+    void upload_atlas(const GlyphAtlas &atlas);
+    // Every frame after the layer was laid out
+    void upload(const LabelLayer &layer);
+    // Binds the atlas to texture unit 0
+    void draw() const;
+
+    inline size_t get_count() const {
+        return count;
+    }
+
+    // Over everything, text is not hidden by the globe it names
+    static RenderState get_render_state();
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Constants.hpp"
+#include "Ellipsoid.hpp"
+#include "GlyphAtlas.hpp"
+#include "Profiler.hpp"
+
+static const int LOAD_LABELS_SUCCESS = 0;
+static const int LOAD_LABELS_FAILURE = 1;
+
+// One glyph of the laid out labels, 24 bytes per instance
+struct GlyphInstance
+{
+    // Window pixels, origin in the bottom left corner
+    float x0;
+    float y0;
+    float x1;
+    float y1;
+    // Texels of the atlas
+    uint16_t u0;
+    uint16_t v0;
+    uint16_t u1;
+    uint16_t v1;
+};
+
+/*
+    Text labels at places on the globe. layout() runs once per frame: it
+    projects every label, drops those behind the horizon or off screen,
+    and places the rest in rank order, skipping any that would overlap one
+    already placed. Overlap is tested against the labels in the grid cells
+    a label covers, so thousands of candidates resolve in well under a
+    millisecond. The glyphs of all placed labels end up in one array of
+    instances. GL-free, use a LabelBuffer to draw it.
+*/
+class LabelLayer
+{
+private:
+    struct Label
+    {
+        // In the globe's model space, see GLOBE_LONGITUDE_OFFSET
+        glm::dvec3 position;
+        // Codepoints [first, first + count)
+        uint32_t first;
+        uint32_t count;
+        // In em
+        float width;
+        uint32_t rank;
+    };
+
+    const Ellipsoid &ellipsoid;
+    const GlyphAtlas &atlas;
+    std::vector<Label> labels;
+    std::vector<uint32_t> codepoints;
+    bool sorted = true;
+
+    // Boxes of the placed labels as x0, y0, x1, y1, and per grid cell the
+    // boxes that touch it. Kept between frames for their capacity.
+    std::vector<glm::vec4> boxes;
+    std::vector<std::vector<uint32_t>> cells;
+    std::vector<GlyphInstance> instances;
+public:
+    // The ellipsoid and atlas have to outlive the layer
+    LabelLayer(const Ellipsoid &ellipsoid, const GlyphAtlas &atlas);
+
+    inline size_t size() const {
+        return labels.size();
+    }
+
+    // Geodetic latitude and longitude in radians, height in meters. Lower
+    // ranks are placed first.
+    void add(Geodetic position, const std::string &text, uint32_t rank);
+
+    // Lines of "lat,lon,rank,name" in degrees, the name is the rest of the
+    // line in UTF-8. Other lines, e.g. a header, are skipped.
+    int load_csv(std::string path);
+
+    // view_proj is the rotation-only one of the frame, model the globe's
+    // and camera in the globe's model space. size is the em in pixels.
+    void layout(const glm::mat4 &view_proj, const glm::mat4 &model, const glm::dvec3 &camera,
+        int width, int height, float size);
+
+    inline const std::vector<GlyphInstance> &get_instances() const {
+        return instances;
+    }
+
+    // Labels placed by the last layout()
+    inline size_t get_placed_count() const {
+        return boxes.size();
+    }
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+#include "LineLayer.hpp"
+#include "Profiler.hpp"
+#include "RenderState.hpp"
+
+// Fixed with layout qualifiers in shaders/line.vert
+static const GLint LINE_START_ATTR_LOCATION = 0;
+static const GLint LINE_START_CHUNK_ATTR_LOCATION = 1;
+static const GLint LINE_END_ATTR_LOCATION = 2;
+static const GLint LINE_END_CHUNK_ATTR_LOCATION = 3;
+static const GLuint LINE_CHUNK_STORAGE_BINDING = 1;
+
+/*
+    GPU copy of the vertices of a LineLayer, drawn as anti-aliased lines
+    of line_width pixels with one instanced draw: four vertices per segment
+    made up in the vertex shader. Both ends of a segment come from the same
+    buffer, the end one vertex further, so nothing is duplicated. The chunk
+    origins are in a storage buffer indexed by the vertices. Needs a
+    program built from shaders/line.vert and shaders/line.frag and
+    get_render_state().
+    Assumes an OpenGL context is current on construction, use and
+    destruction.
+*/
+class LineBuffer
+{
+private:
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLuint chunk_buffer = 0;
+    // In vertices
+    size_t count = 0;
+public:
+    LineBuffer();
+    ~LineBuffer();
+
+    LineBuffer(const LineBuffer&) = delete;
+    LineBuffer &operator=(const LineBuffer&) = delete;
+
+    // Uploads all vertices of the layer, call after it was tessellated
+    void upload(const LineLayer &layer);
+    void draw() const;
+
+    inline size_t get_count() const {
+        return count;
+    }
+
+    // Blended over the globe and depth tested against it, without writing
+    // depth so crossing lines do not cut each other
+    static RenderState get_render_state(depth_mode mode);
+};
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Constants.hpp"
+#include "Ellipsoid.hpp"
+#include "GeoJson.hpp"
+#include "Profiler.hpp"
+#include "Terrain.hpp"
+#include "ThreadPool.hpp"
+
+static const int LOAD_LINES_SUCCESS = 0;
+static const int LOAD_LINES_FAILURE = 1;
+
+// One vertex of the tessellated lines, 16 bytes. Read twice per segment,
+// as its start and as its end.
+struct LineVertex
+{
+    // Meters from the origin of its chunk
+    float x;
+    float y;
+    float z;
+    // Twice the index of the chunk in LineLayer::get_chunks(), plus 1 if a
+    // segment joins the vertex to the next. Not at the last vertex of a
+    // line.
+    uint32_t chunk;
+};
+
+// Consecutive vertices of a line within LINE_CHUNK_RADIUS of the first,
+// 32 bytes in std430
+struct LineChunk
+{
+    // Origin in the globe's model space as the float nearest to it and the
+    // float nearest to the rest, like split_double(). w is unused.
+    glm::vec4 high;
+    glm::vec4 low;
+};
+
+/*
+    Polylines on the globe, e.g. coastlines and borders. Segments between
+    points are great circle arcs, split into pieces and laid on the
+    terrain. Every line picks one of LINE_TIER_COUNT tiers of piece length
+    from how far it is from the camera, and keeps the tiers it was split
+    into, so zooming back and forth only splits a line once per tier.
+    Points are kept as float unit normals of the ellipsoid, 12 bytes each,
+    so splitting needs no trigonometry.
+
+    update() runs builds on the thread pool and swaps the result in when
+    it is done, build() is the same on the calling thread. Lines can only
+    be added before the first build. GL-free, use a LineBuffer to draw it.
+*/
+class LineLayer
+{
+private:
+    struct Line
+    {
+        // Points [first, end)
+        uint32_t first;
+        uint32_t end;
+        // Unit normal at the middle of the line, and the largest angle from
+        // there to one of its points
+        glm::vec3 center;
+        float radius;
+        // Largest angle between two consecutive points
+        float longest;
+        // Tier in the vertices, and the ones split so far, empty if not.
+        // Chunk indices of the vertices of a tier count from its first chunk.
+        uint32_t tier;
+        std::vector<LineVertex> tiers[LINE_TIER_COUNT];
+        std::vector<LineChunk> tier_chunks[LINE_TIER_COUNT];
+    };
+
+    const Ellipsoid &ellipsoid;
+    const Terrain &terrain;
+    ThreadPool &pool;
+    // Called on a worker thread when a build of update() is done
+    void (*notify)();
+
+    // In the globe's model space, see GLOBE_LONGITUDE_OFFSET
+    std::vector<glm::vec3> normals;
+    // From each point to the next in radians, 0 at the last of a line.
+    // Measured once, splitting only divides.
+    std::vector<float> angles;
+    std::vector<Line> lines;
+    // Drawn, and written by the build in progress
+    std::vector<LineVertex> vertices;
+    std::vector<LineChunk> chunks;
+    std::vector<LineVertex> staging;
+    std::vector<LineChunk> staging_chunks;
+    // Of the build in progress
+    std::vector<uint32_t> wanted;
+    std::vector<size_t> offsets;
+    std::vector<size_t> chunk_offsets;
+    bool built = false;
+
+    std::future<void> build_future;
+    bool building = false;
+    bool build_changed = false;
+    // View of the last build, no new one starts while it stays the same
+    bool requested = false;
+    glm::dvec3 build_camera = glm::dvec3(0.0);
+    double build_pixel_scale = 0.0;
+
+    // Pieces a segment of this many radians is split into
+    static inline size_t count_pieces(float angle, double max_angle) {
+        return std::max((size_t) std::ceil(angle / max_angle), (size_t) 1);
+    }
+    uint32_t select_tier(const Line &line, const glm::dvec3 &camera, double pixel_scale) const;
+    void split(Line &line, uint32_t tier) const;
+    // Into staging, returns false if no line changed its tier
+    bool rebuild(const glm::dvec3 &camera, double pixel_scale);
+    // Waits for the build of update(), returns true if it swapped vertices
+    bool finish_build();
+public:
+    // The ellipsoid, terrain and pool have to outlive the layer
+    LineLayer(const Ellipsoid &ellipsoid, const Terrain &terrain, void (*notify)() = nullptr,
+        ThreadPool &pool = ThreadPool::shared());
+    ~LineLayer();
+
+    LineLayer(const LineLayer&) = delete;
+    LineLayer &operator=(const LineLayer&) = delete;
+
+    inline size_t get_line_count() const {
+        return lines.size();
+    }
+
+    inline size_t get_point_count() const {
+        return normals.size();
+    }
+
+    // Longitude, latitude pairs in degrees, like GeoJSON. Lines of fewer
+    // than two points are skipped.
+    void add_line(const double *lon_lat, size_t count);
+
+    // Adds every line of a GeoJSON file, see read_geojson_lines
+    int load_geojson(std::string path);
+
+    // Call once per frame with the camera in the globe's model space and
+    // the pixels per radian of the view. Starts a build when the view
+    // changed and none is running. Returns true when a build that changed
+    // the vertices finished, they have to be uploaded again then.
+    bool update(const glm::dvec3 &camera, double pixel_scale);
+
+    // Selects the tiers for this view and splits the lines that need it on
+    // the calling thread, spread over the pool. Waits for a build of
+    // update() first. Returns true if the vertices changed, by either.
+    bool build(const glm::dvec3 &camera, double pixel_scale);
+
+    // Drops every split tier, the next build splits every line again, e.g.
+    // after the terrain changed. Waits for a build of update() first and
+    // returns true if that changed the vertices, otherwise they stay until
+    // the next build.
+    bool clear_cache();
+
+    inline const std::vector<LineVertex> &get_vertices() const {
+        return vertices;
+    }
+
+    inline const std::vector<LineChunk> &get_chunks() const {
+        return chunks;
+    }
+
+    // Largest angle of the pieces of a tier in radians, finer by
+    // LINE_TIER_STEP per tier
+    static inline double tier_angle(uint32_t tier) {
+        return LINE_MAX_SEGMENT_ANGLE / std::pow(LINE_TIER_STEP, (double) tier);
+    }
+};
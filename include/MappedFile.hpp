@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+static const int MAP_FILE_SUCCESS = 0;
+static const int MAP_FILE_FAILURE = 1;
+
+/*
+    Read-only memory mapping of a whole file. Pages are loaded by the OS
+    when they are first touched, so only the parts of a large file that are
+    actually read cost I/O. Safe to read from several threads. Uses
+    MapViewOfFile on Windows and mmap elsewhere.
+*/
+class MappedFile
+{
+private:
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+#if defined(_WIN32)
+    void *file = nullptr;
+    void *mapping = nullptr;
+#endif
+
+    void unmap();
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+
+    int map(std::string path);
+
+    inline const uint8_t *get_data() const {
+        return data;
+    }
+
+    inline size_t get_size() const {
+        return size;
+    }
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+#include "MarkerLayer.hpp"
+#include "Profiler.hpp"
+#include "RenderState.hpp"
+
+// Fixed with layout qualifiers in shaders/marker.vert
+static const GLint MARKER_POSITION_HIGH_ATTR_LOCATION = 0;
+static const GLint MARKER_POSITION_LOW_ATTR_LOCATION = 1;
+static const GLint MARKER_COLOR_ATTR_LOCATION = 2;
+
+/*
+    GPU copy of a MarkerLayer, drawn as camera facing squares of
+    marker_size pixels with one instanced draw: four vertices per marker
+    made up in the vertex shader, position and color per instance. Only the
+    range that changed is uploaded again. Needs a program built from
+    shaders/marker.vert and shaders/marker.frag and get_render_state().
+    Assumes an OpenGL context is current on construction, use and
+    destruction.
+*/
+class MarkerBuffer
+{
+private:
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    // In instances
+    size_t capacity = 0;
+    size_t count = 0;
+public:
+    MarkerBuffer();
+    ~MarkerBuffer();
+
+    MarkerBuffer(const MarkerBuffer&) = delete;
+    MarkerBuffer &operator=(const MarkerBuffer&) = delete;
+
+    // Updates the layer and uploads its dirty range with glBufferSubData.
+    // Reallocates and uploads everything only when the layer outgrew the
+    // buffer. Returns whether the markers to draw changed.
+    bool upload(MarkerLayer &layer);
+    void draw() const;
+
+    inline size_t get_count() const {
+        return count;
+    }
+
+    // Depth tested like opaque geometry, the squares face the camera so
+    // there is nothing to cull
+    static RenderState get_render_state(depth_mode mode);
+};
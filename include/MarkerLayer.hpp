@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Constants.hpp"
+#include "Ellipsoid.hpp"
+#include "Profiler.hpp"
+#include "ThreadPool.hpp"
+
+static const int LOAD_MARKERS_SUCCESS = 0;
+static const int LOAD_MARKERS_FAILURE = 1;
+
+// Per-instance vertex data of one marker, 28 bytes
+struct MarkerInstance
+{
+    // ECEF in meters, as the float nearest to it and the float nearest to
+    // the rest, like split_double(). A single float is up to half a meter
+    // off, which shows as jitter close to the ground.
+    float high[3];
+    float low[3];
+    // RGBA8, red in the lowest byte
+    uint32_t color;
+};
+
+/*
+    Millions of colored points on the globe, e.g. sensor locations.
+    Coordinates are kept as structure of arrays, so update() converts them
+    to instances with the batched SIMD kernel of the ellipsoid, in parallel.
+    Changes are tracked as one dirty range, which is all a renderer has to
+    upload again. GL-free, use a MarkerBuffer to draw it.
+*/
+class MarkerLayer
+{
+private:
+    const Ellipsoid &ellipsoid;
+    GeodeticArrays coords;
+    std::vector<uint32_t> colors;
+    std::vector<MarkerInstance> instances;
+
+    // [dirty_begin, dirty_end) needs converting and uploading
+    size_t dirty_begin = 0;
+    size_t dirty_end = 0;
+    bool converted = true;
+
+    void mark_dirty(size_t begin, size_t end);
+public:
+    // The ellipsoid has to outlive the layer
+    MarkerLayer(const Ellipsoid &ellipsoid);
+
+    inline size_t size() const {
+        return coords.size();
+    }
+
+    // Geodetic latitude and longitude in radians, height in meters. The
+    // instances are in the globe's model space, see GLOBE_LONGITUDE_OFFSET.
+    void add(Geodetic position, uint32_t color);
+    void set(size_t index, Geodetic position, uint32_t color);
+    void resize(size_t count);
+
+    // Lines of "lat,lon[,height[,rrggbb]]" in degrees and meters. Other
+    // lines, e.g. a header, are skipped.
+    int load_csv(std::string path);
+
+    // Converts the dirty range to instances
+    void update(ThreadPool &pool = ThreadPool::shared());
+
+    inline const std::vector<MarkerInstance> &get_instances() const {
+        return instances;
+    }
+
+    // Range of instances changed since the last take_dirty_range(), empty
+    // if begin == end. Call update() first.
+    void take_dirty_range(size_t &begin, size_t &end);
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "Globe.hpp"
+#include "Profiler.hpp"
+#include "Sphere.hpp"
+#include "VertexAttributes.hpp"
+
+/*
+    GPU copy of CPU generated geometry (positions with 3 floats, texcoords
+    with 2 floats and optionally morph targets with 4 floats per vertex and
+    triangle indices). Owns its VAO, so the element buffer binding is part
+    of the mesh.
+    Assumes an OpenGL context is current on construction, drawing and
+    destruction.
+*/
+class Mesh
+{
+private:
+    GLuint vao = 0;
+    GLuint vbo[3] = { 0, 0, 0 };
+    GLuint ebo = 0;
+    GLsizei index_count = 0;
+public:
+    Mesh(const std::vector<float> &vertices, const std::vector<float> &texcoords, const std::vector<uint32_t> &indices,
+        const std::vector<float> &morphs = {});
+    Mesh(const Sphere &sphere);
+    Mesh(const GlobePatch &patch);
+    ~Mesh();
+
+    Mesh(const Mesh&) = delete;
+    Mesh &operator=(const Mesh&) = delete;
+
+    inline GLuint get_vertex_vbo() const {
+        return vbo[0];
+    }
+
+    inline GLuint get_texcoord_vbo() const {
+        return vbo[1];
+    }
+
+    // Links the buffers to the attribute locations of a program. Without
+    // morph targets, morph_attr is left disabled.
+    void set_attributes(GLint pos_attr, GLint tex_attr, GLint morph_attr = -1) const;
+    void draw() const;
+    // A range of the indices, e.g. one level of detail
+    void draw(uint32_t first_index, uint32_t count) const;
+};
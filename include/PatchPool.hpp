@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "Globe.hpp"
+#include "Profiler.hpp"
+#include "VertexAttributes.hpp"
+
+static const int ALLOCATE_PATCH_FAILURE = -1;
+
+// Layout fixed by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+    uint32_t count;
+    uint32_t instance_count;
+    uint32_t first_index;
+    int32_t base_vertex;
+    uint32_t base_instance;
+};
+
+/*
+    GPU copies of many globe patches in one set of large buffers behind a
+    single VAO, so any set of them is drawn with one
+    glMultiDrawElementsIndirect and no state changes in between. The
+    buffers are split into capacity equally sized slots, which fits the
+    patches of a Globe since they all have the same vertex and index count.
+    Freed slots are reused. Indices stay relative to their patch, every
+    draw adds the first vertex of its slot as base vertex.
+    Assumes an OpenGL context is current on construction, use and
+    destruction.
+*/
+class PatchPool
+{
+private:
+    GLuint vao = 0;
+    // Positions, texcoords and morph targets
+    GLuint vbo[3] = { 0, 0, 0 };
+    GLuint ebo = 0;
+    GLuint indirect_buffer = 0;
+
+    uint32_t slot_vertices;
+    uint32_t slot_indices;
+    uint32_t capacity;
+    std::vector<uint32_t> free_slots;
+
+    std::vector<DrawElementsIndirectCommand> commands;
+public:
+    PatchPool(uint32_t slot_vertices, uint32_t slot_indices, uint32_t capacity);
+    ~PatchPool();
+
+    PatchPool(const PatchPool&) = delete;
+    PatchPool &operator=(const PatchPool&) = delete;
+
+    // Uploads the patch into a free slot and returns the slot, or
+    // ALLOCATE_PATCH_FAILURE if it is full or the patch is too big
+    int allocate(const GlobePatch &patch);
+    void release(uint32_t slot);
+
+    inline uint32_t get_free_count() const {
+        return (uint32_t) free_slots.size();
+    }
+
+    // Links the buffers to the attribute locations of a program
+    void set_attributes(GLint pos_attr, GLint tex_attr, GLint morph_attr) const;
+
+    // Queues a draw of count indices of slot, starting at first_index
+    void add_draw(uint32_t slot, uint32_t first_index, uint32_t count);
+    // Submits the queued draws in one call and clears them. gl_DrawID is
+    // the position of a draw in the queue.
+    void draw();
+};
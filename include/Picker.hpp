@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "Constants.hpp"
+#include "Ellipsoid.hpp"
+#include "Profiler.hpp"
+#include "Terrain.hpp"
+
+// Where a ray hit the globe
+struct PickHit
+{
+    // In the earth's model space, meters
+    glm::dvec3 position;
+    // Along the ray from its origin
+    double distance;
+    // Geographic, with the longitude in [-PI, PI)
+    Geodetic geodetic;
+};
+
+/*
+    Intersects rays with the globe for picking. Without terrain the ray is
+    intersected analytically with the ellipsoid. With terrain it is
+    clipped to the shell between TERRAIN_MIN_HEIGHT and TERRAIN_MAX_HEIGHT
+    and marched through it by Terrain::clearance(), past the blocks of the
+    height tree the ray stays above, and in steps of half a sample, at
+    least PICK_MIN_STEP, where it meets the leaves. The step that goes
+    below the ground is refined by bisection.
+
+    Works on the full resolution of the DEM tiles, not on the displayed
+    patches, so the readout does not change with the level of detail.
+    GL-free and const, so it can run on any thread.
+*/
+class Picker
+{
+private:
+    static const int REFINE_ITERATIONS = 24;
+
+    const Ellipsoid &ellipsoid;
+    const Terrain &terrain;
+
+    // Ray parameters where it enters and leaves the ellipsoid grown by
+    // height, false if it misses it
+    bool intersect_ellipsoid(const glm::dvec3 &origin, const glm::dvec3 &direction, double height, double &t_near, double &t_far) const;
+    // Height of the ray above the ground at t, and where that is
+    double height_above_ground(const glm::dvec3 &origin, const glm::dvec3 &direction, double t, Geodetic &geodetic) const;
+public:
+    // Both have to outlive the picker
+    Picker(const Ellipsoid &ellipsoid, const Terrain &terrain);
+
+    // Ray in the earth's model space, direction normalized. Returns false
+    // if it misses the globe or starts inside it.
+    bool intersect(const glm::dvec3 &origin, const glm::dvec3 &direction, PickHit &hit) const;
+
+    // Distance from the center to the ground, the ellipsoid plus the
+    // terrain, in a direction of the earth's model space, e.g. under the
+    // camera
+    double ground_radius(const glm::dvec3 &direction) const;
+};
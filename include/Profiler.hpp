@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Constants.hpp"
+
+static const int DUMP_TRACE_SUCCESS = 0;
+static const int DUMP_TRACE_FAILURE = 1;
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+
+// Records the enclosing scope as one zone. The name must be a string literal
+// or otherwise outlive the profiler, only the pointer is stored.
+#define PROFILE_SCOPE(name) ProfileZone PROFILER_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+
+/*
+    CPU profiler recording scoped zones into per-thread ring buffers.
+    Recording is lock-free: every thread owns its buffer and only publishes
+    its write position with an atomic store. The mutex is only taken once
+    per thread to register the buffer, and when dumping.
+    The result is written in the Chrome trace_event format, which can be
+    opened with chrome://tracing or https://ui.perfetto.dev.
+*/
+class Profiler
+{
+private:
+    struct Event
+    {
+        const char *name;
+        uint64_t begin_ns;
+        uint64_t end_ns;
+    };
+
+    struct ThreadBuffer
+    {
+        uint32_t thread_id;
+        std::string thread_name;
+        // Allocated by the first event
+        std::vector<Event> events;
+        // Total events ever written, the ring keeps the last PROFILER_EVENTS_PER_THREAD
+        std::atomic<uint64_t> written{ 0 };
+    };
+
+    static std::atomic<bool> enabled;
+    static std::chrono::steady_clock::time_point epoch;
+    static std::mutex registry_mutex;
+    static std::vector<std::unique_ptr<ThreadBuffer>> registry;
+
+    static ThreadBuffer &thread_buffer();
+public:
+    static inline bool is_enabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    static void set_enabled(bool enable);
+    // Shows up as the thread name in the trace viewer
+    static void set_thread_name(std::string name);
+
+    static inline uint64_t now_ns() {
+        return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    static void record(const char *name, uint64_t begin_ns, uint64_t end_ns);
+
+    // Call once the other threads stopped recording, events that are
+    // overwritten while dumping may be torn otherwise
+    static int dump(std::string path);
+};
+
+class ProfileZone
+{
+private:
+    const char *name;
+    uint64_t begin_ns = 0;
+public:
+    ProfileZone(const char *name) : name(name) {
+        if (Profiler::is_enabled()) {
+            begin_ns = Profiler::now_ns();
+        }
+        else {
+            this->name = nullptr;
+        }
+    }
+
+    ~ProfileZone() {
+        if (name != nullptr) {
+            Profiler::record(name, begin_ns, Profiler::now_ns());
+        }
+    }
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "Profiler.hpp"
+#include "Shader.hpp"
+
+static const int LINK_PROGRAM_SUCCESS = 0;
+static const int LINK_PROGRAM_FAILURE = 1;
+
+class Program
+{
+private:
+    GLuint program = 0;
+    // glGetUniformLocation is a string lookup in the driver, only do it once per name
+    mutable std::unordered_map<std::string, GLint> uniform_locations;
+
+    int check_link_status(const char *what) const;
+public:
+    Program() = default;
+    ~Program();
+
+    Program(const Program&) = delete;
+    Program &operator=(const Program&) = delete;
+
+    inline GLuint get_id() const {
+        return program;
+    }
+
+    // KHR/ARB_parallel_shader_compile, lets the driver use all its compiler threads
+    static bool has_parallel_compile();
+    static void enable_parallel_compile();
+
+    // Starts linking without waiting for the result. retrievable requests
+    // that get_binary() works afterwards.
+    void submit_link(const Shader &vertex_shader, const Shader &fragment_shader, bool retrievable = false);
+    // Never blocks. Always true without parallel compile support, the
+    // status queries block in that case.
+    bool is_link_complete() const;
+    // Waits for the link if needed
+    int check_link() const;
+
+    // submit_link() followed by check_link()
+    int link(const Shader &vertex_shader, const Shader &fragment_shader, bool retrievable = false);
+    // Fails if the driver rejects the binary, e.g. after a driver update
+    int load_binary(GLenum format, const std::vector<uint8_t> &binary);
+    bool get_binary(GLenum &format, std::vector<uint8_t> &binary) const;
+
+    // Cached, -1 if the uniform does not exist or was optimized away
+    GLint get_uniform_location(const std::string &name) const;
+
+    void use() const;
+};
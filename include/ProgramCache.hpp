@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "Hash.hpp"
+#include "Profiler.hpp"
+#include "Program.hpp"
+#include "Shader.hpp"
+#include "ShaderPreprocessor.hpp"
+
+static const int LOAD_PROGRAM_SUCCESS = 0;
+static const int LOAD_PROGRAM_FAILURE = 1;
+
+/*
+    Stores linked programs on disk with glGetProgramBinary and restores them
+    with glProgramBinary on the next start, skipping compilation and linking.
+    Sources go through the ShaderPreprocessor, so every feature variant is
+    its own program. Files are named after the hash of the preprocessed
+    sources. The header stores
+    a hash of the vendor, renderer and version strings, so a different GPU
+    or driver is detected and the program is transparently rebuilt from the
+    sources, overwriting the stale entry.
+
+    Programs are built as a batch: submit() restores cache hits and starts
+    every compile and link of the misses without waiting for any of them,
+    so drivers with KHR_parallel_shader_compile build them concurrently.
+    poll() tells when all are done without blocking, finish() waits,
+    reports errors and stores the new binaries.
+*/
+class ProgramCache
+{
+private:
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t source_hash;
+        uint64_t driver_hash;
+        uint32_t format;
+        uint32_t length;
+    };
+
+    static const uint32_t CACHE_VERSION = 1;
+
+    struct Request
+    {
+        Program *program;
+        std::string vertex_path;
+        std::string fragment_path;
+        uint32_t features = 0;
+        // Main file and includes, for error messages
+        std::string vertex_name;
+        std::string fragment_name;
+        uint64_t source_hash = 0;
+        bool cached = false;
+        std::unique_ptr<Shader> vertex_shader;
+        std::unique_ptr<Shader> fragment_shader;
+    };
+
+    std::string directory;
+    uint64_t driver_hash = 0;
+    // Drivers are not required to support any binary format
+    bool supported = false;
+
+    std::vector<Request> requests;
+    bool submit_failed = false;
+
+    std::string entry_path(uint64_t source_hash) const;
+    bool read_entry(uint64_t source_hash, GLenum &format, std::vector<uint8_t> &binary) const;
+    void write_entry(uint64_t source_hash, GLenum format, const std::vector<uint8_t> &binary) const;
+public:
+    // Needs a current context to query the driver
+    ProgramCache(std::string directory);
+
+    // The program has to outlive finish(). features is a mask of shader_feature.
+    void add(Program &program, std::string vertex_path, std::string fragment_path, uint32_t features = 0);
+    void submit();
+    bool poll() const;
+    // Returns LOAD_PROGRAM_FAILURE if any program of the batch failed
+    int finish();
+
+    // A batch of one
+    int load_program(Program &program, std::string vertex_path, std::string fragment_path, uint32_t features = 0);
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "FileWatcher.hpp"
+#include "Profiler.hpp"
+#include "Program.hpp"
+#include "ProgramCache.hpp"
+
+/*
+    Rebuilds programs when a .vert, .frag or .glsl file of their shader
+    directory changes, without a restart. Rebuilding runs as a ProgramCache batch, so the driver
+    compiles in the background while frames keep being rendered with the
+    old programs. Only once the whole batch linked successfully are the
+    programs swapped, on failure the old ones stay in use.
+*/
+class ProgramReloader
+{
+private:
+    struct Entry
+    {
+        std::unique_ptr<Program> &program;
+        std::string vertex_path;
+        std::string fragment_path;
+        uint32_t features;
+        std::unique_ptr<Program> candidate;
+    };
+
+    ProgramCache &cache;
+    FileWatcher watcher;
+    std::vector<Entry> entries;
+    bool pending = false;
+    bool building = false;
+public:
+    // notify is called on the watcher thread after a change
+    ProgramReloader(ProgramCache &cache, std::string directory, void (*notify)());
+
+    // The unique_ptr has to outlive the reloader, its program is replaced on reload
+    void add(std::unique_ptr<Program> &program, std::string vertex_path, std::string fragment_path, uint32_t features = 0);
+
+    void start();
+    void stop();
+
+    // Call once per frame on the render thread. Returns true if programs
+    // were swapped, locations queried from the old ones are invalid then.
+    bool update();
+
+    // True while changes are waiting or being built, keep calling update()
+    inline bool is_busy() const {
+        return pending || building;
+    }
+};
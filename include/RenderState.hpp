@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "Camera.hpp"
+
+/*
+    Fixed-function state of a render pass. Passes describe the state they
+    need in full instead of changing and restoring individual flags.
+*/
+struct RenderState
+{
+    bool depth_test = true;
+    bool depth_write = true;
+    GLenum depth_func = GL_LESS;
+    bool cull = false;
+    GLenum cull_face = GL_BACK;
+    // Sphere meshes are counter-clockwise seen from outside
+    GLenum front_face = GL_CCW;
+    // Over what is drawn, by the alpha of the fragment
+    bool blend = false;
+};
+
+// Depth function that lets nearer fragments pass in the given mode
+inline GLenum depth_func_nearer(depth_mode mode, bool or_equal = false)
+{
+    if (mode == DEPTH_REVERSED) {
+        return or_equal ? GL_GEQUAL : GL_GREATER;
+    }
+    return or_equal ? GL_LEQUAL : GL_LESS;
+}
+
+// Value the depth buffer is cleared to, the far plane
+inline double far_depth(depth_mode mode)
+{
+    return mode == DEPTH_REVERSED ? 0.0 : 1.0;
+}
+
+/*
+    Shadows the GL render state so apply() only issues calls for what
+    changed since the previous apply(). Code that changes these states
+    directly has to call invalidate() afterwards.
+    Assumes an OpenGL context is current.
+*/
+class RenderStateCache
+{
+private:
+    RenderState current;
+    bool valid = false;
+public:
+    void apply(const RenderState &state);
+    void invalidate();
+};
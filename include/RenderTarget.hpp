@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "Profiler.hpp"
+
+/*
+    Offscreen framebuffer with an RGBA8 color and a 32 bit float depth
+    buffer. The default framebuffer usually only offers 24 bit fixed point
+    depth, which wastes reversed-Z: its precision is spread evenly instead
+    of following the float exponent. The color is blitted to the window at
+    the end of the frame.
+    Assumes an OpenGL context is current on construction, use and destruction.
+*/
+class RenderTarget
+{
+private:
+    GLuint framebuffer = 0;
+    // Color and depth
+    GLuint renderbuffers[2] = { 0, 0 };
+    int width = 0;
+    int height = 0;
+public:
+    RenderTarget() = default;
+    ~RenderTarget();
+
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget &operator=(const RenderTarget&) = delete;
+
+    // (Re)allocates the buffers if the size changed, then binds for drawing
+    void bind(int width, int height);
+    // Copies the color to the default framebuffer and binds it
+    void blit_to_screen() const;
+};
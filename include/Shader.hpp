@@ -10,6 +10,7 @@
 #include <glad/glad.h>
 
 #include "Constants.hpp"
+#include "Profiler.hpp"
 
 static const int LOAD_SHADER_SUCCESS = 0;
 static const int LOAD_SHADER_FAILURE = 1;
@@ -23,9 +24,20 @@ public:
     Shader(GLenum type);
     ~Shader();
 
-    inline GLuint get_id() {
+    inline GLuint get_id() const {
         return shader;
     }
 
+    // Reads the whole file into src
+    static int read_source(std::string file_path, std::string &src);
+
+    // Starts compiling without waiting for the result, the driver may
+    // compile on its own threads (KHR_parallel_shader_compile)
+    void submit_source(const std::string &src);
+    // Waits for the compilation if needed, name only shows up in error messages
+    int check_status(std::string name) const;
+
+    // submit_source() followed by check_status()
+    int compile_source(const std::string &src, std::string name);
     int load_shader(std::string file_path);
 };
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static const int PREPROCESS_SHADER_SUCCESS = 0;
+static const int PREPROCESS_SHADER_FAILURE = 1;
+
+// Compile-time shader features, every combination is its own program
+enum shader_feature {
+    FEATURE_WIREFRAME = 1 << 0,
+    FEATURE_NIGHT_LIGHTS = 1 << 1,
+    FEATURE_ATMOSPHERE = 1 << 2,
+    FEATURE_TEXTURE_ARRAY = 1 << 3,
+    // Depth mode, exactly one of these is set on every program, see depth_mode
+    FEATURE_REVERSED_Z = 1 << 4,
+    FEATURE_LOG_DEPTH = 1 << 5,
+    // Per-draw data from a storage buffer indexed by gl_DrawID instead of
+    // the Object uniform block, for PatchPool
+    FEATURE_MULTI_DRAW = 1 << 6,
+    // Event density over the globe, see HeatmapTexture
+    FEATURE_HEATMAP = 1 << 7
+};
+
+/*
+    Turns a GLSL file into a single source string for glShaderSource.
+    - #include "file" is resolved relative to the including file. Every
+      file is included at most once per shader, like with #pragma once.
+    - The enabled features are inserted right after #version as #defines
+      (WIREFRAME, NIGHT_LIGHTS, ATMOSPHERE, TEXTURE_ARRAY, ...), so shaders use
+      #ifdef instead of branching on uniforms per pixel.
+    - #line directives keep compiler messages pointing at the original
+      lines, the source string number is the index into get_files().
+    GL-free.
+*/
+class ShaderPreprocessor
+{
+private:
+    std::vector<std::string> files;
+
+    int process_file(std::string path, uint32_t features, std::stringstream &out);
+public:
+    int preprocess(std::string path, uint32_t features, std::string &out);
+
+    // Files that went into the last result, index 0 is the main file
+    inline const std::vector<std::string> &get_files() const {
+        return files;
+    }
+
+    // e.g. "shaders/earth.frag (1: shaders/transforms.glsl)" for error messages
+    std::string describe() const;
+
+    static std::string feature_defines(uint32_t features);
+};
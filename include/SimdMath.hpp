@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+/*
+    Branch-free double precision sin/cos and atan in the style of the Cephes
+    library. Unlike the libm calls they are plain arithmetic and selects, so
+    loops marked with #pragma omp simd (built with -fopenmp-simd) are
+    vectorized. Within a few ulp of libm for |x| < 1e9.
+*/
+
+static const double SIMD_PI = 3.14159265358979323846;
+static const double SIMD_FOUR_OVER_PI = 1.27323954473516268615;
+// pi / 4 split into three parts, the products with the quadrant are exact
+static const double SIMD_PI_4_A = 7.85398125648498535156e-1;
+static const double SIMD_PI_4_B = 3.77489470793079817668e-8;
+static const double SIMD_PI_4_C = 2.69515142907905952645e-15;
+
+inline void simd_sincos(double x, double &sin_x, double &cos_x)
+{
+    double sign = x < 0.0 ? -1.0 : 1.0;
+    x = std::fabs(x);
+
+    // Octant, rounded up to even so z is in [-pi/4, pi/4]
+    int32_t j = (int32_t) (x * SIMD_FOUR_OVER_PI);
+    j += j & 1;
+    double y = (double) j;
+    double z = ((x - y * SIMD_PI_4_A) - y * SIMD_PI_4_B) - y * SIMD_PI_4_C;
+    double zz = z * z;
+
+    double ps = 1.58962301576546568060e-10;
+    ps = ps * zz - 2.50507477628578072866e-8;
+    ps = ps * zz + 2.75573136213857245213e-6;
+    ps = ps * zz - 1.98412698295895385996e-4;
+    ps = ps * zz + 8.33333333332211858878e-3;
+    ps = ps * zz - 1.66666666666666307295e-1;
+    ps = z + z * zz * ps;
+
+    double pc = -1.13585365213876817300e-11;
+    pc = pc * zz + 2.08757008419747316778e-9;
+    pc = pc * zz - 2.75573141792967388112e-7;
+    pc = pc * zz + 2.48015872888517045348e-5;
+    pc = pc * zz - 1.38888888888730564116e-3;
+    pc = pc * zz + 4.16666666666665929218e-2;
+    pc = 1.0 - 0.5 * zz + zz * zz * pc;
+
+    // Octants 2 and 6 swap the polynomials, 4 and 6 negate sin,
+    // 2 and 4 negate cos. Compared as doubles, so the selects have the
+    // same width as the data and vectorize.
+    double octant = (double) (j & 7);
+    bool swap = octant == 2.0 || octant == 6.0;
+    double s = swap ? pc : ps;
+    double c = swap ? ps : pc;
+    sin_x = octant >= 4.0 ? -sign * s : sign * s;
+    cos_x = (octant == 2.0 || octant == 4.0) ? -c : c;
+}
+
+inline double simd_atan(double x)
+{
+    // tan(3 pi / 8)
+    static const double T3P8 = 2.41421356237309504880;
+    static const double MORE_BITS = 6.123233995736765886130e-17;
+
+    double sign = x < 0.0 ? -1.0 : 1.0;
+    x = std::fabs(x);
+
+    // Reduce to |x| <= 0.66 with atan(x) = pi/2 - atan(1/x) and
+    // atan(x) = pi/4 + atan((x - 1) / (x + 1))
+    bool medium = x > 0.66;
+    bool large = x > T3P8;
+    double offset = medium ? SIMD_PI / 4.0 + 0.5 * MORE_BITS : 0.0;
+    offset = large ? SIMD_PI / 2.0 + MORE_BITS : offset;
+    double reduced = medium ? (x - 1.0) / (x + 1.0) : x;
+    reduced = large ? -1.0 / x : reduced;
+
+    double z = reduced * reduced;
+    double p = -8.750608600031904122785e-1;
+    p = p * z - 1.615753718733365076637e1;
+    p = p * z - 7.500855792314704667340e1;
+    p = p * z - 1.228866684490136173410e2;
+    p = p * z - 6.485021904942025371773e1;
+    double q = z + 2.485846490142306297962e1;
+    q = q * z + 1.650270098316988542046e2;
+    q = q * z + 4.328810604912902668951e2;
+    q = q * z + 4.853903996359136964868e2;
+    q = q * z + 1.945506571482613964425e2;
+
+    return sign * (offset + (reduced + reduced * z * p / q));
+}
+
+inline double simd_atan2(double y, double x)
+{
+    // x == 0 gives atan(+-inf) = +-pi/2, only 0 / 0 needs care
+    double ratio = y / x;
+    ratio = (x == 0.0 && y == 0.0) ? 0.0 : ratio;
+    double quadrant = y < 0.0 ? -SIMD_PI : SIMD_PI;
+    quadrant = x < 0.0 ? quadrant : 0.0;
+    return simd_atan(ratio) + quadrant;
+}
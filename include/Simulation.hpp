@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Camera.hpp"
+#include "Constants.hpp"
+#include "FrameState.hpp"
+#include "Globe.hpp"
+#include "Input.hpp"
+#include "Picker.hpp"
+#include "Profiler.hpp"
+#include "TripleBuffer.hpp"
+
+/*
+    Runs input handling and camera math on its own update thread and
+    publishes the result as FrameState snapshots, so none of this work
+    competes with GL submission on the render thread. GL-free.
+*/
+class Simulation
+{
+private:
+    Input &input;
+    TripleBuffer<FrameState> &frames;
+    // Called after every publish, e.g. to wake up the render thread
+    void (*notify)() = nullptr;
+
+    std::thread thread;
+    std::atomic<bool> running{ false };
+
+    /* CAMERA AND WORLD STATE, ONLY TOUCHED BY THE UPDATE THREAD */
+    uint64_t frame = 0;
+    std::chrono::steady_clock::time_point start_time;
+    Camera camera;
+    int viewport_width = 0;
+    int viewport_height = 0;
+    // Rotation of the earth's model space, orthonormalized after every
+    // drag so rounding does not pile up. Its inverse is the transpose, the
+    // float model matrix is made from it in publish().
+    glm::dmat3 earth_orientation;
+    glm::mat4 model_space_transform;
+    // In the earth's model space
+    std::vector<PatchBounds> earth_patches;
+    // Sphere inside all of the terrain, it hides what is below the horizon
+    double occluder_radius = 0.0;
+    const Picker &picker;
+    double cursor_x = -1.0;
+    double cursor_y = -1.0;
+    bool cursor_on_globe = false;
+    Geodetic cursor_position = {};
+
+    void run();
+    // Returns true if anything visible changed
+    bool update();
+    void publish();
+    // Returns true if what the cursor points at changed
+    bool pick_cursor();
+    // Length of the tangent from radius to the occluder
+    double horizon_distance(double radius) const;
+    // Level of detail of a patch at distance, pixel_scale is pixels per
+    // meter at one meter from the camera
+    void select_lod(const PatchBounds &bounds, double distance, double pixel_scale, uint32_t &lod, float &morph) const;
+public:
+    // depth selects the projection, it has to match how the renderer sets up depth
+    // The picker has to outlive the simulation
+    Simulation(Input &input, TripleBuffer<FrameState> &frames, std::vector<PatchBounds> earth_patches, const Picker &picker, depth_mode depth, void (*notify)());
+    ~Simulation();
+
+    // Publishes the initial frame synchronously, then starts the update thread
+    void start();
+    void stop();
+};
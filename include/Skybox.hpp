@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+
+#include <glad/glad.h>
+
+#include "Profiler.hpp"
+#include "RenderState.hpp"
+#include "Texture.hpp"
+
+/*
+    Background drawn as one full-screen triangle on the far plane, sampling
+    a cube map. Draw it after opaque geometry: the depth test rejects every
+    covered pixel before it is shaded. Needs a program built from
+    shaders/skybox.vert and shaders/skybox.frag and get_render_state().
+    Assumes an OpenGL context is current on construction, drawing and
+    destruction.
+*/
+class Skybox
+{
+private:
+    // Core profile draws need a VAO, even without vertex attributes
+    GLuint vao = 0;
+    Texture texture;
+public:
+    Skybox();
+    ~Skybox();
+
+    Skybox(const Skybox&) = delete;
+    Skybox &operator=(const Skybox&) = delete;
+
+    // Converts an equirectangular panorama, LOAD_TEXTURE_* status
+    int load(std::string path, int face_size);
+    void draw() const;
+
+    // The triangle is exactly at the cleared far depth, nothing is behind it
+    static RenderState get_render_state(depth_mode mode);
+};
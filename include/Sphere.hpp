@@ -1,19 +1,21 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
-#include <glad/glad.h>
 #include <glm/glm.hpp>
 
 #include "Constants.hpp"
+#include "Profiler.hpp"
 
-static const double PI = 3.14159265358979323846264338327950288;
 static const uint64_t SPHERE_MINIMUM_STACK_COUNT = 2;
 static const uint64_t SPHERE_MINIMUM_SECTOR_COUNT = 3;
 
 /*
-    Creates a sphere of any radius.
+    Creates the geometry of a sphere of any radius. GL-free, use a Mesh to
+    upload it. Triangles are counter-clockwise seen from outside, GL's
+    default front face, so back faces can be culled.
     Notations according to https://www.songho.ca/opengl/gl_sphere.html
 */
 class Sphere
@@ -34,37 +36,19 @@ private:
     std::vector<float> texcoords;
     // NOTE: You can get the number of triangles
     // to draw by dividing this size() by 3
-    std::vector<GLuint> indices;
-
-    /* OPENGL */
-    // Assume the following:
-    // An OpenGL context is set up
-    // A shader program is loaded
-    // A VAO is set up
-    // A texture is applied
-    // Only load the VAO, VBOs and EBO and call the glDrawElements function
-    GLuint vbo[2] = { 0, 0 };
-    GLuint ebo;
-
-    void generate();
-    void generate_gl();
+    std::vector<uint32_t> indices;
 public:
     Sphere(glm::vec3 center, float radius, uint64_t stack_count, uint64_t sector_count);
-    ~Sphere();
 
-    inline GLuint get_vertex_vbo() const {
-        return vbo[0];
-    }
-
-    inline GLuint get_texcoord_vbo() const {
-        return vbo[1];
+    inline bool is_initialized() const {
+        return initialized;
     }
 
     const std::vector<float> &get_vertices() const {
         return vertices;
     }
     
-    const std::vector<GLuint> &get_indices() const {
+    const std::vector<uint32_t> &get_indices() const {
         return indices;
     }
 
@@ -72,6 +56,6 @@ public:
         return texcoords;
     }
 
-    void draw() const;
+    void generate();
     void log_coords() const;
 };
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+/*
+    Hierarchical cells on the unit sphere, like S2. The sphere is projected
+    onto the six faces of a cube, each face is a quadtree down to level 30
+    (about a centimeter on the earth) and the cells of a face are numbered
+    along a Hilbert curve. A cell id is a 64 bit integer:
+
+        face (3 bits) | Hilbert position (2 bits per level) | 1 | zeros
+
+    so the ids of all cells inside a cell form the contiguous range
+    [cell_range_min(id), cell_range_max(id)], and sorting points by their
+    leaf cell id keeps nearby points close together. Faces are numbered and
+    oriented like S2 (face 0 is +X, 1 is +Y, 2 is +Z, 3 is -X, ...) and use
+    its quadratic projection, which keeps cells of one level within a
+    factor of about 2 in area. Unlike S2 every face uses the same Hilbert
+    orientation, so the curve is not continuous from face to face.
+*/
+
+static const int CELL_MAX_LEVEL = 30;
+
+// Cap of all directions within angle (radians) of axis (unit length)
+struct SphereCap
+{
+    glm::dvec3 axis;
+    double angle;
+
+    inline bool contains(const glm::dvec3 &direction) const {
+        return glm::dot(axis, direction) >= std::cos(angle);
+    }
+
+    // Everything a camera at position can see of a sphere of radius,
+    // including terrain up to max_height above it
+    static SphereCap horizon(const glm::dvec3 &position, double radius, double max_height = 0.0);
+};
+
+// Angle between two directions, also accurate when they are almost equal
+inline double sphere_angle(const glm::dvec3 &a, const glm::dvec3 &b)
+{
+    return std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b));
+}
+
+// Position on a face in [-1, 1] of one in [0, 1], which the cells of
+// every level divide evenly. The inverse of the quadratic projection.
+double cell_uv_from_st(double s);
+
+uint64_t cell_from_face_ij(int face, uint32_t i, uint32_t j, int level);
+// Leaf cell of a direction, which does not have to be normalized
+uint64_t cell_from_point(const glm::dvec3 &direction);
+
+inline int cell_face(uint64_t id)
+{
+    return (int) (id >> 61);
+}
+
+// Lowest set bit, 1 << 2 * (30 - level)
+inline uint64_t cell_lsb(uint64_t id)
+{
+    return id & (~id + 1);
+}
+
+inline int cell_level(uint64_t id)
+{
+    int level = CELL_MAX_LEVEL;
+    for (uint64_t lsb = cell_lsb(id); lsb > 1; lsb >>= 2) {
+        level--;
+    }
+    return level;
+}
+
+// Ancestor at a coarser level
+inline uint64_t cell_parent(uint64_t id, int level)
+{
+    uint64_t lsb = (uint64_t) 1 << (2 * (CELL_MAX_LEVEL - level));
+    return (id & (~lsb + 1)) | lsb;
+}
+
+// Children in Hilbert order, position 0 to 3
+inline uint64_t cell_child(uint64_t id, int position)
+{
+    uint64_t lsb = cell_lsb(id) >> 2;
+    return id - 3 * lsb + 2 * (uint64_t) position * lsb;
+}
+
+// Smallest and largest leaf id inside the cell
+inline uint64_t cell_range_min(uint64_t id)
+{
+    return id - (cell_lsb(id) - 1);
+}
+
+inline uint64_t cell_range_max(uint64_t id)
+{
+    return id + (cell_lsb(id) - 1);
+}
+
+// Face and i, j of the cell's corner with the smallest coordinates, in
+// leaf cells
+void cell_to_face_ij(uint64_t id, int &face, uint32_t &i, uint32_t &j);
+// Unit direction through the center of the cell
+glm::dvec3 cell_center(uint64_t id);
+// Smallest cap around cell_center() that contains the whole cell
+SphereCap cell_bound(uint64_t id);
+
+// Coarsest level whose cells are at most about angle across
+int cell_level_for_angle(double angle);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+#include "Profiler.hpp"
+
+// Fixed with layout(binding) in shaders/transforms.glsl. Storage buffer
+// bindings are separate from uniform buffer bindings.
+static const GLuint DRAW_OBJECT_STORAGE_BINDING = 0;
+
+/*
+    Shader storage buffer rewritten as a whole every frame, e.g. with one
+    std430 array element per draw of a multi draw. Unlike uniform buffers
+    there is no size limit worth mentioning and shaders can index it with
+    gl_DrawID. Assumes an OpenGL context is current on construction, use
+    and destruction.
+*/
+class StorageBuffer
+{
+private:
+    GLuint buffer = 0;
+    GLuint binding = 0;
+public:
+    StorageBuffer(GLuint binding);
+    ~StorageBuffer();
+
+    StorageBuffer(const StorageBuffer&) = delete;
+    StorageBuffer &operator=(const StorageBuffer&) = delete;
+
+    // Orphans the buffer, uploads size bytes and binds it
+    void upload(const void *data, size_t size);
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Constants.hpp"
+#include "MappedFile.hpp"
+#include "Profiler.hpp"
+
+/*
+    Elevation from SRTM .hgt tiles on local disk. Each tile covers one
+    degree of latitude and longitude and is named after its south west
+    corner, e.g. N46E007.hgt. Samples are big-endian int16 meters, rows from
+    north to south, with the edges shared between neighbouring tiles
+    (1201x1201 for SRTM3, 3601x3601 for SRTM1).
+
+    Tiles are memory mapped, not read, so loading a directory is cheap and
+    sampling only pages in what is touched. Sampling is read-only and safe
+    from several threads. Without tiles, or outside of them, the height
+    is 0.
+
+    For ray marching, every tile gets a quadtree of the minimum and maximum
+    height of blocks of samples, built on first use. clearance() walks it
+    from the top and tells how far a ray can go without reaching the
+    ground: past a whole block the ray stays above, otherwise down into the
+    blocks it dips into, and only half a sample at a time where it meets a
+    leaf.
+*/
+class Terrain
+{
+private:
+    static const int16_t VOID_SAMPLE = -32768;
+
+    struct HeightRange
+    {
+        int16_t min;
+        int16_t max;
+    };
+
+    struct Tile
+    {
+        MappedFile file;
+        // Samples per row and column
+        int side = 0;
+        // Blocks of TERRAIN_TREE_LEAF sample intervals, then 2x2 of those
+        // per level up to one block, row by row from the north
+        mutable std::vector<std::vector<HeightRange>> tree;
+        mutable std::vector<int> tree_sides;
+        mutable std::once_flag tree_built;
+    };
+
+    // By (lat + 90) * 360 + (lon + 180) of the south west corner in degrees
+    std::unordered_map<int, std::unique_ptr<Tile>> tiles;
+
+    static int tile_key(int lat, int lon);
+    // Parses N46E007 style names into the south west corner
+    static bool parse_tile_name(const std::string &name, int &lat, int &lon);
+    static double get_sample(const Tile &tile, int row, int column);
+    static void build_tree(const Tile &tile);
+    // Tile containing a position in degrees, nullptr without one. Wraps
+    // lon_degrees into [-180, 180).
+    const Tile *find_tile(double lat_degrees, double &lon_degrees, int &tile_lat, int &tile_lon) const;
+public:
+    Terrain() = default;
+
+    // Maps every .hgt file of directory, returns the number of tiles
+    size_t load_directory(std::string directory);
+
+    inline size_t get_tile_count() const {
+        return tiles.size();
+    }
+
+    // Bilinear height in meters, geodetic latitude and longitude in radians
+    double sample(double lat, double lon) const;
+    // Distance in meters a ray through a point at height above (lat, lon)
+    // can go and stay above sample(), or half a sample where it meets a
+    // leaf of the tree. slope is the change of the ray's height per meter
+    // along it at the point, the height is convex along a straight ray so
+    // it never falls faster further on.
+    double clearance(double lat, double lon, double height, double slope) const;
+};
@@ -2,20 +2,32 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include <glad/glad.h>
 
+#include "Image.hpp"
+#include "Profiler.hpp"
+
 static const int LOAD_TEXTURE_SUCCESS = 0;
 static const int LOAD_TEXTURE_FAILURE = 1;
 
 class Texture {
 private:
     GLuint texture = 0;
+    // GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP, set by the upload
+    GLenum target = GL_TEXTURE_2D;
 public:
     Texture() = default;
     ~Texture();
 
     // Calls use()
     int load_texture(std::string path);
+    // Calls use(), generates the mipmap on the GPU
+    void upload(const Image &image);
+    // Calls use(), converts an equirectangular panorama to a cube map
+    int load_cube_map(std::string path, int face_size);
+    // Calls use(), faces in GL order +X, -X, +Y, -Y, +Z, -Z
+    void upload_cube(const std::vector<Image> &faces);
     void use() const;
 };
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Profiler.hpp"
+
+/*
+    Fixed set of worker threads sharing one task queue.
+    shared() is sized to the hardware concurrency, so batch jobs use every
+    core without any setup.
+*/
+class ThreadPool
+{
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+
+    void work(size_t index);
+public:
+    // 0 threads means one per hardware thread
+    ThreadPool(size_t thread_count = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool &operator=(const ThreadPool&) = delete;
+
+    static ThreadPool &shared();
+
+    inline size_t get_thread_count() const {
+        return workers.size();
+    }
+
+    std::future<void> submit(std::function<void()> task);
+
+    // Calls body(begin, end) on chunks of [0, count) of at least grain
+    // elements and returns once all chunks are done. The calling thread
+    // works on chunks as well, so this may be called from a worker.
+    void parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)> &body);
+};
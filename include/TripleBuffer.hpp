@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/*
+    Lock-free single producer, single consumer triple buffer.
+    The producer always has a slot to write into, the consumer always has a
+    slot to read from, and the third slot is handed over between the two
+    with a single atomic exchange. Neither side ever waits on the other;
+    if the producer publishes faster than the consumer reads, intermediate
+    states are simply replaced by newer ones.
+*/
+template<typename T>
+class TripleBuffer
+{
+private:
+    // Lower bits hold the slot index, this bit marks unread data
+    static const uint8_t DIRTY = 0x4;
+    static const uint8_t INDEX_MASK = 0x3;
+
+    T slots[3];
+
+    // Only touched by the producer
+    uint8_t back = 0;
+    // Shared between both sides
+    std::atomic<uint8_t> middle{ 1 };
+    // Only touched by the consumer
+    uint8_t front = 2;
+public:
+    /* PRODUCER */
+
+    T &write_buffer() {
+        return slots[back];
+    }
+
+    void publish() {
+        uint8_t prev = middle.exchange(back | DIRTY, std::memory_order_acq_rel);
+        back = prev & INDEX_MASK;
+    }
+
+    /* CONSUMER */
+
+    // Returns true if a new state has been published since the last call
+    bool fetch() {
+        if (!(middle.load(std::memory_order_relaxed) & DIRTY)) {
+            return false;
+        }
+        uint8_t prev = middle.exchange(front, std::memory_order_acq_rel);
+        front = prev & INDEX_MASK;
+        return true;
+    }
+
+    const T &read_buffer() const {
+        return slots[front];
+    }
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Profiler.hpp"
+
+// Fixed with layout(binding) in shaders/transforms.glsl
+static const GLuint FRAME_UNIFORM_BINDING = 0;
+static const GLuint OBJECT_UNIFORM_BINDING = 1;
+
+// std140 layout of the Frame block, vec3 is padded to a vec4
+struct FrameUniforms
+{
+    // Rotation only, the camera is at the origin
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::mat4 view_proj;
+    // Camera position split with split_double()
+    glm::vec4 camera_high;
+    glm::vec4 camera_low;
+    float time;
+    float log_depth_coefficient;
+    // In pixels, for sizes given in pixels
+    glm::vec2 viewport_size;
+    // Camera position in the globe's model space, split like camera_high
+    glm::vec4 earth_camera_high;
+    glm::vec4 earth_camera_low;
+};
+
+// std140 layout of the Object block
+struct ObjectUniforms
+{
+    glm::mat4 model;
+    // World position of the mesh origin split with split_double()
+    glm::vec4 center_high;
+    glm::vec4 center_low;
+    // See GlobePatch, the level is compared to the morph attribute
+    float morph_factor;
+    float lod_level;
+    float padding[2];
+};
+
+// Represents a double as the sum of two floats. Subtracting the high and
+// low parts separately on the GPU keeps about 46 bits of the mantissa.
+inline void split_double(const glm::dvec3 &value, glm::vec4 &high, glm::vec4 &low)
+{
+    glm::vec3 value_high = glm::vec3(value);
+    high = glm::vec4(value_high, 0.0f);
+    low = glm::vec4(glm::vec3(value - glm::dvec3(value_high)), 0.0f);
+}
+
+/*
+    Uniform buffer holding an array of equally sized blocks, each starting at
+    a multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT. All blocks are written
+    with a single upload per frame, then bind() selects the one a draw uses.
+    Shared by every program, so switching programs needs no uniform calls.
+    Assumes an OpenGL context is current on construction, use and destruction.
+*/
+class UniformBuffer
+{
+private:
+    GLuint buffer = 0;
+    GLuint binding = 0;
+    size_t block_size = 0;
+    size_t stride = 0;
+    std::vector<uint8_t> staging;
+public:
+    UniformBuffer(GLuint binding, size_t block_size);
+    ~UniformBuffer();
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer &operator=(const UniformBuffer&) = delete;
+
+    // Copies block index into the staging memory, grows it if needed
+    void set(size_t index, const void *data);
+    // Orphans the buffer and uploads blocks [0, count). Blocks never set
+    // are zero, others keep what was set last.
+    void upload(size_t count);
+    void bind(size_t index) const;
+};
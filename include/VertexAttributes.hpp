@@ -0,0 +1,9 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Fixed with layout qualifiers in the vertex shaders of the globe, shared by
+// Mesh and PatchPool
+static const GLint POS_ATTR_LOCATION = 0;
+static const GLint TEX_ATTR_LOCATION = 1;
+static const GLint MORPH_ATTR_LOCATION = 2;
@@ -2,11 +2,91 @@
 
 in vec2 immediate_texcoord;
 
+#if defined(ATMOSPHERE) || defined(NIGHT_LIGHTS)
+in vec3 immediate_normal;
+in vec3 immediate_view_dir;
+#endif
+
 out vec4 color;
 
+#ifdef TEXTURE_ARRAY
+uniform sampler2DArray sampler_2d;
+uniform float layer = 0.0;
+#else
 uniform sampler2D sampler_2d;
+#endif
+
+#ifdef NIGHT_LIGHTS
+layout(binding = 1) uniform sampler2D night_sampler;
+uniform vec3 sun_direction = vec3(1.0, 0.0, 0.0);
+#endif
+
+#ifdef HEATMAP
+in vec3 immediate_model_dir;
+// One layer per face, see HeatmapTexture
+layout(binding = 2) uniform sampler2DArray heatmap_sampler;
+const float HEATMAP_OPACITY = 0.7;
+
+// Face and (s, t) of a direction, the projection of SphereCell
+vec3 heatmap_coord(vec3 p)
+{
+    vec3 a = abs(p);
+    bool on_x = a.x >= a.y && a.x >= a.z;
+    bool on_y = !on_x && a.y >= a.z;
+    float major = on_x ? p.x : (on_y ? p.y : p.z);
+    vec2 ab = on_x ? p.yz : (on_y ? vec2(-p.x, p.z) : vec2(-p.x, -p.y));
+    // Negative faces swap u and v
+    vec2 uv = (major >= 0.0 ? ab : ab.yx) / major;
+    float face = (on_x ? 0.0 : (on_y ? 1.0 : 2.0)) + (major >= 0.0 ? 0.0 : 3.0);
+    vec2 half_st = 0.5 * sqrt(1.0 + 3.0 * abs(uv));
+    vec2 st = mix(1.0 - half_st, half_st, step(0.0, uv));
+    return vec3(st, face);
+}
+
+// Blue through green and yellow to red
+vec3 heatmap_color(float heat)
+{
+    return clamp(vec3(2.0 * heat - 0.5, 2.0 - abs(4.0 * heat - 2.0), 1.5 - 2.0 * heat), 0.0, 1.0);
+}
+#endif
+
+#ifdef ATMOSPHERE
+const vec3 ATMOSPHERE_COLOR = vec3(0.35, 0.55, 1.0);
+#endif
 
 void main()
 {
+#ifdef WIREFRAME
+    color = vec4(1.0);
+#else
+
+#ifdef TEXTURE_ARRAY
+    color = texture(sampler_2d, vec3(immediate_texcoord, layer));
+#else
     color = texture(sampler_2d, immediate_texcoord);
+#endif
+
+#if defined(ATMOSPHERE) || defined(NIGHT_LIGHTS)
+    vec3 normal = normalize(immediate_normal);
+#endif
+
+#ifdef NIGHT_LIGHTS
+    float day = smoothstep(-0.1, 0.1, dot(normal, sun_direction));
+    vec3 night = texture(night_sampler, immediate_texcoord).rgb;
+    color.rgb = mix(night, color.rgb, day);
+#endif
+
+#ifdef HEATMAP
+    // Log scaled density, cells without events stay clear
+    float heat = texture(heatmap_sampler, heatmap_coord(immediate_model_dir)).r;
+    color.rgb = mix(color.rgb, heatmap_color(heat), smoothstep(0.0, 0.1, heat) * HEATMAP_OPACITY);
+#endif
+
+#ifdef ATMOSPHERE
+    // Glow towards the limb, where we look through more air
+    float rim = 1.0 - max(dot(normal, normalize(immediate_view_dir)), 0.0);
+    color.rgb += ATMOSPHERE_COLOR * pow(rim, 3.0);
+#endif
+
+#endif
 }
@@ -0,0 +1,27 @@
+#version 460 core
+
+in vec2 immediate_texcoord;
+
+uniform sampler2D atlas_sampler;
+// Pixels of distance per unit of the stored value, see GlyphAtlas
+uniform float distance_scale = 5.25;
+// Width of the halo around the text in pixels
+uniform float halo_width = 1.5;
+uniform vec4 text_color = vec4(1.0);
+uniform vec4 halo_color = vec4(0.0, 0.0, 0.0, 0.75);
+
+out vec4 color;
+
+void main()
+{
+    // Signed distance to the outline in pixels, positive inside, each edge
+    // fades out over one pixel
+    float distance = (texture(atlas_sampler, immediate_texcoord).r - 0.5) * distance_scale;
+    float text = clamp(distance + 0.5, 0.0, 1.0);
+    float halo = clamp(distance + halo_width + 0.5, 0.0, 1.0) * halo_color.a;
+    float alpha = text * text_color.a + (1.0 - text * text_color.a) * halo;
+    if (alpha <= 0.0) {
+        discard;
+    }
+    color = vec4(mix(halo_color.rgb, text_color.rgb, text * text_color.a / alpha), alpha);
+}
@@ -0,0 +1,23 @@
+#version 460 core
+
+#include "transforms.glsl"
+
+// Per instance, see GlyphInstance. The quad in window pixels and its
+// texels in the atlas.
+layout(location = 0) in vec4 rect_attr;
+layout(location = 1) in vec4 texels_attr;
+
+uniform sampler2D atlas_sampler;
+
+out vec2 immediate_texcoord;
+
+void main()
+{
+    // Triangle strip of four vertices, no vertex buffer needed
+    vec2 corner = vec2(gl_VertexID & 1, (gl_VertexID >> 1) & 1);
+
+    vec2 pixel = mix(rect_attr.xy, rect_attr.zw, corner);
+    gl_Position = vec4(pixel / viewport_size * 2.0 - 1.0, 0.0, 1.0);
+
+    immediate_texcoord = mix(texels_attr.xy, texels_attr.zw, corner) / vec2(textureSize(atlas_sampler, 0));
+}
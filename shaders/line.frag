@@ -0,0 +1,18 @@
+#version 460 core
+
+in float immediate_edge;
+
+uniform float line_width = 1.5;
+uniform vec4 line_color = vec4(1.0);
+
+out vec4 color;
+
+void main()
+{
+    // Fades out over the last pixel of either side
+    float coverage = clamp(0.5 * line_width + 0.5 - abs(immediate_edge), 0.0, 1.0);
+    if (coverage <= 0.0) {
+        discard;
+    }
+    color = vec4(line_color.rgb, line_color.a * coverage);
+}
@@ -0,0 +1,90 @@
+#version 460 core
+
+#include "transforms.glsl"
+
+// Two consecutive LineVertex of the same buffer per instance, the start
+// and the end of one segment. Relative to the origin of their chunk.
+layout(location = 0) in vec3 start_attr;
+layout(location = 1) in uint start_chunk_attr;
+layout(location = 2) in vec3 end_attr;
+layout(location = 3) in uint end_chunk_attr;
+
+// See LineChunk, origins in the globe's model space
+struct LineChunk
+{
+    vec4 high;
+    vec4 low;
+};
+
+layout(std430, binding = 1) readonly buffer LineChunks
+{
+    LineChunk chunks[];
+};
+
+// Width in pixels
+uniform float line_width = 1.5;
+
+// Distance from the center line in pixels, for anti-aliasing
+out float immediate_edge;
+
+// Lines are moved this fraction of their distance towards the eye, which
+// keeps them above globe patches that are coarser than the line but does
+// not move them on screen
+const float DEPTH_PULL = 0.005;
+// Segments are clipped where they come this close to the eye plane
+const float MIN_W = 1e-3;
+
+// Position relative to the eye of a vertex, chunk as in LineVertex
+vec3 vertex_relative_to_eye(vec3 position, uint chunk)
+{
+    LineChunk origin = chunks[chunk >> 1];
+    return model_relative_to_eye(origin.high.xyz, origin.low.xyz) + mat3(object.model) * position;
+}
+
+void main()
+{
+    // No segment from the last vertex of a line to the first of the next,
+    // four equal vertices make an empty strip
+    if ((start_chunk_attr & 1u) == 0u) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        immediate_edge = 0.0;
+        return;
+    }
+
+    vec4 clip_start = view_proj * vec4(vertex_relative_to_eye(start_attr, start_chunk_attr) * (1.0 - DEPTH_PULL), 1.0);
+    vec4 clip_end = view_proj * vec4(vertex_relative_to_eye(end_attr, end_chunk_attr) * (1.0 - DEPTH_PULL), 1.0);
+    if (clip_start.w < MIN_W && clip_end.w < MIN_W) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        immediate_edge = 0.0;
+        return;
+    }
+    // Cut the part behind the eye, it would project mirrored
+    if (clip_start.w < MIN_W) {
+        clip_start = mix(clip_start, clip_end, (MIN_W - clip_start.w) / (clip_end.w - clip_start.w));
+    }
+    else if (clip_end.w < MIN_W) {
+        clip_end = mix(clip_end, clip_start, (MIN_W - clip_end.w) / (clip_start.w - clip_end.w));
+    }
+
+    // Triangle strip of four vertices: which end, which side
+    bool at_end = (gl_VertexID & 1) != 0;
+    float side = (gl_VertexID & 2) != 0 ? 1.0 : -1.0;
+
+    vec2 half_viewport = 0.5 * viewport_size;
+    vec2 screen_start = clip_start.xy / clip_start.w * half_viewport;
+    vec2 screen_end = clip_end.xy / clip_end.w * half_viewport;
+    vec2 along = screen_end - screen_start;
+    along = dot(along, along) > 1e-8 ? normalize(along) : vec2(1.0, 0.0);
+    vec2 across = vec2(-along.y, along.x);
+
+    // One more pixel for the anti-aliased edge, and square caps that close
+    // the gaps at the joints
+    float half_width = 0.5 * line_width + 1.0;
+    vec2 offset = (across * side + along * (at_end ? 1.0 : -1.0)) * half_width;
+
+    vec4 clip = at_end ? clip_end : clip_start;
+    clip.xy += offset / half_viewport * clip.w;
+    gl_Position = encode_depth(clip);
+
+    immediate_edge = side * half_width;
+}
@@ -0,0 +1,16 @@
+#version 460 core
+
+in vec4 immediate_color;
+in vec2 immediate_corner;
+
+out vec4 color;
+
+void main()
+{
+    // Round markers, with a darker rim so neighbours stay apart
+    float radius = dot(immediate_corner, immediate_corner);
+    if (radius > 1.0) {
+        discard;
+    }
+    color = vec4(immediate_color.rgb * (radius > 0.5 ? 0.6 : 1.0), immediate_color.a);
+}
@@ -0,0 +1,29 @@
+#version 460 core
+
+#include "transforms.glsl"
+
+// Per instance, see MarkerInstance. In the globe's model space.
+layout(location = 0) in vec3 position_high_attr;
+layout(location = 1) in vec3 position_low_attr;
+layout(location = 2) in vec4 color_attr;
+
+// Width in pixels
+uniform float marker_size = 4.0;
+
+out vec4 immediate_color;
+// -1 to 1 across the square
+out vec2 immediate_corner;
+
+void main()
+{
+    // Triangle strip of four vertices, no vertex buffer needed
+    vec2 corner = vec2(gl_VertexID & 1, (gl_VertexID >> 1) & 1) * 2.0 - 1.0;
+
+    vec4 clip = view_proj * vec4(model_relative_to_eye(position_high_attr, position_low_attr), 1.0);
+    // Same size in pixels at any distance
+    clip.xy += corner * marker_size / viewport_size * clip.w;
+    gl_Position = encode_depth(clip);
+
+    immediate_color = color_attr;
+    immediate_corner = corner;
+}
@@ -0,0 +1,12 @@
+#version 460 core
+
+in vec3 immediate_direction;
+
+out vec4 color;
+
+uniform samplerCube sky_sampler;
+
+void main()
+{
+    color = texture(sky_sampler, normalize(immediate_direction));
+}
@@ -0,0 +1,20 @@
+#version 460 core
+
+#include "transforms.glsl"
+
+// Sky directions in the orientation given by the model matrix
+out vec3 immediate_direction;
+
+void main()
+{
+    // One triangle covering the screen, no vertex buffer needed
+    vec2 ndc = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+    // On the far plane, so the depth test only lets it through where
+    // nothing else was drawn
+    gl_Position = vec4(ndc, FAR_PLANE_Z, 1.0);
+
+    // Only three vertices, the inverse is cheap here
+    vec4 view_dir = inverse(proj) * vec4(ndc, 1.0, 1.0);
+    vec3 world_dir = transpose(mat3(view)) * (view_dir.xyz / view_dir.w);
+    immediate_direction = transpose(mat3(object.model)) * world_dir;
+}
@@ -0,0 +1,82 @@
+// Written once per frame, see FrameUniforms in UniformBuffer.hpp.
+// Rendering is relative to the eye: view has no translation, positions
+// are doubles split into high and low floats.
+layout(std140, binding = 0) uniform Frame
+{
+    mat4 view;
+    mat4 proj;
+    mat4 view_proj;
+    vec4 camera_high;
+    vec4 camera_low;
+    float time;
+    float log_depth_coefficient;
+    vec2 viewport_size;
+    // Camera in the globe's model space, for positions given there
+    vec4 earth_camera_high;
+    vec4 earth_camera_low;
+};
+
+// One per draw, see ObjectUniforms in UniformBuffer.hpp
+struct ObjectData
+{
+    mat4 model;
+    vec4 center_high;
+    vec4 center_low;
+    float morph_factor;
+    float lod_level;
+};
+
+#ifdef MULTI_DRAW
+// One element per draw of a multi draw, std430 gives the same layout.
+// Only in vertex shaders, gl_DrawID does not exist elsewhere.
+layout(std430, binding = 0) readonly buffer DrawObjects
+{
+    ObjectData draw_objects[];
+};
+#define object draw_objects[gl_DrawID]
+#else
+layout(std140, binding = 1) uniform Object
+{
+    ObjectData object;
+};
+#endif
+
+// Normalized device z of the far plane, where the skybox is drawn
+#ifdef REVERSED_Z
+const float FAR_PLANE_Z = 0.0;
+#else
+const float FAR_PLANE_Z = 1.0;
+#endif
+
+// Applies the depth mode to a clip space position, see depth_mode in
+// Camera.hpp. Reversed-Z needs nothing here, it is all in proj.
+vec4 encode_depth(vec4 clip)
+{
+#ifdef LOG_DEPTH
+    clip.z = (log2(max(1e-6, 1.0 + clip.w)) * log_depth_coefficient - 1.0) * clip.w;
+#endif
+    return clip;
+}
+
+// Position relative to the eye of a vertex given relative to the mesh
+// origin. The big parts cancel in the first differences, so no precision is
+// lost, and precise keeps the compiler from reordering them.
+vec3 relative_to_eye(vec3 position)
+{
+    precise vec3 high = object.center_high.xyz - camera_high.xyz;
+    precise vec3 low = object.center_low.xyz - camera_low.xyz;
+    precise vec3 center = high + low;
+    return center + mat3(object.model) * position;
+}
+
+// Position relative to the eye of a point in the globe's model space, split
+// into high and low parts like the camera. For objects whose model is the
+// globe's and whose center is the origin. Only the difference to the camera
+// is rotated, it is small where precision matters.
+vec3 model_relative_to_eye(vec3 high, vec3 low)
+{
+    precise vec3 high_difference = high - earth_camera_high.xyz;
+    precise vec3 low_difference = low - earth_camera_low.xyz;
+    precise vec3 difference = high_difference + low_difference;
+    return mat3(object.model) * difference;
+}
@@ -1,16 +1,42 @@
 #version 460 core
 
-in vec3 pos_attr;
-in vec2 tex_attr;
+#include "transforms.glsl"
+
+layout(location = 0) in vec3 pos_attr;
+layout(location = 1) in vec2 tex_attr;
+// Offset to the position in the next coarser level and the level in which
+// the vertex morphs, see GlobePatch. (0, 0, 0, 1) for meshes without it.
+layout(location = 2) in vec4 morph_attr;
 
 out vec2 immediate_texcoord;
 
-uniform mat4 model = mat4(1.0);
-uniform mat4 view = mat4(1.0);
-uniform mat4 proj = mat4(1.0);
+#if defined(ATMOSPHERE) || defined(NIGHT_LIGHTS)
+out vec3 immediate_normal;
+out vec3 immediate_view_dir;
+#endif
+
+#ifdef HEATMAP
+// Direction from the center in the globe's model space, where the
+// heatmap cells are
+out vec3 immediate_model_dir;
+#endif
 
 void main()
 {
-    gl_Position = proj * view * model * vec4(pos_attr, 1.0);
+    vec3 pos = pos_attr + morph_attr.xyz * (morph_attr.w == object.lod_level ? object.morph_factor : 0.0);
+    vec3 eye_pos = relative_to_eye(pos);
+    gl_Position = encode_depth(view_proj * vec4(eye_pos, 1.0));
     immediate_texcoord = tex_attr;
+
+#if defined(ATMOSPHERE) || defined(NIGHT_LIGHTS)
+    // The earth is centered at the origin, so the world position is the
+    // normal. Only the direction matters, float precision is enough here.
+    immediate_normal = eye_pos + camera_high.xyz;
+    immediate_view_dir = -eye_pos;
+#endif
+
+#ifdef HEATMAP
+    // The model is a rotation, its inverse is the transpose
+    immediate_model_dir = transpose(mat3(object.model)) * (eye_pos + camera_high.xyz);
+#endif
 }
@@ -0,0 +1,93 @@
+#include "Camera.hpp"
+
+Camera::Camera(double surface_radius, double min_altitude, double max_distance)
+    : distance(2.0 * surface_radius), surface_radius(surface_radius),
+      min_altitude(min_altitude), max_distance(max_distance)
+{
+    update_view();
+    update_proj();
+}
+
+void Camera::update_view()
+{
+    view_transform = glm::lookAt(
+        glm::dvec3(distance, 0.0, 0.0),
+        glm::dvec3(0.0, 0.0, 0.0),
+        glm::dvec3(0.0, 0.0, 1.0)
+    );
+    // Rotation only, the translation is applied in double precision
+    view_rotation = glm::mat4(glm::mat3(glm::dmat3(view_transform)));
+}
+
+void Camera::update_proj()
+{
+    if (depth == DEPTH_LOGARITHMIC) {
+        // The far plane only matters for the depth scale, nothing is
+        // farther away than the sky radius from the farthest camera
+        proj_transform = glm::perspective(
+            glm::radians(FOV),
+            aspect,
+            CAMERA_NEAR,
+            (float) (2.0 * max_distance)
+        );
+        return;
+    }
+
+    // Infinite far plane with z mapped to near / -z_view, depth is 1 at the
+    // near plane and 0 at infinity
+    float f = 1.0f / std::tan(glm::radians(FOV) / 2.0f);
+    proj_transform = glm::mat4(0.0f);
+    proj_transform[0][0] = f / aspect;
+    proj_transform[1][1] = f;
+    proj_transform[2][3] = -1.0f;
+    proj_transform[3][2] = CAMERA_NEAR;
+}
+
+void Camera::set_depth_mode(depth_mode mode)
+{
+    depth = mode;
+    update_proj();
+}
+
+bool Camera::set_surface_radius(double radius)
+{
+    surface_radius = radius;
+    if (distance >= surface_radius + min_altitude) {
+        return false;
+    }
+
+    distance = surface_radius + min_altitude;
+    update_view();
+    return true;
+}
+
+bool Camera::zoom(float delta)
+{
+    if (delta == 0.0f) {
+        return false;
+    }
+
+    double altitude = std::max((distance - surface_radius) * std::exp((double) delta), min_altitude);
+    double new_distance = surface_radius + altitude;
+    if (new_distance == distance || new_distance >= max_distance) {
+        return false;
+    }
+
+    distance = new_distance;
+    update_view();
+    return true;
+}
+
+void Camera::set_viewport(int width, int height)
+{
+    aspect = (float) width / (float) height;
+    update_proj();
+}
+
+glm::dvec3 Camera::get_ray_direction(double x, double y) const
+{
+    // Symmetric frustum, so the projection only scales x and y by depth
+    glm::dvec3 view_direction(x / proj_transform[0][0], y / proj_transform[1][1], -1.0);
+    // The view is a rotation, its inverse is the transpose
+    return glm::normalize(glm::transpose(glm::dmat3(view_transform)) * view_direction);
+}
@@ -0,0 +1,225 @@
+#include "CellIndex.hpp"
+
+#include <limits>
+
+// Leaf cell id and original index, sorted by id
+struct CellEntry
+{
+    uint64_t id;
+    uint32_t index;
+
+    inline bool operator<(const CellEntry &other) const {
+        return id < other.id;
+    }
+};
+
+// Sorts chunks on the pool, then merges neighbouring runs in parallel
+// rounds, back and forth between entries and a buffer of the same size
+static void parallel_sort(std::vector<CellEntry> &entries, ThreadPool &pool)
+{
+    size_t count = entries.size();
+    size_t chunks = 1;
+    while (chunks < pool.get_thread_count() + 1 && count / (chunks * 2) >= GEODETIC_BATCH_GRAIN) {
+        chunks *= 2;
+    }
+    size_t chunk_size = (count + chunks - 1) / chunks;
+
+    pool.parallel_for(chunks, 1, [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; chunk++) {
+            size_t first = std::min(chunk * chunk_size, count);
+            size_t last = std::min(first + chunk_size, count);
+            std::sort(entries.begin() + first, entries.begin() + last);
+        }
+    });
+
+    std::vector<CellEntry> buffer(count);
+    std::vector<CellEntry> *from = &entries;
+    std::vector<CellEntry> *to = &buffer;
+    for (size_t run = chunk_size; run < count; run *= 2) {
+        size_t pairs = (count + 2 * run - 1) / (2 * run);
+        pool.parallel_for(pairs, 1, [&](size_t begin, size_t end) {
+            for (size_t pair = begin; pair < end; pair++) {
+                size_t first = pair * 2 * run;
+                size_t middle = std::min(first + run, count);
+                size_t last = std::min(first + 2 * run, count);
+                std::merge(from->begin() + first, from->begin() + middle,
+                    from->begin() + middle, from->begin() + last, to->begin() + first);
+            }
+        });
+        std::swap(from, to);
+    }
+    if (from != &entries) {
+        entries.swap(buffer);
+    }
+}
+
+Frustum Frustum::from_view_proj(const glm::dmat4 &m)
+{
+    // Rows of the matrix, glm is column major
+    glm::dvec4 rows[4];
+    for (int i = 0; i < 4; i++) {
+        rows[i] = glm::dvec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    }
+
+    Frustum frustum;
+    frustum.planes[0] = rows[3] + rows[0];
+    frustum.planes[1] = rows[3] - rows[0];
+    frustum.planes[2] = rows[3] + rows[1];
+    frustum.planes[3] = rows[3] - rows[1];
+    frustum.planes[4] = rows[3] + rows[2];
+    frustum.planes[5] = rows[3] - rows[2];
+    for (glm::dvec4 &plane : frustum.planes) {
+        double length = glm::length(glm::dvec3(plane));
+        plane = length > 0.0 ? plane / length : glm::dvec4(0.0, 0.0, 0.0, std::numeric_limits<double>::max());
+    }
+    return frustum;
+}
+
+void CellIndex::build(const double *x, const double *y, const double *z, size_t count, ThreadPool &pool)
+{
+    PROFILE_SCOPE("CellIndex::build");
+
+    std::vector<CellEntry> entries(count);
+    pool.parallel_for(count, GEODETIC_BATCH_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            entries[i] = { cell_from_point(glm::dvec3(x[i], y[i], z[i])), (uint32_t) i };
+        }
+    });
+
+    parallel_sort(entries, pool);
+
+    cell_ids.resize(count);
+    point_indices.resize(count);
+    pool.parallel_for(count, GEODETIC_BATCH_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            cell_ids[i] = entries[i].id;
+            point_indices[i] = entries[i].index;
+        }
+    });
+}
+
+void CellIndex::build(const EcefArrays &positions, ThreadPool &pool)
+{
+    build(positions.x.data(), positions.y.data(), positions.z.data(), positions.size(), pool);
+}
+
+template<typename F>
+std::vector<uint64_t> CellIndex::cover(int max_level, F classify) const
+{
+    std::vector<uint64_t> result;
+    std::vector<uint64_t> candidates;
+    for (int face = 0; face < 6; face++) {
+        candidates.push_back(cell_from_face_ij(face, 0, 0, 0));
+    }
+
+    for (int level = 0; !candidates.empty(); level++) {
+        std::vector<uint64_t> children;
+        for (uint64_t cell : candidates) {
+            int relation = classify(cell);
+            if (relation == 0) {
+                continue;
+            }
+            if (relation == 2 || level == max_level) {
+                result.push_back(cell);
+                continue;
+            }
+            for (int position = 0; position < 4; position++) {
+                children.push_back(cell_child(cell, position));
+            }
+        }
+        candidates.swap(children);
+    }
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::vector<uint64_t> CellIndex::cover_cap(const SphereCap &cap, int max_level) const
+{
+    if (max_level < 0) {
+        // Cells about a quarter of the cap, a few dozen of them
+        max_level = std::min(cell_level_for_angle(cap.angle / 2.0), CELL_MAX_LEVEL);
+    }
+
+    return cover(max_level, [&](uint64_t cell) {
+        SphereCap bound = cell_bound(cell);
+        double angle = sphere_angle(bound.axis, cap.axis);
+        if (angle > cap.angle + bound.angle) {
+            return 0;
+        }
+        return angle + bound.angle <= cap.angle ? 2 : 1;
+    });
+}
+
+std::vector<uint64_t> CellIndex::cover_view(const SphereCap &horizon, const Frustum &frustum, double radius, int max_level) const
+{
+    if (max_level < 0) {
+        max_level = std::min(cell_level_for_angle(horizon.angle / 4.0), CELL_MAX_LEVEL);
+    }
+
+    return cover(max_level, [&](uint64_t cell) {
+        SphereCap bound = cell_bound(cell);
+        double angle = sphere_angle(bound.axis, horizon.axis);
+        if (angle > horizon.angle + bound.angle) {
+            return 0;
+        }
+        // Every point of the surface in the cell is within a chord of the
+        // bound of its center
+        double chord = 2.0 * radius * std::sin(std::min(bound.angle, PI) / 2.0);
+        if (!frustum.intersects_sphere(bound.axis * radius, chord)) {
+            return 0;
+        }
+        bool inside = angle + bound.angle <= horizon.angle && frustum.contains_sphere(bound.axis * radius, chord);
+        return inside ? 2 : 1;
+    });
+}
+
+std::vector<std::pair<size_t, size_t>> CellIndex::query_ranges(const std::vector<uint64_t> &cells) const
+{
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for (uint64_t cell : cells) {
+        size_t begin = std::lower_bound(cell_ids.begin(), cell_ids.end(), cell_range_min(cell)) - cell_ids.begin();
+        size_t end = std::upper_bound(cell_ids.begin() + begin, cell_ids.end(), cell_range_max(cell)) - cell_ids.begin();
+        if (begin == end) {
+            continue;
+        }
+        if (!ranges.empty() && ranges.back().second == begin) {
+            ranges.back().second = end;
+        }
+        else {
+            ranges.push_back({ begin, end });
+        }
+    }
+    return ranges;
+}
+
+void CellIndex::query_cap(const SphereCap &cap, std::vector<uint32_t> &out) const
+{
+    PROFILE_SCOPE("CellIndex::query_cap");
+
+    // Compared by chord, accurate for small caps and cheaper than angles
+    double chord = 2.0 * std::sin(std::min(cap.angle, PI) / 2.0);
+    double max_chord2 = chord * chord;
+    for (uint64_t cell : cover_cap(cap)) {
+        size_t begin = std::lower_bound(cell_ids.begin(), cell_ids.end(), cell_range_min(cell)) - cell_ids.begin();
+        size_t end = std::upper_bound(cell_ids.begin() + begin, cell_ids.end(), cell_range_max(cell)) - cell_ids.begin();
+
+        // Points of cells inside the cap need no test
+        SphereCap bound = cell_bound(cell);
+        if (sphere_angle(bound.axis, cap.axis) + bound.angle <= cap.angle) {
+            out.insert(out.end(), point_indices.begin() + begin, point_indices.begin() + end);
+            continue;
+        }
+        for (size_t i = begin; i < end; i++) {
+            glm::dvec3 offset = cell_center(cell_ids[i]) - cap.axis;
+            if (glm::dot(offset, offset) <= max_chord2) {
+                out.push_back(point_indices[i]);
+            }
+        }
+    }
+}
+
+void CellIndex::query_radius(const glm::dvec3 &center, double distance, double sphere_radius, std::vector<uint32_t> &out) const
+{
+    query_cap({ glm::normalize(center), distance / sphere_radius }, out);
+}
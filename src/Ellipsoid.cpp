@@ -0,0 +1,154 @@
+#include "Ellipsoid.hpp"
+
+Ellipsoid::Ellipsoid(double semi_major, double inverse_flattening)
+    : semi_major(semi_major)
+{
+    double flattening = 1.0 / inverse_flattening;
+    semi_minor = semi_major * (1.0 - flattening);
+    e2 = flattening * (2.0 - flattening);
+    ep2 = e2 / (1.0 - e2);
+}
+
+const Ellipsoid &Ellipsoid::wgs84()
+{
+    static const Ellipsoid ellipsoid(WGS84_SEMI_MAJOR_AXIS, WGS84_INVERSE_FLATTENING);
+    return ellipsoid;
+}
+
+glm::dvec3 Ellipsoid::to_ecef(Geodetic geodetic) const
+{
+    double sin_lat = std::sin(geodetic.lat);
+    double cos_lat = std::cos(geodetic.lat);
+    // Prime vertical radius of curvature
+    double n = semi_major / std::sqrt(1.0 - e2 * sin_lat * sin_lat);
+    return glm::dvec3(
+        (n + geodetic.height) * cos_lat * std::cos(geodetic.lon),
+        (n + geodetic.height) * cos_lat * std::sin(geodetic.lon),
+        (n * (1.0 - e2) + geodetic.height) * sin_lat
+    );
+}
+
+Geodetic Ellipsoid::to_geodetic(glm::dvec3 ecef) const
+{
+    double p = std::sqrt(ecef.x * ecef.x + ecef.y * ecef.y);
+
+    // Start from the parametric latitude of the point, then alternate
+    // between geodetic and parametric latitude. Only sin and cos are needed
+    // in between, so they are carried as normalized vectors.
+    double sin_beta = semi_major * ecef.z;
+    double cos_beta = semi_minor * p;
+    double lat_y = 0.0, lat_x = 0.0;
+    for (int i = 0; i < GEODETIC_ITERATIONS; i++) {
+        double length = std::sqrt(sin_beta * sin_beta + cos_beta * cos_beta);
+        sin_beta /= length;
+        cos_beta /= length;
+        lat_y = ecef.z + ep2 * semi_minor * sin_beta * sin_beta * sin_beta;
+        lat_x = p - e2 * semi_major * cos_beta * cos_beta * cos_beta;
+        sin_beta = semi_minor * lat_y;
+        cos_beta = semi_major * lat_x;
+    }
+
+    double length = std::sqrt(lat_y * lat_y + lat_x * lat_x);
+    double sin_lat = lat_y / length;
+    double cos_lat = lat_x / length;
+    return {
+        std::atan2(lat_y, lat_x),
+        std::atan2(ecef.y, ecef.x),
+        // Stable at the poles and the equator, a^2 / N = a sqrt(1 - e^2 sin^2)
+        p * cos_lat + ecef.z * sin_lat - semi_major * std::sqrt(1.0 - e2 * sin_lat * sin_lat)
+    };
+}
+
+glm::dvec3 Ellipsoid::normal(double lat, double lon) const
+{
+    double cos_lat = std::cos(lat);
+    return glm::dvec3(cos_lat * std::cos(lon), cos_lat * std::sin(lon), std::sin(lat));
+}
+
+glm::dvec3 Ellipsoid::from_normal(const glm::dvec3 &normal, double height) const
+{
+    // The z of the normal is the sine of the latitude
+    double n = semi_major / std::sqrt(1.0 - e2 * normal.z * normal.z);
+    return glm::dvec3(
+        (n + height) * normal.x,
+        (n + height) * normal.y,
+        (n * (1.0 - e2) + height) * normal.z
+    );
+}
+
+void Ellipsoid::to_ecef(const double *lat, const double *lon, const double *height,
+    double *x, double *y, double *z, size_t count) const
+{
+    double semi_major = this->semi_major;
+    double e2 = this->e2;
+
+#pragma omp simd
+    for (size_t i = 0; i < count; i++) {
+        double sin_lat, cos_lat, sin_lon, cos_lon;
+        simd_sincos(lat[i], sin_lat, cos_lat);
+        simd_sincos(lon[i], sin_lon, cos_lon);
+        double n = semi_major / std::sqrt(1.0 - e2 * sin_lat * sin_lat);
+        x[i] = (n + height[i]) * cos_lat * cos_lon;
+        y[i] = (n + height[i]) * cos_lat * sin_lon;
+        z[i] = (n * (1.0 - e2) + height[i]) * sin_lat;
+    }
+}
+
+void Ellipsoid::to_geodetic(const double *x, const double *y, const double *z,
+    double *lat, double *lon, double *height, size_t count) const
+{
+    double semi_major = this->semi_major;
+    double semi_minor = this->semi_minor;
+    double e2 = this->e2;
+    double ep2 = this->ep2;
+
+    // Same as the single point version, see there
+#pragma omp simd
+    for (size_t i = 0; i < count; i++) {
+        double p = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+
+        double sin_beta = semi_major * z[i];
+        double cos_beta = semi_minor * p;
+        double lat_y = 0.0, lat_x = 0.0;
+        // Unrolled, loops inside the loop keep it from being vectorized
+#pragma GCC unroll 4
+        for (int j = 0; j < GEODETIC_ITERATIONS; j++) {
+            double length = std::sqrt(sin_beta * sin_beta + cos_beta * cos_beta);
+            sin_beta /= length;
+            cos_beta /= length;
+            lat_y = z[i] + ep2 * semi_minor * sin_beta * sin_beta * sin_beta;
+            lat_x = p - e2 * semi_major * cos_beta * cos_beta * cos_beta;
+            sin_beta = semi_minor * lat_y;
+            cos_beta = semi_major * lat_x;
+        }
+
+        double length = std::sqrt(lat_y * lat_y + lat_x * lat_x);
+        double sin_lat = lat_y / length;
+        double cos_lat = lat_x / length;
+        lat[i] = simd_atan2(lat_y, lat_x);
+        lon[i] = simd_atan2(y[i], x[i]);
+        height[i] = p * cos_lat + z[i] * sin_lat - semi_major * std::sqrt(1.0 - e2 * sin_lat * sin_lat);
+    }
+}
+
+void Ellipsoid::to_ecef(const GeodeticArrays &in, EcefArrays &out, ThreadPool &pool) const
+{
+    PROFILE_SCOPE("Ellipsoid::to_ecef");
+
+    out.resize(in.size());
+    pool.parallel_for(in.size(), GEODETIC_BATCH_GRAIN, [&](size_t begin, size_t end) {
+        to_ecef(&in.lat[begin], &in.lon[begin], &in.height[begin],
+            &out.x[begin], &out.y[begin], &out.z[begin], end - begin);
+    });
+}
+
+void Ellipsoid::to_geodetic(const EcefArrays &in, GeodeticArrays &out, ThreadPool &pool) const
+{
+    PROFILE_SCOPE("Ellipsoid::to_geodetic");
+
+    out.resize(in.size());
+    pool.parallel_for(in.size(), GEODETIC_BATCH_GRAIN, [&](size_t begin, size_t end) {
+        to_geodetic(&in.x[begin], &in.y[begin], &in.z[begin],
+            &out.lat[begin], &out.lon[begin], &out.height[begin], end - begin);
+    });
+}
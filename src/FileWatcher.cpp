@@ -0,0 +1,130 @@
+#include "FileWatcher.hpp"
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+FileWatcher::FileWatcher(std::string directory, void (*notify)())
+    : directory(directory), notify(notify) {}
+
+FileWatcher::~FileWatcher()
+{
+    stop();
+}
+
+void FileWatcher::start()
+{
+    running = true;
+#if defined(__linux__)
+    thread = std::thread(&FileWatcher::run_inotify, this);
+#else
+    thread = std::thread(&FileWatcher::run_polling, this);
+#endif
+}
+
+void FileWatcher::stop()
+{
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void FileWatcher::add_change(std::string path)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const std::string &change : changes) {
+            if (change == path) {
+                return;
+            }
+        }
+        changes.push_back(path);
+    }
+
+    if (notify != nullptr) {
+        notify();
+    }
+}
+
+std::vector<std::string> FileWatcher::take_changes()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> taken;
+    taken.swap(changes);
+    return taken;
+}
+
+#if defined(__linux__)
+void FileWatcher::run_inotify()
+{
+    Profiler::set_thread_name("file watcher");
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        run_polling();
+        return;
+    }
+
+    // Editors often write a temporary file and rename it over the original
+    int watch = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch < 0) {
+        std::cerr << "Could not watch " << directory << "!" << std::endl;
+        close(fd);
+        return;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    while (running) {
+        // Wake up regularly to check whether we should stop
+        pollfd poll_fd = { fd, POLLIN, 0 };
+        if (poll(&poll_fd, 1, FILE_WATCHER_POLL_MS) <= 0) {
+            continue;
+        }
+
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < length; ) {
+            const inotify_event *event = (const inotify_event*) (buffer + offset);
+            if (event->len > 0 && !(event->mask & IN_ISDIR)) {
+                add_change(directory + "/" + event->name);
+            }
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+
+    inotify_rm_watch(fd, watch);
+    close(fd);
+}
+#endif
+
+void FileWatcher::run_polling()
+{
+    Profiler::set_thread_name("file watcher");
+
+    std::map<std::string, std::filesystem::file_time_type> times;
+    bool first = true;
+    while (running) {
+        std::error_code error;
+        for (const auto &entry : std::filesystem::directory_iterator(directory, error)) {
+            if (!entry.is_regular_file(error)) {
+                continue;
+            }
+
+            std::string path = directory + "/" + entry.path().filename().string();
+            std::filesystem::file_time_type time = entry.last_write_time(error);
+            auto known = times.find(path);
+            if (known == times.end() || known->second != time) {
+                times[path] = time;
+                // Only report changes after the initial scan
+                if (!first) {
+                    add_change(path);
+                }
+            }
+        }
+        first = false;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(FILE_WATCHER_POLL_MS));
+    }
+}
@@ -0,0 +1,373 @@
+#include "Font.hpp"
+
+// glyf flags
+static const uint8_t ON_CURVE = 0x01;
+static const uint8_t X_SHORT = 0x02;
+static const uint8_t Y_SHORT = 0x04;
+static const uint8_t REPEAT = 0x08;
+static const uint8_t X_SAME_OR_POSITIVE = 0x10;
+static const uint8_t Y_SAME_OR_POSITIVE = 0x20;
+
+// Composite glyph flags
+static const uint16_t ARGS_ARE_WORDS = 0x0001;
+static const uint16_t ARGS_ARE_XY = 0x0002;
+static const uint16_t HAS_SCALE = 0x0008;
+static const uint16_t MORE_COMPONENTS = 0x0020;
+static const uint16_t HAS_XY_SCALE = 0x0040;
+static const uint16_t HAS_TWO_BY_TWO = 0x0080;
+
+// Accented letters are composites of composites at most a few levels deep
+static const int MAX_COMPOSITE_DEPTH = 8;
+
+uint16_t Font::u16(size_t offset) const
+{
+    if (offset + 2 > size) {
+        return 0;
+    }
+    return (uint16_t) (data[offset] << 8 | data[offset + 1]);
+}
+
+uint32_t Font::u32(size_t offset) const
+{
+    if (offset + 4 > size) {
+        return 0;
+    }
+    return (uint32_t) data[offset] << 24 | (uint32_t) data[offset + 1] << 16 | (uint32_t) data[offset + 2] << 8 | data[offset + 3];
+}
+
+uint32_t Font::find_table(const char *tag) const
+{
+    uint16_t table_count = u16(4);
+    for (uint16_t i = 0; i < table_count; i++) {
+        size_t record = 12 + 16 * (size_t) i;
+        if (record + 16 <= size && std::equal(tag, tag + 4, data + record)) {
+            return u32(record + 8);
+        }
+    }
+    return 0;
+}
+
+int Font::load(std::string path)
+{
+    PROFILE_SCOPE("Font::load");
+
+    if (file.map(path) != MAP_FILE_SUCCESS) {
+        return LOAD_FONT_FAILURE;
+    }
+    data = file.get_data();
+    size = file.get_size();
+
+    uint32_t version = u32(0);
+    if (version != 0x00010000 && version != 0x74727565) {
+        std::cerr << path << " is not a TrueType font" << std::endl;
+        return LOAD_FONT_FAILURE;
+    }
+
+    uint32_t head = find_table("head");
+    uint32_t hhea = find_table("hhea");
+    uint32_t maxp = find_table("maxp");
+    cmap = find_table("cmap");
+    loca = find_table("loca");
+    glyf = find_table("glyf");
+    hmtx = find_table("hmtx");
+    if (head == 0 || hhea == 0 || maxp == 0 || cmap == 0 || loca == 0 || glyf == 0 || hmtx == 0) {
+        std::cerr << path << " has no TrueType outlines" << std::endl;
+        return LOAD_FONT_FAILURE;
+    }
+    glyf_size = (uint32_t) size - glyf;
+
+    units_per_em = u16(head + 18);
+    long_loca = i16(head + 50) != 0;
+    glyph_count = u16(maxp + 4);
+    h_metric_count = u16(hhea + 34);
+    if (units_per_em == 0 || h_metric_count == 0) {
+        std::cerr << path << " has invalid metrics" << std::endl;
+        return LOAD_FONT_FAILURE;
+    }
+    ascent = (float) i16(hhea + 4) / units_per_em;
+    descent = (float) i16(hhea + 6) / units_per_em;
+
+    return LOAD_FONT_SUCCESS;
+}
+
+uint16_t Font::glyph_index(uint32_t codepoint) const
+{
+    // Prefer the full Unicode subtable, fall back to the BMP one
+    uint32_t format4 = 0;
+    uint32_t format12 = 0;
+    uint16_t subtable_count = u16(cmap + 2);
+    for (uint16_t i = 0; i < subtable_count; i++) {
+        size_t record = cmap + 4 + 8 * (size_t) i;
+        uint16_t platform = u16(record);
+        uint16_t encoding = u16(record + 2);
+        uint32_t offset = cmap + u32(record + 4);
+        bool unicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+        if (!unicode) {
+            continue;
+        }
+        if (u16(offset) == 12) {
+            format12 = offset;
+        }
+        else if (u16(offset) == 4) {
+            format4 = offset;
+        }
+    }
+
+    if (format12 != 0) {
+        uint32_t group_count = u32(format12 + 12);
+        for (uint32_t i = 0; i < group_count; i++) {
+            size_t group = format12 + 16 + 12 * (size_t) i;
+            uint32_t first = u32(group);
+            uint32_t last = u32(group + 4);
+            if (codepoint >= first && codepoint <= last) {
+                return (uint16_t) (u32(group + 8) + codepoint - first);
+            }
+        }
+        return 0;
+    }
+
+    if (format4 == 0 || codepoint > 0xFFFF) {
+        return 0;
+    }
+    uint16_t segment_count = u16(format4 + 6) / 2;
+    size_t ends = format4 + 14;
+    size_t starts = ends + 2 * (size_t) segment_count + 2;
+    size_t deltas = starts + 2 * (size_t) segment_count;
+    size_t range_offsets = deltas + 2 * (size_t) segment_count;
+    for (uint16_t i = 0; i < segment_count; i++) {
+        if (codepoint > u16(ends + 2 * i)) {
+            continue;
+        }
+        uint16_t start = u16(starts + 2 * i);
+        if (codepoint < start) {
+            return 0;
+        }
+        uint16_t delta = u16(deltas + 2 * i);
+        uint16_t range_offset = u16(range_offsets + 2 * i);
+        if (range_offset == 0) {
+            return (uint16_t) (codepoint + delta);
+        }
+        // Relative to where the offset itself is stored
+        uint16_t glyph = u16(range_offsets + 2 * i + range_offset + 2 * (codepoint - start));
+        return glyph == 0 ? 0 : (uint16_t) (glyph + delta);
+    }
+    return 0;
+}
+
+bool Font::glyph_range(uint16_t glyph, uint32_t &begin, uint32_t &end) const
+{
+    if (glyph >= glyph_count) {
+        return false;
+    }
+    if (long_loca) {
+        begin = u32(loca + 4 * (size_t) glyph);
+        end = u32(loca + 4 * (size_t) glyph + 4);
+    }
+    else {
+        begin = 2 * (uint32_t) u16(loca + 2 * (size_t) glyph);
+        end = 2 * (uint32_t) u16(loca + 2 * (size_t) glyph + 2);
+    }
+    return begin <= end && end <= glyf_size;
+}
+
+bool Font::append_outline(uint16_t glyph, const glm::mat3 &m, float tolerance, GlyphOutline &outline, int depth) const
+{
+    uint32_t begin = 0, end = 0;
+    if (!glyph_range(glyph, begin, end)) {
+        return false;
+    }
+    // Empty, e.g. the space
+    if (begin == end) {
+        return true;
+    }
+
+    size_t offset = glyf + begin;
+    int16_t contour_count = i16(offset);
+
+    if (contour_count < 0) {
+        if (depth >= MAX_COMPOSITE_DEPTH) {
+            return false;
+        }
+        size_t component = offset + 10;
+        uint16_t flags = 0;
+        do {
+            flags = u16(component);
+            uint16_t part = u16(component + 2);
+            component += 4;
+            float dx = 0.0f, dy = 0.0f;
+            if (flags & ARGS_ARE_WORDS) {
+                dx = i16(component);
+                dy = i16(component + 2);
+                component += 4;
+            }
+            else {
+                dx = (int8_t) data[std::min(component, size - 1)];
+                dy = (int8_t) data[std::min(component + 1, size - 1)];
+                component += 2;
+            }
+            // Point matching instead of offsets is rare, placed at the origin
+            if (!(flags & ARGS_ARE_XY)) {
+                dx = dy = 0.0f;
+            }
+
+            glm::mat3 transform(1.0f);
+            if (flags & HAS_SCALE) {
+                transform[0][0] = transform[1][1] = i16(component) / 16384.0f;
+                component += 2;
+            }
+            else if (flags & HAS_XY_SCALE) {
+                transform[0][0] = i16(component) / 16384.0f;
+                transform[1][1] = i16(component + 2) / 16384.0f;
+                component += 4;
+            }
+            else if (flags & HAS_TWO_BY_TWO) {
+                transform[0][0] = i16(component) / 16384.0f;
+                transform[0][1] = i16(component + 2) / 16384.0f;
+                transform[1][0] = i16(component + 4) / 16384.0f;
+                transform[1][1] = i16(component + 6) / 16384.0f;
+                component += 8;
+            }
+            transform[2][0] = dx / units_per_em;
+            transform[2][1] = dy / units_per_em;
+
+            if (!append_outline(part, m * transform, tolerance, outline, depth + 1)) {
+                return false;
+            }
+        } while (flags & MORE_COMPONENTS);
+        return true;
+    }
+
+    // Simple glyph: contour ends, instructions, flags, then x and y deltas
+    size_t ends = offset + 10;
+    uint16_t point_count = contour_count > 0 ? u16(ends + 2 * (size_t) (contour_count - 1)) + 1 : 0;
+    size_t cursor = ends + 2 * (size_t) contour_count;
+    cursor += 2 + u16(cursor);
+
+    std::vector<uint8_t> flags(point_count);
+    for (uint16_t i = 0; i < point_count && cursor < size;) {
+        uint8_t flag = data[cursor++];
+        uint16_t repeat = 1;
+        if ((flag & REPEAT) && cursor < size) {
+            repeat += data[cursor++];
+        }
+        for (; repeat > 0 && i < point_count; repeat--) {
+            flags[i++] = flag;
+        }
+    }
+
+    std::vector<glm::vec2> points(point_count);
+    int value = 0;
+    for (uint16_t i = 0; i < point_count; i++) {
+        if (flags[i] & X_SHORT) {
+            int delta = cursor < size ? data[cursor] : 0;
+            value += (flags[i] & X_SAME_OR_POSITIVE) ? delta : -delta;
+            cursor += 1;
+        }
+        else if (!(flags[i] & X_SAME_OR_POSITIVE)) {
+            value += i16(cursor);
+            cursor += 2;
+        }
+        points[i].x = (float) value;
+    }
+    value = 0;
+    for (uint16_t i = 0; i < point_count; i++) {
+        if (flags[i] & Y_SHORT) {
+            int delta = cursor < size ? data[cursor] : 0;
+            value += (flags[i] & Y_SAME_OR_POSITIVE) ? delta : -delta;
+            cursor += 1;
+        }
+        else if (!(flags[i] & Y_SAME_OR_POSITIVE)) {
+            value += i16(cursor);
+            cursor += 2;
+        }
+        points[i].y = (float) value;
+    }
+    for (glm::vec2 &point : points) {
+        glm::vec3 transformed = m * glm::vec3(point / (float) units_per_em, 1.0f);
+        point = glm::vec2(transformed.x, transformed.y);
+    }
+
+    // Flattens each contour, starting at an on-curve point. Between two
+    // off-curve points lies an implied on-curve one halfway.
+    uint16_t first = 0;
+    for (int16_t contour = 0; contour < contour_count; contour++) {
+        uint16_t last = u16(ends + 2 * (size_t) contour);
+        if (last < first || last >= point_count) {
+            return false;
+        }
+        size_t count = last - first + 1;
+        auto on_curve = [&](size_t k) { return (flags[first + k % count] & ON_CURVE) != 0; };
+        auto point = [&](size_t k) { return points[first + k % count]; };
+
+        size_t start = 0;
+        while (start < count && !on_curve(start)) {
+            start++;
+        }
+        // Without on-curve points the contour starts between the first two,
+        // and the first is the control of the last curve, so it is visited
+        // again before closing
+        glm::vec2 start_point;
+        size_t end = count;
+        if (start < count) {
+            start_point = point(start);
+        }
+        else {
+            start = 0;
+            start_point = 0.5f * (point(0) + point(1));
+            end = count + 1;
+        }
+
+        glm::vec2 current = start_point;
+        glm::vec2 control;
+        bool has_control = false;
+        outline.points.push_back(current);
+        auto curve_to = [&](const glm::vec2 &target) {
+            // A quadratic is off its chords by |p0 - 2 p1 + p2| / (8 n^2)
+            float curvature = glm::length(current - 2.0f * control + target);
+            int steps = std::max(1, (int) std::ceil(std::sqrt(curvature / (8.0f * tolerance))));
+            for (int s = 1; s <= steps; s++) {
+                float t = (float) s / steps;
+                outline.points.push_back((1.0f - t) * (1.0f - t) * current + 2.0f * t * (1.0f - t) * control + t * t * target);
+            }
+            current = target;
+        };
+        // Every other point once, then back to the start
+        for (size_t k = 1; k <= end; k++) {
+            bool on = k == end || on_curve(start + k);
+            glm::vec2 p = k == end ? start_point : point(start + k);
+            if (on) {
+                if (has_control) {
+                    curve_to(p);
+                }
+                else if (p != current) {
+                    outline.points.push_back(p);
+                    current = p;
+                }
+                has_control = false;
+            }
+            else {
+                if (has_control) {
+                    curve_to(0.5f * (control + p));
+                }
+                control = p;
+                has_control = true;
+            }
+        }
+        // The last point repeats the first, the closing segment is implied
+        if (outline.points.size() > 1 && outline.points.back() == start_point) {
+            outline.points.pop_back();
+        }
+        outline.contour_ends.push_back((uint32_t) outline.points.size());
+        first = last + 1;
+    }
+    return true;
+}
+
+bool Font::outline(uint16_t glyph, float tolerance, GlyphOutline &outline) const
+{
+    outline.points.clear();
+    outline.contour_ends.clear();
+    uint16_t metric = std::min(glyph, (uint16_t) (h_metric_count - 1));
+    outline.advance = (float) u16(hmtx + 4 * (size_t) metric) / units_per_em;
+    return append_outline(glyph, glm::mat3(1.0f), tolerance, outline, 0);
+}
@@ -0,0 +1,133 @@
+#include "GeoJson.hpp"
+
+class GeoJsonLineHandler : public JsonHandler
+{
+private:
+    enum key_kind {
+        KEY_OTHER,
+        KEY_TYPE,
+        KEY_COORDINATES
+    };
+
+    struct Container
+    {
+        bool object;
+        // Objects: the key of the value being read, whether the type is
+        // one with lines and whether coordinates were read
+        key_kind key;
+        bool line_type;
+        bool has_coordinates;
+        // Arrays in coordinates: numbers read so far, the first two kept,
+        // and whether it holds positions
+        int values;
+        double lon;
+        double lat;
+        bool positions;
+    };
+
+    const std::function<void(const double *lon_lat, size_t count)> &on_line;
+    std::vector<Container> containers;
+    // Depth of the coordinates array being read, 0 outside of one
+    size_t coordinates_depth = 0;
+    // Of the current geometry, as lon, lat pairs, and where each line ends
+    std::vector<double> positions;
+    std::vector<size_t> line_ends;
+
+    void begin(bool object) {
+        containers.push_back({ object, KEY_OTHER, false, false, 0, 0.0, 0.0, false });
+    }
+public:
+    GeoJsonLineHandler(const std::function<void(const double *lon_lat, size_t count)> &on_line)
+        : on_line(on_line) {}
+
+    void begin_object() override {
+        begin(true);
+    }
+
+    void end_object() override {
+        const Container &geometry = containers.back();
+        if (geometry.has_coordinates) {
+            if (geometry.line_type) {
+                size_t begin = 0;
+                for (size_t end : line_ends) {
+                    if (end - begin >= 2) {
+                        on_line(&positions[2 * begin], end - begin);
+                    }
+                    begin = end;
+                }
+            }
+            positions.clear();
+            line_ends.clear();
+        }
+        containers.pop_back();
+    }
+
+    void begin_array() override {
+        bool starts_coordinates = coordinates_depth == 0 && !containers.empty()
+            && containers.back().object && containers.back().key == KEY_COORDINATES;
+        begin(false);
+        if (starts_coordinates) {
+            coordinates_depth = containers.size();
+        }
+    }
+
+    void end_array() override {
+        Container array = containers.back();
+        containers.pop_back();
+        if (coordinates_depth == 0) {
+            return;
+        }
+
+        // Innermost arrays are positions, arrays of them are lines
+        if (array.values >= 2) {
+            positions.push_back(array.lon);
+            positions.push_back(array.lat);
+            if (!containers.empty() && !containers.back().object) {
+                containers.back().positions = true;
+            }
+        }
+        if (array.positions) {
+            line_ends.push_back(positions.size() / 2);
+        }
+
+        if (containers.size() < coordinates_depth) {
+            coordinates_depth = 0;
+            containers.back().has_coordinates = true;
+        }
+    }
+
+    void key(const std::string &name) override {
+        containers.back().key = name == "type" ? KEY_TYPE : name == "coordinates" ? KEY_COORDINATES : KEY_OTHER;
+    }
+
+    void string(const std::string &value) override {
+        Container &container = containers.back();
+        if (container.object && container.key == KEY_TYPE) {
+            container.line_type = value == "LineString" || value == "MultiLineString"
+                || value == "Polygon" || value == "MultiPolygon";
+        }
+    }
+
+    void number(double value) override {
+        if (coordinates_depth == 0) {
+            return;
+        }
+        Container &array = containers.back();
+        if (array.values == 0) {
+            array.lon = value;
+        }
+        else if (array.values == 1) {
+            array.lat = value;
+        }
+        array.values++;
+    }
+};
+
+int read_geojson_lines(std::string path, const std::function<void(const double *lon_lat, size_t count)> &on_line)
+{
+    PROFILE_SCOPE("read_geojson_lines");
+
+    GeoJsonLineHandler handler(on_line);
+    JsonReader reader(handler);
+    return reader.parse_file(path);
+}
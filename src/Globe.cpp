@@ -0,0 +1,238 @@
+#include "Globe.hpp"
+
+Globe::Globe(const Ellipsoid &ellipsoid, const Terrain &terrain, uint32_t rows, uint32_t columns, uint32_t resolution,
+    ThreadPool &pool)
+    : ellipsoid(ellipsoid), terrain(terrain), rows(rows), columns(columns), resolution(resolution), levels(1)
+{
+    PROFILE_SCOPE("Globe::Globe");
+
+    while (resolution % (1u << levels) == 0) {
+        levels++;
+    }
+
+    patches.resize((size_t) rows * columns);
+    pool.parallel_for(patches.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            generate_patch((uint32_t) (i / columns), (uint32_t) (i % columns), patches[i]);
+        }
+    });
+}
+
+void Globe::generate_patch(uint32_t row, uint32_t column, GlobePatch &patch) const
+{
+    double lat_north = PI / 2.0 - PI * row / rows;
+    double lat_step = PI / rows / resolution;
+    double lon_west = 2.0 * PI * column / columns;
+    double lon_step = 2.0 * PI / columns / resolution;
+
+    patch.center = ellipsoid.to_ecef({
+        lat_north - PI / rows / 2.0,
+        lon_west + PI / columns,
+        0.0
+    });
+
+    uint32_t side = resolution + 1;
+    uint32_t grid_count = side * side;
+    GeodeticArrays geodetic;
+    geodetic.resize(grid_count);
+    for (uint32_t i = 0; i <= resolution; i++) {
+        for (uint32_t j = 0; j <= resolution; j++) {
+            geodetic.lat[i * side + j] = lat_north - i * lat_step;
+            geodetic.lon[i * side + j] = lon_west + j * lon_step;
+        }
+    }
+
+    for (size_t k = 0; k < grid_count; k++) {
+        geodetic.height[k] = terrain.sample(geodetic.lat[k], geodetic.lon[k] - GLOBE_LONGITUDE_OFFSET);
+    }
+    auto range = std::minmax_element(geodetic.height.begin(), geodetic.height.end());
+    patch.min_height = *range.first;
+    patch.max_height = *range.second;
+
+    // Displace by the quantized heights, so the mesh matches what is kept
+    double scale = patch.max_height > patch.min_height ? 65535.0 / (patch.max_height - patch.min_height) : 0.0;
+    patch.heights.resize(grid_count);
+    for (size_t k = 0; k < grid_count; k++) {
+        patch.heights[k] = (uint16_t) std::lround((geodetic.height[k] - patch.min_height) * scale);
+        geodetic.height[k] = patch.get_height(k);
+    }
+
+    EcefArrays ecef;
+    ecef.resize(grid_count);
+    ellipsoid.to_ecef(geodetic.lat.data(), geodetic.lon.data(), geodetic.height.data(),
+        ecef.x.data(), ecef.y.data(), ecef.z.data(), grid_count);
+
+    auto position = [&](size_t k) {
+        return glm::dvec3(ecef.x[k], ecef.y[k], ecef.z[k]);
+    };
+
+    // A vertex is in level L if its row and column are multiples of 2^L.
+    // In the last level it is in, it morphs to the midpoint of its
+    // neighbours in the next level, along the edge or the north west to
+    // south east diagonal that the triangles are split along.
+    std::vector<glm::dvec3> morph_offsets(grid_count, glm::dvec3(0.0));
+    std::vector<int> morph_levels(grid_count, -1);
+    std::vector<double> level_errors(levels, 0.0);
+    for (uint32_t i = 0; i <= resolution; i++) {
+        for (uint32_t j = 0; j <= resolution; j++) {
+            uint32_t level = 0;
+            while (level + 1 < levels && i % (2u << level) == 0 && j % (2u << level) == 0) {
+                level++;
+            }
+            if (level + 1 == levels) {
+                continue;
+            }
+
+            uint32_t step = 1u << level;
+            uint32_t di = i % (2 * step) != 0 ? step : 0;
+            uint32_t dj = j % (2 * step) != 0 ? step : 0;
+            size_t k = i * side + j;
+            glm::dvec3 target = (position((i - di) * side + j - dj) + position((i + di) * side + j + dj)) * 0.5;
+            morph_offsets[k] = target - position(k);
+            morph_levels[k] = (int) level;
+            level_errors[level] = std::max(level_errors[level], glm::length(morph_offsets[k]));
+        }
+    }
+
+    // Each level is off by at most its own morphs plus those of the finer ones
+    patch.lods.assign(levels, PatchLod{ 0, 0, 0.0 });
+    for (uint32_t level = 1; level < levels; level++) {
+        patch.lods[level].error = patch.lods[level - 1].error + level_errors[level - 1];
+    }
+
+    // The skirt follows the border counter-clockwise seen from outside: down
+    // the west edge, east along the south edge, up the east edge and west
+    // along the north edge. It is as deep as the coarsest level is off, the
+    // most two neighbours can differ.
+    std::vector<uint32_t> border;
+    border.reserve(4 * resolution);
+    for (uint32_t i = 0; i < resolution; i++) {
+        border.push_back(i * side);
+    }
+    for (uint32_t j = 0; j < resolution; j++) {
+        border.push_back(resolution * side + j);
+    }
+    for (uint32_t i = resolution; i > 0; i--) {
+        border.push_back(i * side + resolution);
+    }
+    for (uint32_t j = resolution; j > 0; j--) {
+        border.push_back(j);
+    }
+    double skirt_depth = patch.lods.back().error;
+
+    size_t vertex_count = grid_count + border.size();
+    patch.vertices.clear();
+    patch.texcoords.clear();
+    patch.morphs.clear();
+    patch.indices.clear();
+    patch.vertices.reserve(vertex_count * 3);
+    patch.texcoords.reserve(vertex_count * 2);
+    patch.morphs.reserve(vertex_count * 4);
+    patch.bounding_radius = 0.0;
+    patch.min_radius = std::numeric_limits<double>::max();
+
+    auto add_vertex = [&](const glm::dvec3 &world, size_t k) {
+        // Subtract in double, only the small offset is stored as float
+        glm::dvec3 offset = world - patch.center;
+        patch.vertices.insert(patch.vertices.end(), { (float) offset.x, (float) offset.y, (float) offset.z });
+        patch.bounding_radius = std::max(patch.bounding_radius, glm::length(offset));
+
+        // Equirectangular textures are in geodetic latitude
+        patch.texcoords.insert(patch.texcoords.end(), {
+            (float) (geodetic.lon[k] / (2.0 * PI)),
+            (float) ((PI / 2.0 - geodetic.lat[k]) / PI)
+        });
+
+        patch.morphs.insert(patch.morphs.end(), {
+            (float) morph_offsets[k].x, (float) morph_offsets[k].y, (float) morph_offsets[k].z,
+            (float) morph_levels[k]
+        });
+    };
+    for (size_t k = 0; k < grid_count; k++) {
+        add_vertex(position(k), k);
+    }
+    // Skirt vertices morph like the border vertex above them
+    for (uint32_t k : border) {
+        add_vertex(position(k) - ellipsoid.normal(geodetic.lat[k], geodetic.lon[k]) * skirt_depth, k);
+    }
+
+    for (uint32_t level = 0; level < levels; level++) {
+        generate_lod(level, ecef, border, patch);
+    }
+}
+
+void Globe::generate_lod(uint32_t level, const EcefArrays &ecef, const std::vector<uint32_t> &border, GlobePatch &patch) const
+{
+    uint32_t step = 1u << level;
+    uint32_t side = resolution + 1;
+    uint32_t grid_count = side * side;
+    uint32_t border_count = (uint32_t) border.size();
+
+    // No point of a triangle is closer to the center than its plane.
+    // Triangles at the poles are degenerate up to rounding, their plane is
+    // meaningless, so they fall back to the vertex.
+    auto plane_distance = [&](uint32_t i0, uint32_t i1, uint32_t i2) {
+        glm::dvec3 a(ecef.x[i0], ecef.y[i0], ecef.z[i0]);
+        glm::dvec3 b(ecef.x[i1], ecef.y[i1], ecef.z[i1]);
+        glm::dvec3 c(ecef.x[i2], ecef.y[i2], ecef.z[i2]);
+        glm::dvec3 normal = glm::cross(b - a, c - a);
+        double length = glm::length(normal);
+        if (length <= 1e-6 * glm::length(b - a) * glm::length(c - a)) {
+            return glm::length(a);
+        }
+        return std::abs(glm::dot(normal, a)) / length;
+    };
+
+    PatchLod &lod = patch.lods[level];
+    lod.first_index = (uint32_t) patch.indices.size();
+
+    // i grows to the south, j to the east
+    for (uint32_t i = 0; i < resolution; i += step) {
+        for (uint32_t j = 0; j < resolution; j += step) {
+            uint32_t north_west = i * side + j;
+            uint32_t south_west = north_west + step * side;
+            uint32_t south_east = south_west + step;
+            uint32_t north_east = north_west + step;
+            patch.indices.insert(patch.indices.end(), {
+                north_west, south_west, south_east,
+                north_west, south_east, north_east
+            });
+
+            // Coarser levels cut deeper, the occluder has to be below all
+            patch.min_radius = std::min({
+                patch.min_radius,
+                plane_distance(north_west, south_west, south_east),
+                plane_distance(north_west, south_east, north_east)
+            });
+        }
+    }
+
+    // Facing outwards, like a wall below the border of a counter-clockwise
+    // triangle. Corners are at multiples of the resolution, so every level
+    // steps on them.
+    for (uint32_t k = 0; k < border_count; k += step) {
+        uint32_t next = (k + step) % border_count;
+        patch.indices.insert(patch.indices.end(), {
+            border[k], grid_count + k, grid_count + next,
+            border[k], grid_count + next, border[next]
+        });
+    }
+
+    lod.index_count = (uint32_t) patch.indices.size() - lod.first_index;
+}
+
+std::vector<PatchBounds> Globe::get_bounds() const
+{
+    std::vector<PatchBounds> bounds;
+    bounds.reserve(patches.size());
+    for (const GlobePatch &patch : patches) {
+        std::vector<double> lod_errors;
+        for (const PatchLod &lod : patch.lods) {
+            lod_errors.push_back(lod.error);
+        }
+        bounds.push_back({
+            patch.center, patch.bounding_radius, patch.min_height, patch.max_height, patch.min_radius, lod_errors
+        });
+    }
+    return bounds;
+}
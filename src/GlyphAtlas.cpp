@@ -0,0 +1,273 @@
+#include "GlyphAtlas.hpp"
+
+// Printable ASCII, then the printable half of Latin-1
+static const uint32_t ASCII_FIRST = 32;
+static const uint32_t ASCII_LAST = 126;
+static const uint32_t LATIN1_FIRST = 160;
+static const uint32_t LATIN1_LAST = 255;
+static const int GLYPH_SLOTS = (ASCII_LAST - ASCII_FIRST + 1) + (LATIN1_LAST - LATIN1_FIRST + 1);
+
+// Bump when the layout of cache entries or the generated fields change
+static const uint32_t ATLAS_CACHE_VERSION = 1;
+
+struct AtlasHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t hash;
+    uint32_t glyph_count;
+    int32_t width;
+    int32_t height;
+    float ascent;
+    float descent;
+};
+
+int GlyphAtlas::glyph_slot(uint32_t codepoint)
+{
+    if (codepoint >= ASCII_FIRST && codepoint <= ASCII_LAST) {
+        return (int) (codepoint - ASCII_FIRST);
+    }
+    if (codepoint >= LATIN1_FIRST && codepoint <= LATIN1_LAST) {
+        return (int) (codepoint - LATIN1_FIRST + ASCII_LAST - ASCII_FIRST + 1);
+    }
+    return -1;
+}
+
+const GlyphMetrics &GlyphAtlas::get_glyph(uint32_t codepoint) const
+{
+    int slot = glyph_slot(codepoint);
+    return glyphs[slot >= 0 ? slot : glyph_slot('?')];
+}
+
+int GlyphAtlas::build(const Font &font, ThreadPool &pool)
+{
+    PROFILE_SCOPE("GlyphAtlas::build");
+
+    static const int em = GLYPH_SDF_EM;
+    static const int spread = GLYPH_SDF_SPREAD;
+
+    ascent = font.get_ascent();
+    descent = font.get_descent();
+
+    // Outlines within an eighth of a texel, and their boxes in texels
+    std::vector<GlyphOutline> outlines(GLYPH_SLOTS);
+    std::vector<glm::ivec2> origins(GLYPH_SLOTS, glm::ivec2(0));
+    std::vector<glm::ivec2> sizes(GLYPH_SLOTS, glm::ivec2(0));
+    for (int slot = 0; slot < GLYPH_SLOTS; slot++) {
+        uint32_t codepoint = slot <= (int) (ASCII_LAST - ASCII_FIRST)
+            ? ASCII_FIRST + slot : LATIN1_FIRST + slot - (ASCII_LAST - ASCII_FIRST + 1);
+        GlyphOutline &outline = outlines[slot];
+        if (!font.outline(font.glyph_index(codepoint), 0.125f / em, outline)) {
+            std::cerr << "Invalid outline of glyph U+" << std::hex << codepoint << std::dec << std::endl;
+            outline.points.clear();
+            outline.contour_ends.clear();
+        }
+        if (outline.points.empty()) {
+            continue;
+        }
+        glm::vec2 low = outline.points[0], high = outline.points[0];
+        for (const glm::vec2 &point : outline.points) {
+            low = glm::min(low, point);
+            high = glm::max(high, point);
+        }
+        glm::ivec2 first((int) std::floor(low.x * em), (int) std::floor(low.y * em));
+        glm::ivec2 last((int) std::ceil(high.x * em), (int) std::ceil(high.y * em));
+        origins[slot] = first - glm::ivec2(spread);
+        sizes[slot] = last - first + glm::ivec2(2 * spread);
+    }
+
+    // Shelves of glyphs sorted by height, a texel apart so filtering never
+    // reaches a neighbour
+    std::vector<int> order(GLYPH_SLOTS);
+    for (int slot = 0; slot < GLYPH_SLOTS; slot++) {
+        order[slot] = slot;
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return sizes[a].y > sizes[b].y;
+    });
+    std::vector<glm::ivec2> places(GLYPH_SLOTS, glm::ivec2(0));
+    int x = 1, y = 1, shelf_height = 0;
+    for (int slot : order) {
+        if (sizes[slot].x == 0) {
+            continue;
+        }
+        if (sizes[slot].x + 2 > GLYPH_ATLAS_WIDTH) {
+            std::cerr << "Glyph too large for the atlas" << std::endl;
+            return LOAD_ATLAS_FAILURE;
+        }
+        if (x + sizes[slot].x + 1 > GLYPH_ATLAS_WIDTH) {
+            x = 1;
+            y += shelf_height + 1;
+            shelf_height = 0;
+        }
+        places[slot] = glm::ivec2(x, y);
+        x += sizes[slot].x + 1;
+        shelf_height = std::max(shelf_height, sizes[slot].y);
+    }
+    int height = (y + shelf_height + 1 + 3) / 4 * 4;
+    if (height > 65535) {
+        std::cerr << "Glyph atlas too large" << std::endl;
+        return LOAD_ATLAS_FAILURE;
+    }
+
+    image = Image(GLYPH_ATLAS_WIDTH, height, 1);
+    std::fill(image.get_pixels(), image.get_pixels() + (size_t) GLYPH_ATLAS_WIDTH * height, (uint8_t) 0);
+    glyphs.assign(GLYPH_SLOTS, GlyphMetrics());
+
+    pool.parallel_for(GLYPH_SLOTS, 1, [&](size_t begin, size_t end) {
+        for (size_t slot = begin; slot < end; slot++) {
+            const GlyphOutline &outline = outlines[slot];
+            glm::ivec2 origin = origins[slot], size = sizes[slot], place = places[slot];
+
+            GlyphMetrics &metrics = glyphs[slot];
+            metrics.x0 = (float) origin.x / em;
+            metrics.y0 = (float) origin.y / em;
+            metrics.x1 = (float) (origin.x + size.x) / em;
+            metrics.y1 = (float) (origin.y + size.y) / em;
+            metrics.advance = outline.advance;
+            metrics.u0 = (uint16_t) place.x;
+            metrics.v0 = (uint16_t) place.y;
+            metrics.u1 = (uint16_t) (place.x + size.x);
+            metrics.v1 = (uint16_t) (place.y + size.y);
+
+            for (int j = 0; j < size.y; j++) {
+                uint8_t *row = image.get_pixels() + (size_t) (place.y + j) * GLYPH_ATLAS_WIDTH + place.x;
+                for (int i = 0; i < size.x; i++) {
+                    // Texel center in em
+                    glm::vec2 p((origin.x + i + 0.5f) / em, (origin.y + j + 0.5f) / em);
+                    float nearest = 1e30f;
+                    int winding = 0;
+                    uint32_t contour_begin = 0;
+                    for (uint32_t contour_end : outline.contour_ends) {
+                        for (uint32_t k = contour_begin; k < contour_end; k++) {
+                            glm::vec2 a = outline.points[k];
+                            glm::vec2 b = outline.points[k + 1 < contour_end ? k + 1 : contour_begin];
+                            glm::vec2 ab = b - a, ap = p - a;
+                            float t = glm::clamp(glm::dot(ap, ab) / std::max(glm::dot(ab, ab), 1e-12f), 0.0f, 1.0f);
+                            glm::vec2 d = ap - t * ab;
+                            nearest = std::min(nearest, glm::dot(d, d));
+                            // Nonzero winding, either contour direction works
+                            float side = ab.x * ap.y - ab.y * ap.x;
+                            if (a.y <= p.y) {
+                                if (b.y > p.y && side > 0.0f) {
+                                    winding++;
+                                }
+                            }
+                            else if (b.y <= p.y && side < 0.0f) {
+                                winding--;
+                            }
+                        }
+                        contour_begin = contour_end;
+                    }
+                    float distance = std::sqrt(nearest) * em * (winding != 0 ? 1.0f : -1.0f);
+                    float value = glm::clamp(0.5f + 0.5f * distance / spread, 0.0f, 1.0f);
+                    row[i] = (uint8_t) std::lround(value * 255.0f);
+                }
+            }
+        }
+    });
+
+    return LOAD_ATLAS_SUCCESS;
+}
+
+std::string GlyphAtlas::cache_path(std::string directory, uint64_t hash)
+{
+    std::stringstream path;
+    path << directory << "/" << std::hex << std::setw(16) << std::setfill('0') << hash << ".sdf";
+    return path.str();
+}
+
+bool GlyphAtlas::read_cache(std::string path, uint64_t hash)
+{
+    PROFILE_SCOPE("GlyphAtlas::read_cache");
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    AtlasHeader header;
+    if (!file.read((char*) &header, sizeof(header))
+        || std::string(header.magic, 4) != "CGEF"
+        || header.version != ATLAS_CACHE_VERSION
+        || header.hash != hash
+        || header.glyph_count != GLYPH_SLOTS
+        || header.width != GLYPH_ATLAS_WIDTH
+        || header.height <= 0 || header.height > 65535) {
+        return false;
+    }
+
+    glyphs.resize(header.glyph_count);
+    image = Image(header.width, header.height, 1);
+    if (!file.read((char*) glyphs.data(), glyphs.size() * sizeof(GlyphMetrics))
+        || !file.read((char*) image.get_pixels(), (size_t) header.width * header.height)) {
+        return false;
+    }
+    ascent = header.ascent;
+    descent = header.descent;
+
+    return true;
+}
+
+void GlyphAtlas::write_cache(std::string path, uint64_t hash) const
+{
+    PROFILE_SCOPE("GlyphAtlas::write_cache");
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+    // Write to a temporary file first, so a crash never leaves a torn entry
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Could not write glyph atlas cache " << temp_path << std::endl;
+            return;
+        }
+
+        AtlasHeader header = {
+            { 'C', 'G', 'E', 'F' }, ATLAS_CACHE_VERSION, hash, (uint32_t) glyphs.size(),
+            image.get_width(), image.get_height(), ascent, descent
+        };
+        file.write((const char*) &header, sizeof(header));
+        file.write((const char*) glyphs.data(), glyphs.size() * sizeof(GlyphMetrics));
+        file.write((const char*) image.get_pixels(), (size_t) image.get_width() * image.get_height());
+        if (!file) {
+            std::cerr << "Could not write glyph atlas cache " << temp_path << std::endl;
+            return;
+        }
+    }
+
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        std::cerr << "Could not write glyph atlas cache " << path << std::endl;
+    }
+}
+
+int GlyphAtlas::load(std::string font_path, std::string cache_directory)
+{
+    PROFILE_SCOPE("GlyphAtlas::load");
+
+    uint64_t hash = 0;
+    {
+        MappedFile file;
+        if (file.map(font_path) != MAP_FILE_SUCCESS) {
+            return LOAD_ATLAS_FAILURE;
+        }
+        int parameters[] = { GLYPH_SDF_EM, GLYPH_SDF_SPREAD, GLYPH_ATLAS_WIDTH, GLYPH_SLOTS };
+        hash = fnv1a(file.get_data(), file.get_size());
+        hash = fnv1a(parameters, sizeof(parameters), hash);
+    }
+
+    std::string path = cache_path(cache_directory, hash);
+    if (read_cache(path, hash)) {
+        return LOAD_ATLAS_SUCCESS;
+    }
+
+    Font font;
+    if (font.load(font_path) != LOAD_FONT_SUCCESS || build(font) != LOAD_ATLAS_SUCCESS) {
+        return LOAD_ATLAS_FAILURE;
+    }
+    write_cache(path, hash);
+    return LOAD_ATLAS_SUCCESS;
+}
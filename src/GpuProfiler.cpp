@@ -0,0 +1,202 @@
+#include "GpuProfiler.hpp"
+
+GpuProfiler::GpuProfiler()
+{
+    for (FrameQueries &queries : frames) {
+        glGenQueries(2 * (GPU_PROFILER_MAX_SCOPES + 1), queries.queries);
+        queries.scopes.reserve(GPU_PROFILER_MAX_SCOPES + 1);
+    }
+    // The whole frame is always pass 0
+    find_pass("frame");
+}
+
+GpuProfiler::~GpuProfiler()
+{
+    for (FrameQueries &queries : frames) {
+        glDeleteQueries(2 * (GPU_PROFILER_MAX_SCOPES + 1), queries.queries);
+    }
+}
+
+int GpuProfiler::open_log(std::string path)
+{
+    log.open(path, std::ios::out | std::ios::trunc);
+    if (!log) {
+        std::cerr << "Could not open " << path << "!" << std::endl;
+        return OPEN_PROFILER_LOG_FAILURE;
+    }
+
+    return OPEN_PROFILER_LOG_SUCCESS;
+}
+
+size_t GpuProfiler::find_pass(const char *name)
+{
+    // Only a handful of passes, a linear search beats hashing here
+    for (size_t i = 0; i < passes.size(); i++) {
+        if (passes[i].name == name) {
+            return i;
+        }
+    }
+
+    Pass pass;
+    pass.name = name;
+    pass.samples.resize(GPU_PROFILER_AVERAGE_SAMPLES, 0.0);
+    passes.push_back(pass);
+    return passes.size() - 1;
+}
+
+void GpuProfiler::add_sample(Pass &pass, double ms)
+{
+    pass.sum += ms - pass.samples[pass.next_sample];
+    pass.samples[pass.next_sample] = ms;
+    pass.next_sample = (pass.next_sample + 1) % GPU_PROFILER_AVERAGE_SAMPLES;
+    pass.filled = std::min(pass.filled + 1, (size_t) GPU_PROFILER_AVERAGE_SAMPLES);
+    pass.last = ms;
+}
+
+double GpuProfiler::average(const Pass &pass)
+{
+    return pass.filled > 0 ? pass.sum / (double) pass.filled : 0.0;
+}
+
+void GpuProfiler::collect(FrameQueries &queries)
+{
+    if (!queries.pending) {
+        return;
+    }
+    queries.pending = false;
+
+    // The frame end is the last query issued, once it is available all are
+    GLint available = 0;
+    glGetQueryObjectiv(queries.scopes[0].end_query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        // Never wait for the GPU, drop the frame instead
+        return;
+    }
+
+    for (const Scope &scope : queries.scopes) {
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(scope.begin_query, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(scope.end_query, GL_QUERY_RESULT, &end);
+        add_sample(passes[scope.pass], (double) (end - begin) / 1.0e6);
+    }
+
+    if (log) {
+        log << "{\"frame\":" << queries.frame;
+        for (const Scope &scope : queries.scopes) {
+            log << ",\"" << passes[scope.pass].name << "\":" << passes[scope.pass].last;
+        }
+        log << "}\n";
+    }
+}
+
+void GpuProfiler::begin_frame()
+{
+    current = frame % GPU_PROFILER_LATENCY;
+    FrameQueries &queries = frames[current];
+
+    // Issued GPU_PROFILER_LATENCY frames ago
+    collect(queries);
+
+    queries.frame = frame;
+    queries.scopes.clear();
+    queries.scopes.push_back({ 0, queries.queries[0], queries.queries[1] });
+    glQueryCounter(queries.queries[0], GL_TIMESTAMP);
+}
+
+void GpuProfiler::end_frame()
+{
+    FrameQueries &queries = frames[current];
+
+    glQueryCounter(queries.scopes[0].end_query, GL_TIMESTAMP);
+    queries.pending = true;
+    frame++;
+}
+
+void GpuProfiler::begin(const char *pass)
+{
+    FrameQueries &queries = frames[current];
+    if (scope_open || queries.scopes.size() > GPU_PROFILER_MAX_SCOPES) {
+        return;
+    }
+
+    open_pass = find_pass(pass);
+    scope_open = true;
+
+    size_t slot = queries.scopes.size();
+    glQueryCounter(queries.queries[2 * slot], GL_TIMESTAMP);
+}
+
+void GpuProfiler::end()
+{
+    if (!scope_open) {
+        return;
+    }
+    scope_open = false;
+
+    FrameQueries &queries = frames[current];
+    size_t slot = queries.scopes.size();
+    glQueryCounter(queries.queries[2 * slot + 1], GL_TIMESTAMP);
+    queries.scopes.push_back({ open_pass, queries.queries[2 * slot], queries.queries[2 * slot + 1] });
+}
+
+double GpuProfiler::get_average_ms(const char *pass) const
+{
+    for (const Pass &p : passes) {
+        if (p.name == pass) {
+            return average(p);
+        }
+    }
+
+    return 0.0;
+}
+
+std::string GpuProfiler::summary() const
+{
+    std::stringstream text;
+    text.precision(3);
+    text << std::fixed;
+    for (size_t i = 0; i < passes.size(); i++) {
+        if (i > 0) {
+            text << " | ";
+        }
+        text << passes[i].name << " " << average(passes[i]) << " ms";
+    }
+
+    return text.str();
+}
+
+void GpuProfiler::draw_overlay(int width, int height) const
+{
+    static const float colors[][3] = {
+        { 1.0f, 1.0f, 1.0f },
+        { 0.9f, 0.3f, 0.2f },
+        { 0.2f, 0.8f, 0.3f },
+        { 0.2f, 0.4f, 0.9f },
+        { 0.9f, 0.8f, 0.2f },
+        { 0.8f, 0.3f, 0.9f },
+    };
+    static const size_t color_count = sizeof(colors) / sizeof(colors[0]);
+    static const int bar_height = 6;
+    static const int bar_gap = 2;
+
+    GLfloat clear_color[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+    glEnable(GL_SCISSOR_TEST);
+
+    for (size_t i = 0; i < passes.size(); i++) {
+        int bar_width = (int) (average(passes[i]) / GPU_PROFILER_BUDGET_MS * width);
+        if (bar_width < 1) {
+            bar_width = 1;
+        }
+        // GL window coordinates start at the bottom
+        int y = height - (int) (i + 1) * (bar_height + bar_gap);
+
+        const float *color = colors[i % color_count];
+        glScissor(0, y, bar_width, bar_height);
+        glClearColor(color[0], color[1], color[2], 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    glDisable(GL_SCISSOR_TEST);
+    glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+}
@@ -0,0 +1,275 @@
+#include "HeatmapLayer.hpp"
+
+// Cells per touched flag, 4 KB of counts
+static const size_t HEATMAP_BLOCK = 1024;
+// Events are read from files in batches of this many
+static const size_t HEATMAP_LOAD_BATCH = 1 << 20;
+
+HeatmapLayer::HeatmapLayer(const Ellipsoid &ellipsoid, ThreadPool &pool)
+    : pool(pool)
+{
+    double ratio = ellipsoid.get_semi_minor() / ellipsoid.get_semi_major();
+    polar_scale = ratio * ratio;
+
+    for (int level = 0; level <= HEATMAP_MAX_LEVEL; level++) {
+        levels[level].assign(6 * (size_t) level_size(level) * level_size(level), 0);
+    }
+
+    size_t cells = levels[HEATMAP_MAX_LEVEL].size();
+    histograms.resize(std::max(pool.get_thread_count(), (size_t) 1));
+    for (Histogram &histogram : histograms) {
+        histogram.counts.assign(cells, 0);
+        histogram.touched.assign((cells + HEATMAP_BLOCK - 1) / HEATMAP_BLOCK, 0);
+    }
+}
+
+void HeatmapLayer::bin(const double *lat, const double *lon, size_t count, Histogram &histogram) const
+{
+    // Cells of a block on the stack, computed by a vectorized loop and
+    // counted by a scalar one
+    static const size_t BLOCK = 256;
+    const double size = (double) level_size(HEATMAP_MAX_LEVEL);
+    const double polar_scale = this->polar_scale;
+    uint32_t *counts = histogram.counts.data();
+    uint8_t *touched = histogram.touched.data();
+    int32_t cells[BLOCK];
+    for (size_t block = 0; block < count; block += BLOCK) {
+        size_t block_count = std::min(BLOCK, count - block);
+        const double *block_lat = lat + block;
+        const double *block_lon = lon + block;
+
+        // The projection of SphereCell, with selects instead of branches
+#pragma omp simd
+        for (size_t k = 0; k < block_count; k++) {
+            // Direction of the surface point in the globe's model space,
+            // to_ecef() without the common factor. It is up to 0.19 degrees
+            // off the normal, half a cell of the finest level.
+            double sin_lat, cos_lat, sin_lon, cos_lon;
+            simd_sincos(block_lat[k], sin_lat, cos_lat);
+            simd_sincos(block_lon[k] + GLOBE_LONGITUDE_OFFSET, sin_lon, cos_lon);
+            double x = cos_lat * cos_lon, y = cos_lat * sin_lon, z = polar_scale * sin_lat;
+
+            // The axis the direction is closest to is the face, the other
+            // two in the order of the positive face are (u, v) scaled by it.
+            // Negative faces swap them.
+            double ax = std::fabs(x), ay = std::fabs(y), az = std::fabs(z);
+            bool on_x = ax >= ay && ax >= az;
+            bool on_y = !on_x && ay >= az;
+            double major = on_x ? x : on_y ? y : z;
+            double a = on_x ? y : -x;
+            double b = on_x ? z : on_y ? z : -y;
+            bool positive = major >= 0.0;
+            double u = (positive ? a : b) / major;
+            double v = (positive ? b : a) / major;
+            double face = (on_x ? 0.0 : on_y ? 1.0 : 2.0) + (positive ? 0.0 : 3.0);
+
+            double s_half = 0.5 * std::sqrt(1.0 + 3.0 * std::fabs(u));
+            double t_half = 0.5 * std::sqrt(1.0 + 3.0 * std::fabs(v));
+            double s = u >= 0.0 ? s_half : 1.0 - s_half;
+            double t = v >= 0.0 ? t_half : 1.0 - t_half;
+            // Truncation is floor, s and t are not negative
+            double i = (double) (int32_t) std::min(s * size, size - 1.0);
+            double j = (double) (int32_t) std::min(t * size, size - 1.0);
+            cells[k] = (int32_t) ((face * size + j) * size + i);
+        }
+
+        for (size_t k = 0; k < block_count; k++) {
+            counts[cells[k]]++;
+            touched[cells[k] / HEATMAP_BLOCK] = 1;
+        }
+    }
+    if (count > 0) {
+        histogram.empty = false;
+    }
+}
+
+void HeatmapLayer::add_events(const double *lat, const double *lon, size_t count)
+{
+    PROFILE_SCOPE("HeatmapLayer::add_events");
+
+    event_count += count;
+    if (count < HEATMAP_INGEST_GRAIN || histograms.size() == 1) {
+        bin(lat, lon, count, histograms[0]);
+        return;
+    }
+
+    // One contiguous slice per histogram, whichever thread runs a slice owns
+    // its histogram until it is done
+    size_t slices = histograms.size();
+    pool.parallel_for(slices, 1, [&](size_t begin, size_t end) {
+        for (size_t slice = begin; slice < end; slice++) {
+            size_t first = count * slice / slices;
+            size_t last = count * (slice + 1) / slices;
+            bin(lat + first, lon + first, last - first, histograms[slice]);
+        }
+    });
+}
+
+int HeatmapLayer::load_csv(std::string path)
+{
+    PROFILE_SCOPE("HeatmapLayer::load_csv");
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Could not open " << path << std::endl;
+        return LOAD_EVENTS_FAILURE;
+    }
+
+    std::vector<double> lat, lon;
+    lat.reserve(HEATMAP_LOAD_BATCH);
+    lon.reserve(HEATMAP_LOAD_BATCH);
+    std::string line;
+    while (std::getline(file, line)) {
+        const char *cursor = line.c_str();
+        char *end = nullptr;
+        double lat_degrees = std::strtod(cursor, &end);
+        if (end == cursor || *end != ',') {
+            continue;
+        }
+        cursor = end + 1;
+        double lon_degrees = std::strtod(cursor, &end);
+        if (end == cursor || !std::isfinite(lat_degrees) || !std::isfinite(lon_degrees)) {
+            continue;
+        }
+
+        lat.push_back(lat_degrees * PI / 180.0);
+        lon.push_back(lon_degrees * PI / 180.0);
+        if (lat.size() == HEATMAP_LOAD_BATCH) {
+            add_events(lat.data(), lon.data(), lat.size());
+            lat.clear();
+            lon.clear();
+        }
+    }
+    add_events(lat.data(), lon.data(), lat.size());
+
+    return LOAD_EVENTS_SUCCESS;
+}
+
+bool HeatmapLayer::merge()
+{
+    PROFILE_SCOPE("HeatmapLayer::merge");
+
+    bool any = false;
+    for (const Histogram &histogram : histograms) {
+        any = any || !histogram.empty;
+    }
+    if (!any) {
+        return false;
+    }
+
+    // Every task owns its blocks in the totals and all histograms
+    std::vector<uint64_t> &totals = levels[HEATMAP_MAX_LEVEL];
+    size_t blocks = histograms[0].touched.size();
+    pool.parallel_for(blocks, 4, [&](size_t begin, size_t end) {
+        for (size_t block = begin; block < end; block++) {
+            size_t first = block * HEATMAP_BLOCK;
+            size_t last = std::min(first + HEATMAP_BLOCK, totals.size());
+            for (Histogram &histogram : histograms) {
+                if (!histogram.touched[block]) {
+                    continue;
+                }
+                for (size_t cell = first; cell < last; cell++) {
+                    totals[cell] += histogram.counts[cell];
+                    histogram.counts[cell] = 0;
+                }
+                histogram.touched[block] = 0;
+            }
+        }
+    });
+    for (Histogram &histogram : histograms) {
+        histogram.empty = true;
+    }
+
+    // Each coarser cell sums its four children, row by row
+    for (int level = HEATMAP_MAX_LEVEL - 1; level >= 0; level--) {
+        uint32_t size = level_size(level);
+        const std::vector<uint64_t> &children = levels[level + 1];
+        std::vector<uint64_t> &parents = levels[level];
+        pool.parallel_for(6 * (size_t) size, 16, [&](size_t begin, size_t end) {
+            for (size_t row = begin; row < end; row++) {
+                // Rows of all faces are consecutive, so face and j follow
+                size_t child_row = 2 * row;
+                const uint64_t *below = &children[child_row * 2 * size];
+                const uint64_t *above = below + 2 * size;
+                uint64_t *out = &parents[row * size];
+                for (uint32_t i = 0; i < size; i++) {
+                    out[i] = below[2 * i] + below[2 * i + 1] + above[2 * i] + above[2 * i + 1];
+                }
+            }
+        });
+    }
+
+    return true;
+}
+
+int HeatmapLayer::select_level(const glm::dvec3 &camera, double pixel_scale)
+{
+    double altitude = std::max(glm::length(camera) - EARTH_RADIUS, CAMERA_MIN_ALTITUDE);
+    // Cells of level L are about PI / 2 / 2^L across, seen from straight
+    // above the nearest ground
+    int level = 0;
+    while (level < HEATMAP_MAX_LEVEL
+        && PI / 2.0 / level_size(level + 1) * EARTH_RADIUS / altitude * pixel_scale >= HEATMAP_CELL_PIXELS) {
+        level++;
+    }
+    return level;
+}
+
+void HeatmapLayer::build_image()
+{
+    PROFILE_SCOPE("HeatmapLayer::build_image");
+
+    uint32_t size = level_size(active_level);
+    const std::vector<uint64_t> &counts = levels[active_level];
+    image.resize(counts.size());
+
+    // Counts per area of an average cell. The quadratic projection keeps
+    // areas within a factor of about 2, this evens out the rest: a cell's
+    // share of the average is the Jacobian of (s, t) to the sphere.
+    std::vector<float> densities(counts.size());
+    double maxima[6] = {};
+    pool.parallel_for(6, 1, [&](size_t begin, size_t end) {
+        for (size_t face = begin; face < end; face++) {
+            for (uint32_t j = 0; j < size; j++) {
+                double t = (j + 0.5) / size;
+                double v = cell_uv_from_st(t);
+                double dv = 8.0 / 3.0 * (t >= 0.5 ? t : 1.0 - t);
+                for (uint32_t i = 0; i < size; i++) {
+                    double s = (i + 0.5) / size;
+                    double u = cell_uv_from_st(s);
+                    double du = 8.0 / 3.0 * (s >= 0.5 ? s : 1.0 - s);
+                    double r = 1.0 + u * u + v * v;
+                    double share = du * dv / (r * std::sqrt(r)) * 6.0 / (4.0 * PI);
+                    size_t cell = (face * size + j) * size + i;
+                    double density = counts[cell] / share;
+                    densities[cell] = (float) density;
+                    maxima[face] = std::max(maxima[face], density);
+                }
+            }
+        }
+    });
+
+    // Log scaled, a few events still show next to a hot spot
+    double highest = *std::max_element(maxima, maxima + 6);
+    float scale = highest > 0.0 ? (float) (65535.0 / std::log1p(highest)) : 0.0f;
+    pool.parallel_for(densities.size(), GEODETIC_BATCH_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t cell = begin; cell < end; cell++) {
+            image[cell] = (uint16_t) std::min(std::log1p(densities[cell]) * scale + 0.5f, 65535.0f);
+        }
+    });
+}
+
+bool HeatmapLayer::update(const glm::dvec3 &camera, double pixel_scale)
+{
+    PROFILE_SCOPE("HeatmapLayer::update");
+
+    bool merged = merge();
+    int level = select_level(camera, pixel_scale);
+    if (!merged && level == active_level) {
+        return false;
+    }
+
+    active_level = level;
+    build_image();
+    return true;
+}
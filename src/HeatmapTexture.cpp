@@ -0,0 +1,44 @@
+#include "HeatmapTexture.hpp"
+
+HeatmapTexture::HeatmapTexture()
+{
+    glGenTextures(1, &texture);
+}
+
+HeatmapTexture::~HeatmapTexture()
+{
+    glDeleteTextures(1, &texture);
+}
+
+void HeatmapTexture::upload(const HeatmapLayer &layer)
+{
+    PROFILE_SCOPE("HeatmapTexture::upload");
+
+    if (layer.get_level() < 0) {
+        return;
+    }
+
+    GLsizei level_size = (GLsizei) HeatmapLayer::level_size(layer.get_level());
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    // Reallocated only when the level changes
+    if (level_size != size) {
+        size = level_size;
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R16, size, size, 6, 0, GL_RED, GL_UNSIGNED_SHORT, layer.get_image().data());
+        // Cells blend into each other, but not across the edges of a face
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, size, size, 6, GL_RED, GL_UNSIGNED_SHORT, layer.get_image().data());
+    }
+}
+
+void HeatmapTexture::use() const
+{
+    glActiveTexture(GL_TEXTURE0 + HEATMAP_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glActiveTexture(GL_TEXTURE0);
+}
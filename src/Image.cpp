@@ -0,0 +1,174 @@
+#include "Image.hpp"
+
+#include <cmath>
+
+#include "Constants.hpp"
+
+// NOTE: NOT in header files!
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+Image::Image(int width, int height, int channels)
+    : width(width), height(height), channels(channels), pixels((size_t) width * height * channels) {}
+
+int Image::load(std::string path, int channels)
+{
+    PROFILE_SCOPE("Image::load");
+
+    int width = 0, height = 0;
+    stbi_uc *data = stbi_load(path.c_str(), &width, &height, nullptr, channels);
+    if (data == NULL) {
+        std::cerr << "Could not load " << path << std::endl;
+        return LOAD_IMAGE_FAILURE;
+    }
+
+    this->width = width;
+    this->height = height;
+    this->channels = channels;
+    pixels.assign(data, data + (size_t) width * height * channels);
+    stbi_image_free(data);
+
+    return LOAD_IMAGE_SUCCESS;
+}
+
+int Image::load_from_memory(const uint8_t *data, size_t size, int channels)
+{
+    PROFILE_SCOPE("Image::load_from_memory");
+
+    int width = 0, height = 0;
+    stbi_uc *decoded = stbi_load_from_memory(data, (int) size, &width, &height, nullptr, channels);
+    if (decoded == NULL) {
+        std::cerr << "Could not decode image from memory" << std::endl;
+        return LOAD_IMAGE_FAILURE;
+    }
+
+    this->width = width;
+    this->height = height;
+    this->channels = channels;
+    pixels.assign(decoded, decoded + (size_t) width * height * channels);
+    stbi_image_free(decoded);
+
+    return LOAD_IMAGE_SUCCESS;
+}
+
+Image Image::downsample(ThreadPool &pool) const
+{
+    PROFILE_SCOPE("Image::downsample");
+
+    int half_width = width > 1 ? width / 2 : 1;
+    int half_height = height > 1 ? height / 2 : 1;
+    Image half(half_width, half_height, channels);
+
+    // Odd sizes drop the last row/column, like most drivers do
+    int step_x = width > 1 ? 2 : 1;
+    int step_y = height > 1 ? 2 : 1;
+    int next_x = width > 1 ? channels : 0;
+    size_t next_y = height > 1 ? (size_t) width * channels : 0;
+
+    const uint8_t *src = pixels.data();
+    uint8_t *dst = half.pixels.data();
+    int channels = this->channels;
+    size_t src_stride = (size_t) width * channels;
+    size_t dst_stride = (size_t) half_width * channels;
+
+    pool.parallel_for(half_height, 16, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; y++) {
+            const uint8_t *row = src + y * step_y * src_stride;
+            uint8_t *out = dst + y * dst_stride;
+            for (int x = 0; x < half_width; x++) {
+                const uint8_t *p = row + (size_t) x * step_x * channels;
+                for (int c = 0; c < channels; c++) {
+                    unsigned sum = p[c] + p[c + next_x] + p[c + next_y] + p[c + next_y + next_x];
+                    out[x * channels + c] = (uint8_t) ((sum + 2) / 4);
+                }
+            }
+        }
+    });
+
+    return half;
+}
+
+std::vector<Image> Image::generate_mips(ThreadPool &pool) const
+{
+    PROFILE_SCOPE("Image::generate_mips");
+
+    std::vector<Image> mips;
+    const Image *level = this;
+    while (level->width > 1 || level->height > 1) {
+        mips.push_back(level->downsample(pool));
+        level = &mips.back();
+    }
+
+    return mips;
+}
+
+std::vector<Image> Image::equirect_to_cube(int face_size, ThreadPool &pool) const
+{
+    PROFILE_SCOPE("Image::equirect_to_cube");
+
+    std::vector<Image> faces;
+    for (int face = 0; face < 6; face++) {
+        faces.emplace_back(face_size, face_size, channels);
+    }
+
+    const uint8_t *src = pixels.data();
+    int width = this->width;
+    int height = this->height;
+    int channels = this->channels;
+
+    pool.parallel_for((size_t) 6 * face_size, 16, [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; row++) {
+            int face = (int) (row / face_size);
+            int y = (int) (row % face_size);
+            uint8_t *out = faces[face].pixels.data() + (size_t) y * face_size * channels;
+
+            float t = 2.0f * (y + 0.5f) / face_size - 1.0f;
+            for (int x = 0; x < face_size; x++) {
+                float s = 2.0f * (x + 0.5f) / face_size - 1.0f;
+
+                // Direction of the texel, see the cube map face selection
+                // table of the OpenGL specification
+                float dx = 0.0f, dy = 0.0f, dz = 0.0f;
+                switch (face) {
+                    case 0: dx =  1.0f; dy = -t;    dz = -s;    break;
+                    case 1: dx = -1.0f; dy = -t;    dz =  s;    break;
+                    case 2: dx =  s;    dy =  1.0f; dz =  t;    break;
+                    case 3: dx =  s;    dy = -1.0f; dz = -t;    break;
+                    case 4: dx =  s;    dy = -t;    dz =  1.0f; break;
+                    case 5: dx = -s;    dy = -t;    dz = -1.0f; break;
+                }
+
+                float lon = std::atan2(dy, dx);
+                if (lon < 0.0f) {
+                    lon += 2.0f * PI;
+                }
+                float polar = std::acos(dz / std::sqrt(dx * dx + dy * dy + dz * dz));
+
+                // Texel centers, x wraps around, y is clamped at the poles
+                float u = lon / (2.0f * PI) * width - 0.5f;
+                float v = polar / PI * height - 0.5f;
+                v = std::fmin(std::fmax(v, 0.0f), (float) (height - 1));
+
+                int x0 = (int) std::floor(u);
+                int y0 = (int) v;
+                float fx = u - x0;
+                float fy = v - y0;
+                x0 = (x0 % width + width) % width;
+                int x1 = (x0 + 1) % width;
+                int y1 = y0 + 1 < height ? y0 + 1 : y0;
+
+                const uint8_t *p00 = src + ((size_t) y0 * width + x0) * channels;
+                const uint8_t *p01 = src + ((size_t) y0 * width + x1) * channels;
+                const uint8_t *p10 = src + ((size_t) y1 * width + x0) * channels;
+                const uint8_t *p11 = src + ((size_t) y1 * width + x1) * channels;
+                for (int c = 0; c < channels; c++) {
+                    float top = p00[c] + (p01[c] - p00[c]) * fx;
+                    float bottom = p10[c] + (p11[c] - p10[c]) * fx;
+                    out[x * channels + c] = (uint8_t) (top + (bottom - top) * fy + 0.5f);
+                }
+            }
+        }
+    });
+
+    return faces;
+}
@@ -0,0 +1,319 @@
+#include "JsonReader.hpp"
+
+JsonReader::JsonReader(JsonHandler &handler)
+    : handler(handler) {}
+
+int JsonReader::fail(const char *message)
+{
+    if (!failed) {
+        std::cerr << "JSON error at byte " << offset << ": " << message << std::endl;
+    }
+    failed = true;
+    return PARSE_JSON_FAILURE;
+}
+
+void JsonReader::value_done()
+{
+    expect = nesting.empty() ? EXPECT_NOTHING : EXPECT_COMMA_OR_END;
+}
+
+bool JsonReader::finish_number()
+{
+    double value = 0.0;
+    std::from_chars_result result = std::from_chars(token.data(), token.data() + token.size(), value);
+    if (result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+        return false;
+    }
+    handler.number(value);
+    state = TOKEN_NONE;
+    value_done();
+    return true;
+}
+
+bool JsonReader::finish_literal()
+{
+    if (token == "true" || token == "false") {
+        handler.boolean(token[0] == 't');
+    }
+    else if (token == "null") {
+        handler.null();
+    }
+    else {
+        return false;
+    }
+    state = TOKEN_NONE;
+    value_done();
+    return true;
+}
+
+void JsonReader::append_utf8(uint32_t code)
+{
+    if (code < 0x80) {
+        token.push_back((char) code);
+    }
+    else if (code < 0x800) {
+        token.push_back((char) (0xC0 | (code >> 6)));
+        token.push_back((char) (0x80 | (code & 0x3F)));
+    }
+    else if (code < 0x10000) {
+        token.push_back((char) (0xE0 | (code >> 12)));
+        token.push_back((char) (0x80 | ((code >> 6) & 0x3F)));
+        token.push_back((char) (0x80 | (code & 0x3F)));
+    }
+    else {
+        token.push_back((char) (0xF0 | (code >> 18)));
+        token.push_back((char) (0x80 | ((code >> 12) & 0x3F)));
+        token.push_back((char) (0x80 | ((code >> 6) & 0x3F)));
+        token.push_back((char) (0x80 | (code & 0x3F)));
+    }
+}
+
+bool JsonReader::structural(char c)
+{
+    bool value_allowed = expect == EXPECT_VALUE || expect == EXPECT_VALUE_OR_END;
+    switch (c) {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+            return true;
+        case '{':
+        case '[':
+            if (!value_allowed) {
+                return false;
+            }
+            nesting.push_back(c);
+            if (c == '{') {
+                handler.begin_object();
+                expect = EXPECT_KEY_OR_END;
+            }
+            else {
+                handler.begin_array();
+                expect = EXPECT_VALUE_OR_END;
+            }
+            return true;
+        case '}':
+            if (nesting.empty() || nesting.back() != '{' || (expect != EXPECT_KEY_OR_END && expect != EXPECT_COMMA_OR_END)) {
+                return false;
+            }
+            nesting.pop_back();
+            handler.end_object();
+            value_done();
+            return true;
+        case ']':
+            if (nesting.empty() || nesting.back() != '[' || (expect != EXPECT_VALUE_OR_END && expect != EXPECT_COMMA_OR_END)) {
+                return false;
+            }
+            nesting.pop_back();
+            handler.end_array();
+            value_done();
+            return true;
+        case ':':
+            if (expect != EXPECT_COLON) {
+                return false;
+            }
+            expect = EXPECT_VALUE;
+            return true;
+        case ',':
+            if (expect != EXPECT_COMMA_OR_END) {
+                return false;
+            }
+            expect = nesting.back() == '{' ? EXPECT_KEY : EXPECT_VALUE;
+            return true;
+        case '"':
+            if (!value_allowed && expect != EXPECT_KEY && expect != EXPECT_KEY_OR_END) {
+                return false;
+            }
+            token_is_key = !value_allowed;
+            token.clear();
+            state = TOKEN_STRING;
+            return true;
+        case 't':
+        case 'f':
+        case 'n':
+            if (!value_allowed) {
+                return false;
+            }
+            token.assign(1, c);
+            state = TOKEN_LITERAL;
+            return true;
+        default:
+            if (!value_allowed || (c != '-' && (c < '0' || c > '9'))) {
+                return false;
+            }
+            token.assign(1, c);
+            state = TOKEN_NUMBER;
+            return true;
+    }
+}
+
+int JsonReader::feed(const char *data, size_t size)
+{
+    if (failed) {
+        return PARSE_JSON_FAILURE;
+    }
+
+    size_t i = 0;
+    while (i < size) {
+        char c = data[i];
+        switch (state) {
+            case TOKEN_NONE: {
+                if (!structural(c)) {
+                    offset += i;
+                    return fail("unexpected character");
+                }
+                i++;
+                break;
+            }
+            case TOKEN_STRING: {
+                // Copy the plain run up to the next quote or escape at once
+                size_t run = i;
+                while (run < size && data[run] != '"' && data[run] != '\\') {
+                    run++;
+                }
+                token.append(data + i, run - i);
+                i = run;
+                if (i == size) {
+                    break;
+                }
+                if (data[i] == '\\') {
+                    state = TOKEN_ESCAPE;
+                }
+                else if (token_is_key) {
+                    handler.key(token);
+                    state = TOKEN_NONE;
+                    expect = EXPECT_COLON;
+                }
+                else {
+                    handler.string(token);
+                    state = TOKEN_NONE;
+                    value_done();
+                }
+                i++;
+                break;
+            }
+            case TOKEN_ESCAPE: {
+                state = TOKEN_STRING;
+                switch (c) {
+                    case '"': token.push_back('"'); break;
+                    case '\\': token.push_back('\\'); break;
+                    case '/': token.push_back('/'); break;
+                    case 'b': token.push_back('\b'); break;
+                    case 'f': token.push_back('\f'); break;
+                    case 'n': token.push_back('\n'); break;
+                    case 'r': token.push_back('\r'); break;
+                    case 't': token.push_back('\t'); break;
+                    case 'u':
+                        state = TOKEN_UNICODE;
+                        code_point = 0;
+                        hex_digits = 0;
+                        break;
+                    default:
+                        offset += i;
+                        return fail("invalid escape");
+                }
+                i++;
+                break;
+            }
+            case TOKEN_UNICODE: {
+                int digit = c >= '0' && c <= '9' ? c - '0'
+                    : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                    : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+                if (digit < 0) {
+                    offset += i;
+                    return fail("invalid \\u escape");
+                }
+                code_point = code_point << 4 | (uint32_t) digit;
+                i++;
+                if (++hex_digits < 4) {
+                    break;
+                }
+                state = TOKEN_STRING;
+                if (code_point >= 0xD800 && code_point < 0xDC00) {
+                    high_surrogate = code_point;
+                }
+                else if (code_point >= 0xDC00 && code_point < 0xE000 && high_surrogate != 0) {
+                    append_utf8(0x10000 + ((high_surrogate - 0xD800) << 10) + (code_point - 0xDC00));
+                    high_surrogate = 0;
+                }
+                else {
+                    append_utf8(code_point);
+                    high_surrogate = 0;
+                }
+                break;
+            }
+            case TOKEN_NUMBER: {
+                // Like strings, the whole run at once
+                size_t run = i;
+                while (run < size && ((data[run] >= '0' && data[run] <= '9')
+                    || data[run] == '.' || data[run] == 'e' || data[run] == 'E' || data[run] == '+' || data[run] == '-')) {
+                    run++;
+                }
+                token.append(data + i, run - i);
+                i = run;
+                if (i < size && !finish_number()) {
+                    offset += i;
+                    return fail("invalid number");
+                }
+                break;
+            }
+            case TOKEN_LITERAL: {
+                if (c >= 'a' && c <= 'z') {
+                    token.push_back(c);
+                    i++;
+                }
+                else if (!finish_literal()) {
+                    offset += i;
+                    return fail("invalid literal");
+                }
+                break;
+            }
+        }
+    }
+
+    offset += size;
+    return PARSE_JSON_SUCCESS;
+}
+
+int JsonReader::finish()
+{
+    if (failed) {
+        return PARSE_JSON_FAILURE;
+    }
+    // A top-level number or literal ends with the document
+    if (state == TOKEN_NUMBER && !finish_number()) {
+        return fail("invalid number");
+    }
+    if (state == TOKEN_LITERAL && !finish_literal()) {
+        return fail("invalid literal");
+    }
+    if (state != TOKEN_NONE || expect != EXPECT_NOTHING) {
+        return fail("unexpected end of document");
+    }
+    return PARSE_JSON_SUCCESS;
+}
+
+int JsonReader::parse_file(std::string path)
+{
+    PROFILE_SCOPE("JsonReader::parse_file");
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Could not open " << path << std::endl;
+        return PARSE_JSON_FAILURE;
+    }
+
+    std::vector<char> chunk(JSON_READ_CHUNK);
+    while (file) {
+        file.read(chunk.data(), (std::streamsize) chunk.size());
+        if (feed(chunk.data(), (size_t) file.gcount()) != PARSE_JSON_SUCCESS) {
+            std::cerr << "In " << path << std::endl;
+            return PARSE_JSON_FAILURE;
+        }
+    }
+    if (finish() != PARSE_JSON_SUCCESS) {
+        std::cerr << "In " << path << std::endl;
+        return PARSE_JSON_FAILURE;
+    }
+    return PARSE_JSON_SUCCESS;
+}
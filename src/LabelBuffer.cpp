@@ -0,0 +1,79 @@
+#include "LabelBuffer.hpp"
+
+LabelBuffer::LabelBuffer()
+{
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenTextures(1, &texture);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(LABEL_RECT_ATTR_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), (const void*) 0);
+    glEnableVertexAttribArray(LABEL_RECT_ATTR_LOCATION);
+    // Integers converted to float, the shader divides by the atlas size
+    glVertexAttribPointer(LABEL_TEXELS_ATTR_LOCATION, 4, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(GlyphInstance),
+        (const void*) offsetof(GlyphInstance, u0));
+    glEnableVertexAttribArray(LABEL_TEXELS_ATTR_LOCATION);
+    // Once per glyph, not per vertex
+    glVertexAttribDivisor(LABEL_RECT_ATTR_LOCATION, 1);
+    glVertexAttribDivisor(LABEL_TEXELS_ATTR_LOCATION, 1);
+    glBindVertexArray(0);
+}
+
+LabelBuffer::~LabelBuffer()
+{
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteTextures(1, &texture);
+}
+
+void LabelBuffer::upload_atlas(const GlyphAtlas &atlas)
+{
+    PROFILE_SCOPE("LabelBuffer::upload_atlas");
+
+    const Image &image = atlas.get_image();
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, image.get_width(), image.get_height(), 0, GL_RED, GL_UNSIGNED_BYTE, image.get_pixels());
+
+    // Distances interpolate linearly, and a mipmap would blur them between
+    // glyphs. Clamped so the edge texels never wrap around.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+void LabelBuffer::upload(const LabelLayer &layer)
+{
+    PROFILE_SCOPE("LabelBuffer::upload");
+
+    const std::vector<GlyphInstance> &instances = layer.get_instances();
+    count = instances.size();
+
+    // Orphans the old storage, the GPU may still be drawing from it
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(GlyphInstance), instances.data(), GL_STREAM_DRAW);
+}
+
+void LabelBuffer::draw() const
+{
+    if (count == 0) {
+        return;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindVertexArray(vao);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei) count);
+    glBindVertexArray(0);
+}
+
+RenderState LabelBuffer::get_render_state()
+{
+    RenderState state;
+    state.depth_test = false;
+    state.depth_write = false;
+    state.cull = false;
+    state.blend = true;
+    return state;
+}
@@ -0,0 +1,185 @@
+#include "LabelLayer.hpp"
+
+// Next codepoint of UTF-8 text, U+FFFD for malformed sequences
+static uint32_t decode_utf8(const std::string &text, size_t &i)
+{
+    uint8_t lead = (uint8_t) text[i++];
+    if (lead < 0x80) {
+        return lead;
+    }
+    int length = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : -1;
+    if (length < 0 || lead >= 0xF8) {
+        return 0xFFFD;
+    }
+    uint32_t codepoint = lead & (0x3F >> length);
+    for (int k = 0; k < length; k++) {
+        if (i >= text.size() || ((uint8_t) text[i] & 0xC0) != 0x80) {
+            return 0xFFFD;
+        }
+        codepoint = (codepoint << 6) | ((uint8_t) text[i++] & 0x3F);
+    }
+    return codepoint;
+}
+
+LabelLayer::LabelLayer(const Ellipsoid &ellipsoid, const GlyphAtlas &atlas)
+    : ellipsoid(ellipsoid), atlas(atlas) {}
+
+void LabelLayer::add(Geodetic position, const std::string &text, uint32_t rank)
+{
+    Label label = {};
+    // Labels are in the globe's model space
+    position.lon += GLOBE_LONGITUDE_OFFSET;
+    label.position = ellipsoid.to_ecef(position);
+    label.first = (uint32_t) codepoints.size();
+    for (size_t i = 0; i < text.size();) {
+        uint32_t codepoint = decode_utf8(text, i);
+        codepoints.push_back(codepoint);
+        label.width += atlas.get_glyph(codepoint).advance;
+    }
+    label.count = (uint32_t) codepoints.size() - label.first;
+    label.rank = rank;
+    if (label.count == 0) {
+        codepoints.resize(label.first);
+        return;
+    }
+
+    sorted = sorted && (labels.empty() || labels.back().rank <= rank);
+    labels.push_back(label);
+}
+
+int LabelLayer::load_csv(std::string path)
+{
+    PROFILE_SCOPE("LabelLayer::load_csv");
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Could not open " << path << std::endl;
+        return LOAD_LABELS_FAILURE;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        const char *cursor = line.c_str();
+        char *end = nullptr;
+
+        double lat = std::strtod(cursor, &end);
+        if (end == cursor || *end != ',') {
+            continue;
+        }
+        cursor = end + 1;
+        double lon = std::strtod(cursor, &end);
+        if (end == cursor || *end != ',') {
+            continue;
+        }
+        cursor = end + 1;
+        unsigned long rank = std::strtoul(cursor, &end, 10);
+        if (end == cursor || *end != ',') {
+            continue;
+        }
+
+        add({ lat * PI / 180.0, lon * PI / 180.0, 0.0 }, std::string(end + 1), (uint32_t) rank);
+    }
+
+    return LOAD_LABELS_SUCCESS;
+}
+
+void LabelLayer::layout(const glm::mat4 &view_proj, const glm::mat4 &model, const glm::dvec3 &camera,
+    int width, int height, float size)
+{
+    PROFILE_SCOPE("LabelLayer::layout");
+
+    boxes.clear();
+    instances.clear();
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    if (!sorted) {
+        std::stable_sort(labels.begin(), labels.end(), [](const Label &a, const Label &b) {
+            return a.rank < b.rank;
+        });
+        sorted = true;
+    }
+
+    int columns = (width + LABEL_GRID_CELL - 1) / LABEL_GRID_CELL;
+    int rows = (height + LABEL_GRID_CELL - 1) / LABEL_GRID_CELL;
+    cells.resize((size_t) columns * rows);
+    for (std::vector<uint32_t> &cell : cells) {
+        cell.clear();
+    }
+
+    // Positions relative to the camera, so the matrix only rotates and
+    // projects them, as in relative_to_eye()
+    glm::dmat4 transform = glm::dmat4(view_proj) * glm::dmat4(glm::dmat3(glm::dmat4(model)));
+    float ascent = atlas.get_ascent() * size;
+    float descent = atlas.get_descent() * size;
+
+    for (const Label &label : labels) {
+        glm::dvec3 relative = label.position - camera;
+        // Behind the horizon, the normal is close enough to the position
+        if (glm::dot(relative, label.position) > 0.0) {
+            continue;
+        }
+        glm::dvec4 clip = transform * glm::dvec4(relative, 1.0);
+        if (clip.w <= 0.0) {
+            continue;
+        }
+
+        // Centered above the point, in window pixels
+        float x = (float) ((clip.x / clip.w * 0.5 + 0.5) * width);
+        float y = (float) ((clip.y / clip.w * 0.5 + 0.5) * height);
+        float text_width = label.width * size;
+        float pen_x = std::round(x - 0.5f * text_width);
+        float baseline = std::round(y - descent + LABEL_PADDING);
+        glm::vec4 box(pen_x - LABEL_PADDING, baseline + descent - LABEL_PADDING,
+            pen_x + text_width + LABEL_PADDING, baseline + ascent + LABEL_PADDING);
+        if (box.z <= 0.0f || box.w <= 0.0f || box.x >= width || box.y >= height) {
+            continue;
+        }
+
+        int column0 = std::max((int) box.x / LABEL_GRID_CELL, 0);
+        int row0 = std::max((int) box.y / LABEL_GRID_CELL, 0);
+        int column1 = std::min((int) box.z / LABEL_GRID_CELL, columns - 1);
+        int row1 = std::min((int) box.w / LABEL_GRID_CELL, rows - 1);
+
+        bool overlaps = false;
+        for (int row = row0; row <= row1 && !overlaps; row++) {
+            for (int column = column0; column <= column1 && !overlaps; column++) {
+                for (uint32_t other : cells[(size_t) row * columns + column]) {
+                    const glm::vec4 &b = boxes[other];
+                    if (box.x < b.z && b.x < box.z && box.y < b.w && b.y < box.w) {
+                        overlaps = true;
+                        break;
+                    }
+                }
+            }
+        }
+        if (overlaps) {
+            continue;
+        }
+
+        uint32_t index = (uint32_t) boxes.size();
+        boxes.push_back(box);
+        for (int row = row0; row <= row1; row++) {
+            for (int column = column0; column <= column1; column++) {
+                cells[(size_t) row * columns + column].push_back(index);
+            }
+        }
+
+        for (uint32_t i = label.first; i < label.first + label.count; i++) {
+            const GlyphMetrics &glyph = atlas.get_glyph(codepoints[i]);
+            // Spaces have no quad
+            if (glyph.u1 > glyph.u0) {
+                instances.push_back({
+                    pen_x + glyph.x0 * size, baseline + glyph.y0 * size,
+                    pen_x + glyph.x1 * size, baseline + glyph.y1 * size,
+                    glyph.u0, glyph.v0, glyph.u1, glyph.v1
+                });
+            }
+            pen_x += glyph.advance * size;
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#include "LineBuffer.hpp"
+
+LineBuffer::LineBuffer()
+{
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &chunk_buffer);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(LINE_START_ATTR_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(LineVertex),
+        (const void*) offsetof(LineVertex, x));
+    glEnableVertexAttribArray(LINE_START_ATTR_LOCATION);
+    glVertexAttribIPointer(LINE_START_CHUNK_ATTR_LOCATION, 1, GL_UNSIGNED_INT, sizeof(LineVertex),
+        (const void*) offsetof(LineVertex, chunk));
+    glEnableVertexAttribArray(LINE_START_CHUNK_ATTR_LOCATION);
+    glVertexAttribPointer(LINE_END_ATTR_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(LineVertex),
+        (const void*) (sizeof(LineVertex) + offsetof(LineVertex, x)));
+    glEnableVertexAttribArray(LINE_END_ATTR_LOCATION);
+    glVertexAttribIPointer(LINE_END_CHUNK_ATTR_LOCATION, 1, GL_UNSIGNED_INT, sizeof(LineVertex),
+        (const void*) (sizeof(LineVertex) + offsetof(LineVertex, chunk)));
+    glEnableVertexAttribArray(LINE_END_CHUNK_ATTR_LOCATION);
+    // Once per segment, not per vertex
+    glVertexAttribDivisor(LINE_START_ATTR_LOCATION, 1);
+    glVertexAttribDivisor(LINE_START_CHUNK_ATTR_LOCATION, 1);
+    glVertexAttribDivisor(LINE_END_ATTR_LOCATION, 1);
+    glVertexAttribDivisor(LINE_END_CHUNK_ATTR_LOCATION, 1);
+    glBindVertexArray(0);
+}
+
+LineBuffer::~LineBuffer()
+{
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &chunk_buffer);
+}
+
+void LineBuffer::upload(const LineLayer &layer)
+{
+    PROFILE_SCOPE("LineBuffer::upload");
+
+    const std::vector<LineVertex> &vertices = layer.get_vertices();
+    count = vertices.size();
+
+    // Orphans the old storage, the GPU may still be drawing from it
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(LineVertex), vertices.data(), GL_DYNAMIC_DRAW);
+
+    // Empty buffers cannot be bound, so there is always at least one byte
+    const std::vector<LineChunk> &chunks = layer.get_chunks();
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, chunk_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, chunks.empty() ? 1 : chunks.size() * sizeof(LineChunk),
+        chunks.data(), GL_DYNAMIC_DRAW);
+}
+
+void LineBuffer::draw() const
+{
+    if (count < 2) {
+        return;
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LINE_CHUNK_STORAGE_BINDING, chunk_buffer);
+    glBindVertexArray(vao);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei) (count - 1));
+    glBindVertexArray(0);
+}
+
+RenderState LineBuffer::get_render_state(depth_mode mode)
+{
+    RenderState state;
+    state.depth_func = depth_func_nearer(mode, true);
+    state.depth_write = false;
+    state.cull = false;
+    state.blend = true;
+    return state;
+}
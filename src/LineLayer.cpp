@@ -0,0 +1,269 @@
+#include "LineLayer.hpp"
+
+static LineChunk make_chunk(const glm::dvec3 &origin)
+{
+    glm::vec3 high(origin);
+    glm::vec3 low(origin - glm::dvec3(high));
+    return { glm::vec4(high, 0.0f), glm::vec4(low, 0.0f) };
+}
+
+LineLayer::LineLayer(const Ellipsoid &ellipsoid, const Terrain &terrain, void (*notify)(), ThreadPool &pool)
+    : ellipsoid(ellipsoid), terrain(terrain), pool(pool), notify(notify) {}
+
+LineLayer::~LineLayer()
+{
+    if (building) {
+        build_future.wait();
+    }
+}
+
+void LineLayer::add_line(const double *lon_lat, size_t count)
+{
+    if (count < 2) {
+        return;
+    }
+
+    Line line = {};
+    line.first = (uint32_t) normals.size();
+    glm::dvec3 sum(0.0);
+    for (size_t i = 0; i < count; i++) {
+        double lon = lon_lat[2 * i] * PI / 180.0 + GLOBE_LONGITUDE_OFFSET;
+        double lat = lon_lat[2 * i + 1] * PI / 180.0;
+        glm::dvec3 normal = ellipsoid.normal(lat, lon);
+        normals.push_back(glm::vec3(normal));
+        sum += normal;
+    }
+    line.end = (uint32_t) normals.size();
+
+    for (size_t i = line.first; i + 1 < line.end; i++) {
+        // Of the float normals that are split, precise at any angle
+        glm::dvec3 a(normals[i]), b(normals[i + 1]);
+        angles.push_back((float) std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b)));
+        line.longest = std::max(line.longest, angles.back());
+    }
+    angles.push_back(0.0f);
+
+    // A ring around the globe has no middle, its radius covers everything
+    glm::dvec3 center = glm::length(sum) > 1e-9 ? glm::normalize(sum) : glm::dvec3(normals[line.first]);
+    line.center = glm::vec3(center);
+    for (size_t i = line.first; i < line.end; i++) {
+        glm::dvec3 normal(normals[i]);
+        line.radius = std::max(line.radius, (float) std::atan2(glm::length(glm::cross(center, normal)), glm::dot(center, normal)));
+    }
+
+    lines.push_back(std::move(line));
+}
+
+int LineLayer::load_geojson(std::string path)
+{
+    PROFILE_SCOPE("LineLayer::load_geojson");
+
+    int result = read_geojson_lines(path, [this](const double *lon_lat, size_t count) {
+        add_line(lon_lat, count);
+    });
+    return result == PARSE_JSON_SUCCESS ? LOAD_LINES_SUCCESS : LOAD_LINES_FAILURE;
+}
+
+uint32_t LineLayer::select_tier(const Line &line, const glm::dvec3 &camera, double pixel_scale) const
+{
+    // About the nearest the line gets to the camera
+    double distance = glm::length(camera - glm::dvec3(line.center) * EARTH_RADIUS) - line.radius * EARTH_RADIUS;
+    distance = std::max(distance, CAMERA_MIN_ALTITUDE);
+
+    // A piece of angle a is off the arc by R (1 - cos(a / 2)) ~ R a^2 / 8,
+    // take the coarsest tier that keeps that below LINE_PIXEL_ERROR
+    double angle = std::sqrt(8.0 * LINE_PIXEL_ERROR * distance / (EARTH_RADIUS * std::max(pixel_scale, 1e-9)));
+    uint32_t tier = 0;
+    while (tier + 1 < LINE_TIER_COUNT && tier_angle(tier) > angle) {
+        tier++;
+    }
+
+    // Tiers with pieces longer than every segment leave the line as it is,
+    // like tier 0 does then
+    return tier_angle(tier) >= line.longest ? 0 : tier;
+}
+
+void LineLayer::split(Line &line, uint32_t tier) const
+{
+    double max_angle = tier_angle(tier);
+    size_t count = 1;
+    for (size_t point = line.first; point + 1 < line.end; point++) {
+        count += count_pieces(angles[point], max_angle);
+    }
+
+    std::vector<LineVertex> &out = line.tiers[tier];
+    out.resize(count);
+    LineVertex *next = out.data();
+    std::vector<LineChunk> &chunks = line.tier_chunks[tier];
+    chunks.clear();
+    glm::dvec3 origin(0.0);
+    bool on_terrain = terrain.get_tile_count() > 0;
+
+    auto emit = [&](const glm::dvec3 &normal, bool joined) {
+        double height = 0.0;
+        if (on_terrain) {
+            // The z of the normal is the sine of the geodetic latitude
+            double lat = std::asin(std::clamp(normal.z, -1.0, 1.0));
+            double lon = std::atan2(normal.y, normal.x) - GLOBE_LONGITUDE_OFFSET;
+            height = terrain.sample(lat, lon);
+        }
+        glm::dvec3 position = ellipsoid.from_normal(normal, height);
+        if (chunks.empty() || glm::length(position - origin) > LINE_CHUNK_RADIUS) {
+            origin = position;
+            chunks.push_back(make_chunk(origin));
+        }
+        glm::vec3 offset(position - origin);
+        *next++ = { offset.x, offset.y, offset.z, 2 * (uint32_t) (chunks.size() - 1) + (joined ? 1 : 0) };
+    };
+
+    for (size_t point = line.first; point + 1 < line.end; point++) {
+        size_t pieces = count_pieces(angles[point], max_angle);
+        glm::dvec3 a(normals[point]), b(normals[point + 1]);
+        emit(a, true);
+        if (pieces == 1) {
+            continue;
+        }
+        double angle = angles[point];
+        double sin_angle = std::sin(angle);
+        for (size_t piece = 1; piece < pieces; piece++) {
+            // Slerp, so the pieces are equally long. Normalizing keeps the
+            // float rounding of the end points from piling up.
+            double t = (double) piece / (double) pieces;
+            glm::dvec3 normal = sin_angle > 1e-12
+                ? a * std::sin((1.0 - t) * angle) + b * std::sin(t * angle)
+                : a + (b - a) * t;
+            emit(glm::normalize(normal), true);
+        }
+    }
+    emit(glm::dvec3(normals[line.end - 1]), false);
+}
+
+bool LineLayer::rebuild(const glm::dvec3 &camera, double pixel_scale)
+{
+    PROFILE_SCOPE("LineLayer::rebuild");
+
+    size_t count = lines.size();
+    wanted.resize(count);
+    std::atomic<bool> changed(!built);
+    pool.parallel_for(count, 1024, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            wanted[i] = select_tier(lines[i], camera, pixel_scale);
+            if (wanted[i] != lines[i].tier) {
+                changed.store(true, std::memory_order_relaxed);
+            }
+        }
+    });
+    if (!changed.load()) {
+        return false;
+    }
+
+    // Split what is not cached yet. Tiers two finer than the new one are
+    // dropped, zooming out that far frees the detail.
+    pool.parallel_for(count, 64, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            Line &line = lines[i];
+            line.tier = wanted[i];
+            if (line.tiers[line.tier].empty()) {
+                split(line, line.tier);
+            }
+            for (uint32_t tier = line.tier + 2; tier < LINE_TIER_COUNT; tier++) {
+                std::vector<LineVertex>().swap(line.tiers[tier]);
+                std::vector<LineChunk>().swap(line.tier_chunks[tier]);
+            }
+        }
+    });
+
+    offsets.resize(count + 1);
+    chunk_offsets.resize(count + 1);
+    offsets[0] = 0;
+    chunk_offsets[0] = 0;
+    for (size_t i = 0; i < count; i++) {
+        offsets[i + 1] = offsets[i] + lines[i].tiers[lines[i].tier].size();
+        chunk_offsets[i + 1] = chunk_offsets[i] + lines[i].tier_chunks[lines[i].tier].size();
+    }
+    staging.resize(offsets[count]);
+    staging_chunks.resize(chunk_offsets[count]);
+    pool.parallel_for(count, 256, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const std::vector<LineVertex> &tier = lines[i].tiers[lines[i].tier];
+            const std::vector<LineChunk> &tier_chunks = lines[i].tier_chunks[lines[i].tier];
+            // Chunk indices from the first chunk of the line on
+            uint32_t shift = 2 * (uint32_t) chunk_offsets[i];
+            LineVertex *out = &staging[offsets[i]];
+            for (const LineVertex &vertex : tier) {
+                *out = vertex;
+                out->chunk += shift;
+                out++;
+            }
+            std::copy(tier_chunks.begin(), tier_chunks.end(), staging_chunks.begin() + chunk_offsets[i]);
+        }
+    });
+
+    built = true;
+    return true;
+}
+
+bool LineLayer::finish_build()
+{
+    if (!building) {
+        return false;
+    }
+    build_future.get();
+    building = false;
+    if (build_changed) {
+        vertices.swap(staging);
+        chunks.swap(staging_chunks);
+    }
+    return build_changed;
+}
+
+bool LineLayer::update(const glm::dvec3 &camera, double pixel_scale)
+{
+    if (building && build_future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return false;
+    }
+    bool swapped = finish_build();
+
+    // The view may have changed while the last build ran
+    if (!requested || camera != build_camera || pixel_scale != build_pixel_scale) {
+        requested = true;
+        build_camera = camera;
+        build_pixel_scale = pixel_scale;
+        building = true;
+        build_future = pool.submit([this]() {
+            build_changed = rebuild(build_camera, build_pixel_scale);
+            if (notify != nullptr) {
+                notify();
+            }
+        });
+    }
+
+    return swapped;
+}
+
+bool LineLayer::build(const glm::dvec3 &camera, double pixel_scale)
+{
+    // A build of update() may have changed the vertices already
+    bool swapped = finish_build();
+    if (!rebuild(camera, pixel_scale)) {
+        return swapped;
+    }
+    vertices.swap(staging);
+    chunks.swap(staging_chunks);
+    return true;
+}
+
+bool LineLayer::clear_cache()
+{
+    bool swapped = finish_build();
+    for (Line &line : lines) {
+        for (std::vector<LineVertex> &tier : line.tiers) {
+            std::vector<LineVertex>().swap(tier);
+        }
+        for (std::vector<LineChunk> &tier : line.tier_chunks) {
+            std::vector<LineChunk>().swap(tier);
+        }
+    }
+    built = false;
+    return swapped;
+}
@@ -0,0 +1,114 @@
+#include "MappedFile.hpp"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+#if defined(_WIN32)
+
+int MappedFile::map(std::string path)
+{
+    unmap();
+
+    HANDLE file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        std::cerr << "Could not open " << path << std::endl;
+        return MAP_FILE_FAILURE;
+    }
+    file = file_handle;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0) {
+        std::cerr << "Could not map empty file " << path << std::endl;
+        unmap();
+        return MAP_FILE_FAILURE;
+    }
+
+    mapping = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        std::cerr << "Could not map " << path << std::endl;
+        unmap();
+        return MAP_FILE_FAILURE;
+    }
+
+    data = (const uint8_t*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        std::cerr << "Could not map " << path << std::endl;
+        unmap();
+        return MAP_FILE_FAILURE;
+    }
+    size = (size_t) file_size.QuadPart;
+
+    return MAP_FILE_SUCCESS;
+}
+
+void MappedFile::unmap()
+{
+    if (data != nullptr) {
+        UnmapViewOfFile(data);
+    }
+    if (mapping != nullptr) {
+        CloseHandle(mapping);
+    }
+    if (file != nullptr) {
+        CloseHandle(file);
+    }
+    data = nullptr;
+    size = 0;
+    mapping = nullptr;
+    file = nullptr;
+}
+
+#else
+
+int MappedFile::map(std::string path)
+{
+    unmap();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Could not open " << path << std::endl;
+        return MAP_FILE_FAILURE;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        std::cerr << "Could not map empty file " << path << std::endl;
+        close(fd);
+        return MAP_FILE_FAILURE;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    void *mapped = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Could not map " << path << std::endl;
+        return MAP_FILE_FAILURE;
+    }
+    data = (const uint8_t*) mapped;
+    size = (size_t) info.st_size;
+
+    return MAP_FILE_SUCCESS;
+}
+
+void MappedFile::unmap()
+{
+    if (data != nullptr) {
+        munmap((void*) data, size);
+    }
+    data = nullptr;
+    size = 0;
+}
+
+#endif
@@ -0,0 +1,75 @@
+#include "MarkerBuffer.hpp"
+
+MarkerBuffer::MarkerBuffer()
+{
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(MARKER_POSITION_HIGH_ATTR_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(MarkerInstance),
+        (const void*) offsetof(MarkerInstance, high));
+    glEnableVertexAttribArray(MARKER_POSITION_HIGH_ATTR_LOCATION);
+    glVertexAttribPointer(MARKER_POSITION_LOW_ATTR_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(MarkerInstance),
+        (const void*) offsetof(MarkerInstance, low));
+    glEnableVertexAttribArray(MARKER_POSITION_LOW_ATTR_LOCATION);
+    glVertexAttribPointer(MARKER_COLOR_ATTR_LOCATION, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(MarkerInstance),
+        (const void*) offsetof(MarkerInstance, color));
+    glEnableVertexAttribArray(MARKER_COLOR_ATTR_LOCATION);
+    // Once per marker, not per vertex
+    glVertexAttribDivisor(MARKER_POSITION_HIGH_ATTR_LOCATION, 1);
+    glVertexAttribDivisor(MARKER_POSITION_LOW_ATTR_LOCATION, 1);
+    glVertexAttribDivisor(MARKER_COLOR_ATTR_LOCATION, 1);
+    glBindVertexArray(0);
+}
+
+MarkerBuffer::~MarkerBuffer()
+{
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+}
+
+bool MarkerBuffer::upload(MarkerLayer &layer)
+{
+    PROFILE_SCOPE("MarkerBuffer::upload");
+
+    layer.update();
+    size_t begin = 0, end = 0;
+    layer.take_dirty_range(begin, end);
+
+    const std::vector<MarkerInstance> &instances = layer.get_instances();
+    bool resized = count != instances.size();
+    count = instances.size();
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (count > capacity) {
+        // Room to grow, so adding a few markers does not copy all of them
+        capacity = count + count / 2;
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(MarkerInstance), nullptr, GL_DYNAMIC_DRAW);
+        begin = 0;
+        end = count;
+    }
+    if (begin < end) {
+        glBufferSubData(GL_ARRAY_BUFFER, begin * sizeof(MarkerInstance), (end - begin) * sizeof(MarkerInstance), &instances[begin]);
+    }
+    return resized || begin < end;
+}
+
+void MarkerBuffer::draw() const
+{
+    if (count == 0) {
+        return;
+    }
+
+    glBindVertexArray(vao);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei) count);
+    glBindVertexArray(0);
+}
+
+RenderState MarkerBuffer::get_render_state(depth_mode mode)
+{
+    RenderState state;
+    state.depth_func = depth_func_nearer(mode);
+    state.cull = false;
+    return state;
+}
@@ -0,0 +1,129 @@
+#include "MarkerLayer.hpp"
+
+MarkerLayer::MarkerLayer(const Ellipsoid &ellipsoid)
+    : ellipsoid(ellipsoid) {}
+
+void MarkerLayer::mark_dirty(size_t begin, size_t end)
+{
+    if (dirty_begin == dirty_end) {
+        dirty_begin = begin;
+        dirty_end = end;
+    }
+    else {
+        dirty_begin = std::min(dirty_begin, begin);
+        dirty_end = std::max(dirty_end, end);
+    }
+    converted = false;
+}
+
+void MarkerLayer::add(Geodetic position, uint32_t color)
+{
+    size_t index = size();
+    resize(index + 1);
+    set(index, position, color);
+}
+
+void MarkerLayer::set(size_t index, Geodetic position, uint32_t color)
+{
+    coords.lat[index] = position.lat;
+    // Instances are in the globe's model space
+    coords.lon[index] = position.lon + GLOBE_LONGITUDE_OFFSET;
+    coords.height[index] = position.height;
+    colors[index] = color;
+    mark_dirty(index, index + 1);
+}
+
+void MarkerLayer::resize(size_t count)
+{
+    size_t old_count = size();
+    coords.resize(count);
+    colors.resize(count, 0xFFFFFFFF);
+    instances.resize(count);
+    if (count > old_count) {
+        mark_dirty(old_count, count);
+    }
+    else {
+        dirty_end = std::min(dirty_end, count);
+        dirty_begin = std::min(dirty_begin, dirty_end);
+    }
+}
+
+int MarkerLayer::load_csv(std::string path)
+{
+    PROFILE_SCOPE("MarkerLayer::load_csv");
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Could not open " << path << std::endl;
+        return LOAD_MARKERS_FAILURE;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        const char *cursor = line.c_str();
+        char *end = nullptr;
+        double values[3] = { 0.0, 0.0, 0.0 };
+        uint32_t color = 0xFFFFFFFF;
+
+        // strtod stops at the comma, skip it and parse the next field
+        int fields = 0;
+        for (; fields < 3; fields++) {
+            values[fields] = std::strtod(cursor, &end);
+            if (end == cursor) {
+                break;
+            }
+            cursor = *end == ',' ? end + 1 : end;
+        }
+        if (fields < 2) {
+            continue;
+        }
+        if (fields == 3 && end != nullptr && *end == ',') {
+            // rrggbb into RGBA8 with the red channel in the lowest byte
+            uint32_t rgb = (uint32_t) std::strtoul(cursor, nullptr, 16);
+            color = 0xFF000000 | ((rgb & 0xFF) << 16) | (rgb & 0xFF00) | ((rgb >> 16) & 0xFF);
+        }
+
+        add({ values[0] * PI / 180.0, values[1] * PI / 180.0, values[2] }, color);
+    }
+
+    return LOAD_MARKERS_SUCCESS;
+}
+
+void MarkerLayer::update(ThreadPool &pool)
+{
+    PROFILE_SCOPE("MarkerLayer::update");
+
+    if (converted) {
+        return;
+    }
+
+    // Small blocks on the stack, so no ECEF copy of the whole layer exists
+    static const size_t BLOCK = 256;
+    pool.parallel_for(dirty_end - dirty_begin, GEODETIC_BATCH_GRAIN, [&](size_t begin, size_t end) {
+        double x[BLOCK], y[BLOCK], z[BLOCK];
+        for (size_t block = dirty_begin + begin; block < dirty_begin + end; block += BLOCK) {
+            size_t count = std::min(BLOCK, dirty_begin + end - block);
+            ellipsoid.to_ecef(&coords.lat[block], &coords.lon[block], &coords.height[block], x, y, z, count);
+            for (size_t i = 0; i < count; i++) {
+                MarkerInstance &instance = instances[block + i];
+                instance.high[0] = (float) x[i];
+                instance.high[1] = (float) y[i];
+                instance.high[2] = (float) z[i];
+                instance.low[0] = (float) (x[i] - instance.high[0]);
+                instance.low[1] = (float) (y[i] - instance.high[1]);
+                instance.low[2] = (float) (z[i] - instance.high[2]);
+                instance.color = colors[block + i];
+            }
+        }
+    });
+
+    converted = true;
+}
+
+void MarkerLayer::take_dirty_range(size_t &begin, size_t &end)
+{
+    begin = dirty_begin;
+    end = dirty_end;
+    dirty_begin = 0;
+    dirty_end = 0;
+}
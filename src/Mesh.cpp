@@ -0,0 +1,81 @@
+#include "Mesh.hpp"
+
+Mesh::Mesh(const std::vector<float> &vertices, const std::vector<float> &texcoords, const std::vector<uint32_t> &indices,
+    const std::vector<float> &morphs)
+{
+    PROFILE_SCOPE("Mesh::Mesh");
+
+    index_count = (GLsizei) indices.size();
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glGenBuffers(morphs.empty() ? 2 : 3, vbo);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo[0]);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo[1]);
+    glBufferData(GL_ARRAY_BUFFER, texcoords.size() * sizeof(float), texcoords.data(), GL_STATIC_DRAW);
+
+    if (!morphs.empty()) {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo[2]);
+        glBufferData(GL_ARRAY_BUFFER, morphs.size() * sizeof(float), morphs.data(), GL_STATIC_DRAW);
+    }
+
+    // Recorded in the VAO
+    glGenBuffers(1, &ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+}
+
+Mesh::Mesh(const Sphere &sphere)
+    : Mesh(sphere.get_vertices(), sphere.get_texcoords(), sphere.get_indices()) {}
+
+Mesh::Mesh(const GlobePatch &patch)
+    : Mesh(patch.vertices, patch.texcoords, patch.indices, patch.morphs) {}
+
+Mesh::~Mesh()
+{
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &ebo);
+    glDeleteBuffers(3, vbo);
+}
+
+void Mesh::set_attributes(GLint pos_attr, GLint tex_attr, GLint morph_attr) const
+{
+    glBindVertexArray(vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo[0]);
+    glVertexAttribPointer(pos_attr, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(pos_attr);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo[1]);
+    // NOTE: Fails for some reason (probably optimization by the GPU driver),
+    // if texcoords are not used in shaders
+    glVertexAttribPointer(tex_attr, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(tex_attr);
+
+    if (vbo[2] != 0 && morph_attr >= 0) {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo[2]);
+        glVertexAttribPointer(morph_attr, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), nullptr);
+        glEnableVertexAttribArray(morph_attr);
+    }
+
+    glBindVertexArray(0);
+}
+
+void Mesh::draw() const
+{
+    glBindVertexArray(vao);
+    // Number of indices, not their size in bytes
+    glDrawElements(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, nullptr);
+}
+
+void Mesh::draw(uint32_t first_index, uint32_t count) const
+{
+    glBindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, (GLsizei) count, GL_UNSIGNED_INT, (const void*) ((size_t) first_index * sizeof(uint32_t)));
+}
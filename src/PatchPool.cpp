@@ -0,0 +1,122 @@
+#include "PatchPool.hpp"
+
+PatchPool::PatchPool(uint32_t slot_vertices, uint32_t slot_indices, uint32_t capacity)
+    : slot_vertices(slot_vertices), slot_indices(slot_indices), capacity(capacity)
+{
+    PROFILE_SCOPE("PatchPool::PatchPool");
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    // Allocated once, patches are copied in with glBufferSubData
+    static const size_t floats_per_vertex[3] = { 3, 2, 4 };
+    glGenBuffers(3, vbo);
+    for (int i = 0; i < 3; i++) {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo[i]);
+        glBufferData(GL_ARRAY_BUFFER, (size_t) capacity * slot_vertices * floats_per_vertex[i] * sizeof(float), nullptr, GL_STATIC_DRAW);
+    }
+
+    // Recorded in the VAO
+    glGenBuffers(1, &ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (size_t) capacity * slot_indices * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+
+    glGenBuffers(1, &indirect_buffer);
+
+    // Handed out from the back, so slot 0 goes first
+    for (uint32_t slot = capacity; slot > 0; slot--) {
+        free_slots.push_back(slot - 1);
+    }
+}
+
+PatchPool::~PatchPool()
+{
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &ebo);
+    glDeleteBuffers(3, vbo);
+    glDeleteBuffers(1, &indirect_buffer);
+}
+
+int PatchPool::allocate(const GlobePatch &patch)
+{
+    PROFILE_SCOPE("PatchPool::allocate");
+
+    size_t vertex_count = patch.vertices.size() / 3;
+    if (vertex_count > slot_vertices || patch.indices.size() > slot_indices) {
+        std::cerr << "Patch with " << vertex_count << " vertices and " << patch.indices.size()
+            << " indices does not fit into pool slots of " << slot_vertices << " and " << slot_indices << std::endl;
+        return ALLOCATE_PATCH_FAILURE;
+    }
+    if (free_slots.empty()) {
+        std::cerr << "Patch pool with " << capacity << " slots is full" << std::endl;
+        return ALLOCATE_PATCH_FAILURE;
+    }
+    uint32_t slot = free_slots.back();
+    free_slots.pop_back();
+
+    size_t first_vertex = (size_t) slot * slot_vertices;
+    glBindBuffer(GL_ARRAY_BUFFER, vbo[0]);
+    glBufferSubData(GL_ARRAY_BUFFER, first_vertex * 3 * sizeof(float), patch.vertices.size() * sizeof(float), patch.vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, vbo[1]);
+    glBufferSubData(GL_ARRAY_BUFFER, first_vertex * 2 * sizeof(float), patch.texcoords.size() * sizeof(float), patch.texcoords.data());
+    glBindBuffer(GL_ARRAY_BUFFER, vbo[2]);
+    glBufferSubData(GL_ARRAY_BUFFER, first_vertex * 4 * sizeof(float), patch.morphs.size() * sizeof(float), patch.morphs.data());
+
+    // Not through the VAO, binding the element buffer outside of it would
+    // change the VAO that happens to be bound
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t) slot * slot_indices * sizeof(uint32_t), patch.indices.size() * sizeof(uint32_t), patch.indices.data());
+
+    return (int) slot;
+}
+
+void PatchPool::release(uint32_t slot)
+{
+    free_slots.push_back(slot);
+}
+
+void PatchPool::set_attributes(GLint pos_attr, GLint tex_attr, GLint morph_attr) const
+{
+    glBindVertexArray(vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo[0]);
+    glVertexAttribPointer(pos_attr, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(pos_attr);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo[1]);
+    glVertexAttribPointer(tex_attr, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(tex_attr);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo[2]);
+    glVertexAttribPointer(morph_attr, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(morph_attr);
+
+    glBindVertexArray(0);
+}
+
+void PatchPool::add_draw(uint32_t slot, uint32_t first_index, uint32_t count)
+{
+    commands.push_back({
+        count, 1, slot * slot_indices + first_index, (int32_t) (slot * slot_vertices), 0
+    });
+}
+
+void PatchPool::draw()
+{
+    PROFILE_SCOPE("PatchPool::draw");
+
+    if (commands.empty()) {
+        return;
+    }
+
+    // Orphaned like the uniform buffers, the previous frame may still read it
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STREAM_DRAW);
+
+    glBindVertexArray(vao);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, (GLsizei) commands.size(), 0);
+
+    commands.clear();
+}
@@ -0,0 +1,125 @@
+#include "Picker.hpp"
+
+Picker::Picker(const Ellipsoid &ellipsoid, const Terrain &terrain)
+    : ellipsoid(ellipsoid), terrain(terrain)
+{
+}
+
+bool Picker::intersect_ellipsoid(const glm::dvec3 &origin, const glm::dvec3 &direction, double height, double &t_near, double &t_far) const
+{
+    // Scaled to the unit sphere. Growing both axes by height is not the
+    // surface at that height, but within e^2 * height of it.
+    glm::dvec3 scale(
+        1.0 / (ellipsoid.get_semi_major() + height),
+        1.0 / (ellipsoid.get_semi_major() + height),
+        1.0 / (ellipsoid.get_semi_minor() + height));
+    glm::dvec3 o = origin * scale;
+    glm::dvec3 d = direction * scale;
+
+    double a = glm::dot(d, d);
+    double b = glm::dot(o, d);
+    double c = glm::dot(o, o) - 1.0;
+    double discriminant = b * b - a * c;
+    if (discriminant < 0.0) {
+        return false;
+    }
+    // Without cancellation between b and the root
+    double q = -(b + std::copysign(std::sqrt(discriminant), b));
+    double t0 = q / a;
+    double t1 = q != 0.0 ? c / q : t0;
+    t_near = std::min(t0, t1);
+    t_far = std::max(t0, t1);
+    return true;
+}
+
+double Picker::height_above_ground(const glm::dvec3 &origin, const glm::dvec3 &direction, double t, Geodetic &geodetic) const
+{
+    geodetic = ellipsoid.to_geodetic(origin + direction * t);
+    geodetic.lon -= GLOBE_LONGITUDE_OFFSET;
+    return geodetic.height - terrain.sample(geodetic.lat, geodetic.lon);
+}
+
+double Picker::ground_radius(const glm::dvec3 &direction) const
+{
+    glm::dvec3 d = glm::normalize(direction);
+    double a = ellipsoid.get_semi_major();
+    double b = ellipsoid.get_semi_minor();
+    double radius = 1.0 / std::sqrt((d.x * d.x + d.y * d.y) / (a * a) + d.z * d.z / (b * b));
+
+    // Terrain heights are along the normal, which is at most 0.2 degrees
+    // off the direction, so they add to the radius within millimeters
+    Geodetic geodetic = ellipsoid.to_geodetic(d * radius);
+    return radius + terrain.sample(geodetic.lat, geodetic.lon - GLOBE_LONGITUDE_OFFSET);
+}
+
+bool Picker::intersect(const glm::dvec3 &origin, const glm::dvec3 &direction, PickHit &hit) const
+{
+    PROFILE_SCOPE("Picker::intersect");
+
+    bool has_terrain = terrain.get_tile_count() > 0;
+    // The outer shell, or the ellipsoid itself without terrain
+    double t_near = 0.0, t_far = 0.0;
+    double margin = TERRAIN_MAX_HEIGHT * 0.01;
+    if (!intersect_ellipsoid(origin, direction, has_terrain ? TERRAIN_MAX_HEIGHT + margin : 0.0, t_near, t_far) || t_far < 0.0) {
+        return false;
+    }
+
+    Geodetic geodetic = {};
+    double t = std::max(t_near, 0.0);
+    if (has_terrain) {
+        // The ground is above the inner shell, so the ray hits it before
+        double t_end = t_far;
+        double inner_near = 0.0, inner_far = 0.0;
+        if (intersect_ellipsoid(origin, direction, TERRAIN_MIN_HEIGHT - margin, inner_near, inner_far) && inner_far >= 0.0) {
+            t_end = std::max(inner_near, 0.0);
+        }
+
+        double t_above = t;
+        bool found = false;
+        while (true) {
+            double above = height_above_ground(origin, direction, t, geodetic);
+            if (above <= 0.0) {
+                found = true;
+                break;
+            }
+            if (t >= t_end) {
+                break;
+            }
+            // The height changes along the normal, which is the direction
+            // the height grows fastest in
+            double slope = glm::dot(direction, ellipsoid.normal(geodetic.lat, geodetic.lon + GLOBE_LONGITUDE_OFFSET));
+            double step = terrain.clearance(geodetic.lat, geodetic.lon, geodetic.height, slope);
+            t_above = t;
+            t = std::min(t + std::max(step, PICK_MIN_STEP), t_end);
+        }
+        if (!found) {
+            return false;
+        }
+        // Started below the ground
+        if (t == t_above) {
+            return false;
+        }
+
+        double t_below = t;
+        for (int i = 0; i < REFINE_ITERATIONS; i++) {
+            double middle = 0.5 * (t_above + t_below);
+            if (height_above_ground(origin, direction, middle, geodetic) > 0.0) {
+                t_above = middle;
+            }
+            else {
+                t_below = middle;
+            }
+        }
+        t = t_below;
+    }
+    else if (t_near < 0.0) {
+        return false;
+    }
+
+    hit.position = origin + direction * t;
+    hit.distance = t;
+    hit.geodetic = ellipsoid.to_geodetic(hit.position);
+    hit.geodetic.lon -= GLOBE_LONGITUDE_OFFSET;
+    hit.geodetic.lon -= 2.0 * PI * std::floor((hit.geodetic.lon + PI) / (2.0 * PI));
+    return true;
+}
@@ -0,0 +1,89 @@
+#include "Profiler.hpp"
+
+std::atomic<bool> Profiler::enabled{ false };
+std::chrono::steady_clock::time_point Profiler::epoch = std::chrono::steady_clock::now();
+std::mutex Profiler::registry_mutex;
+std::vector<std::unique_ptr<Profiler::ThreadBuffer>> Profiler::registry;
+
+void Profiler::set_enabled(bool enable)
+{
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+Profiler::ThreadBuffer &Profiler::thread_buffer()
+{
+    // Owned by the registry, so events survive the thread that recorded them
+    thread_local ThreadBuffer *buffer = nullptr;
+    if (buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.emplace_back(new ThreadBuffer());
+        buffer = registry.back().get();
+        buffer->thread_id = (uint32_t) registry.size();
+    }
+
+    return *buffer;
+}
+
+void Profiler::set_thread_name(std::string name)
+{
+    ThreadBuffer &buffer = thread_buffer();
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    buffer.thread_name = name;
+}
+
+void Profiler::record(const char *name, uint64_t begin_ns, uint64_t end_ns)
+{
+    ThreadBuffer &buffer = thread_buffer();
+    // Only threads that record pay for a ring, not every named one. dump()
+    // reads it only after the release below.
+    if (buffer.events.empty()) {
+        buffer.events.resize(PROFILER_EVENTS_PER_THREAD);
+    }
+    uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    buffer.events[index % PROFILER_EVENTS_PER_THREAD] = { name, begin_ns, end_ns };
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+int Profiler::dump(std::string path)
+{
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Could not open " << path << "!" << std::endl;
+        return DUMP_TRACE_FAILURE;
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    // trace_event timestamps are in microseconds
+    file.precision(3);
+    file << std::fixed;
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (const std::unique_ptr<ThreadBuffer> &buffer : registry) {
+        if (!buffer->thread_name.empty()) {
+            file << (first ? "" : ",") << "\n"
+                << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread_id
+                << ",\"args\":{\"name\":\"" << buffer->thread_name << "\"}}";
+            first = false;
+        }
+
+        uint64_t written = buffer->written.load(std::memory_order_acquire);
+        uint64_t begin = written > PROFILER_EVENTS_PER_THREAD ? written - PROFILER_EVENTS_PER_THREAD : 0;
+        for (uint64_t i = begin; i < written; i++) {
+            const Event &event = buffer->events[i % PROFILER_EVENTS_PER_THREAD];
+            file << (first ? "" : ",") << "\n"
+                << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_id
+                << ",\"ts\":" << (double) event.begin_ns / 1000.0
+                << ",\"dur\":" << (double) (event.end_ns - event.begin_ns) / 1000.0 << "}";
+            first = false;
+        }
+    }
+    file << "\n]}\n";
+
+    if (!file) {
+        std::cerr << "Could not write " << path << "!" << std::endl;
+        return DUMP_TRACE_FAILURE;
+    }
+
+    return DUMP_TRACE_SUCCESS;
+}
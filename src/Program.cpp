@@ -0,0 +1,143 @@
+#include "Program.hpp"
+
+Program::~Program()
+{
+    glDeleteProgram(program);
+}
+
+bool Program::has_parallel_compile()
+{
+    return GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile;
+}
+
+void Program::enable_parallel_compile()
+{
+    // 0xFFFFFFFF lets the implementation pick the number of threads
+    if (GLAD_GL_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    }
+    else if (GLAD_GL_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+    }
+}
+
+int Program::check_link_status(const char *what) const
+{
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        GLint len = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &len);
+
+        std::vector<char> log(len + 1, '\0');
+        glGetProgramInfoLog(program, len, nullptr, log.data());
+
+        std::cerr << what << " failed!\n" << log.data() << std::endl;
+
+        return LINK_PROGRAM_FAILURE;
+    }
+
+    return LINK_PROGRAM_SUCCESS;
+}
+
+int Program::link(const Shader &vertex_shader, const Shader &fragment_shader, bool retrievable)
+{
+    submit_link(vertex_shader, fragment_shader, retrievable);
+    return check_link();
+}
+
+void Program::submit_link(const Shader &vertex_shader, const Shader &fragment_shader, bool retrievable)
+{
+    PROFILE_SCOPE("Program::submit_link");
+
+    if (program == 0) {
+        program = glCreateProgram();
+    }
+    uniform_locations.clear();
+    if (retrievable) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    glAttachShader(program, vertex_shader.get_id());
+    glAttachShader(program, fragment_shader.get_id());
+    glLinkProgram(program);
+    // The program keeps the compiled code, the shaders can be deleted
+    glDetachShader(program, vertex_shader.get_id());
+    glDetachShader(program, fragment_shader.get_id());
+}
+
+bool Program::is_link_complete() const
+{
+    if (!has_parallel_compile()) {
+        return true;
+    }
+
+    // Same value for the KHR and ARB extension
+    GLint complete = GL_FALSE;
+    glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
+
+int Program::check_link() const
+{
+    PROFILE_SCOPE("Program::check_link");
+
+    return check_link_status("Program linking");
+}
+
+int Program::load_binary(GLenum format, const std::vector<uint8_t> &binary)
+{
+    PROFILE_SCOPE("Program::load_binary");
+
+    if (program == 0) {
+        program = glCreateProgram();
+    }
+
+    uniform_locations.clear();
+    glProgramBinary(program, format, binary.data(), (GLsizei) binary.size());
+
+    // A rejected binary is expected, do not report it like a link error
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        // Start over with a clean program for link()
+        glDeleteProgram(program);
+        program = 0;
+        return LINK_PROGRAM_FAILURE;
+    }
+
+    return LINK_PROGRAM_SUCCESS;
+}
+
+bool Program::get_binary(GLenum &format, std::vector<uint8_t> &binary) const
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return false;
+    }
+
+    binary.resize(length);
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    binary.resize(written);
+
+    return written > 0;
+}
+
+GLint Program::get_uniform_location(const std::string &name) const
+{
+    auto it = uniform_locations.find(name);
+    if (it != uniform_locations.end()) {
+        return it->second;
+    }
+
+    GLint location = glGetUniformLocation(program, name.c_str());
+    uniform_locations.emplace(name, location);
+    return location;
+}
+
+void Program::use() const
+{
+    glUseProgram(program);
+}
@@ -0,0 +1,200 @@
+#include "ProgramCache.hpp"
+
+ProgramCache::ProgramCache(std::string directory) : directory(directory)
+{
+    std::string driver;
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        const GLubyte *value = glGetString(name);
+        if (value != nullptr) {
+            driver += (const char*) value;
+        }
+        driver += '\n';
+    }
+    driver_hash = fnv1a(driver);
+
+    GLint format_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+    supported = format_count > 0;
+}
+
+std::string ProgramCache::entry_path(uint64_t source_hash) const
+{
+    std::stringstream path;
+    path << directory << "/" << std::hex << std::setw(16) << std::setfill('0') << source_hash << ".bin";
+    return path.str();
+}
+
+bool ProgramCache::read_entry(uint64_t source_hash, GLenum &format, std::vector<uint8_t> &binary) const
+{
+    PROFILE_SCOPE("ProgramCache::read_entry");
+
+    std::ifstream file(entry_path(source_hash), std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    Header header;
+    if (!file.read((char*) &header, sizeof(header))
+        || std::string(header.magic, 4) != "CGEP"
+        || header.version != CACHE_VERSION
+        || header.source_hash != source_hash
+        || header.driver_hash != driver_hash) {
+        return false;
+    }
+
+    binary.resize(header.length);
+    if (!file.read((char*) binary.data(), header.length)) {
+        return false;
+    }
+    format = header.format;
+
+    return true;
+}
+
+void ProgramCache::write_entry(uint64_t source_hash, GLenum format, const std::vector<uint8_t> &binary) const
+{
+    PROFILE_SCOPE("ProgramCache::write_entry");
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    // Write to a temporary file first, so a crash never leaves a torn entry
+    std::string path = entry_path(source_hash);
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Could not write program cache " << temp_path << std::endl;
+            return;
+        }
+
+        Header header = { { 'C', 'G', 'E', 'P' }, CACHE_VERSION, source_hash, driver_hash, format, (uint32_t) binary.size() };
+        file.write((const char*) &header, sizeof(header));
+        file.write((const char*) binary.data(), binary.size());
+        if (!file) {
+            std::cerr << "Could not write program cache " << temp_path << std::endl;
+            return;
+        }
+    }
+
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        std::cerr << "Could not write program cache " << path << ": " << error.message() << std::endl;
+    }
+}
+
+void ProgramCache::add(Program &program, std::string vertex_path, std::string fragment_path, uint32_t features)
+{
+    Request request;
+    request.program = &program;
+    request.vertex_path = vertex_path;
+    request.fragment_path = fragment_path;
+    request.features = features;
+    requests.push_back(std::move(request));
+}
+
+void ProgramCache::submit()
+{
+    PROFILE_SCOPE("ProgramCache::submit");
+
+    Program::enable_parallel_compile();
+
+    // Compiles first, so the driver has all of them queued before any link
+    std::vector<Request*> misses;
+    ShaderPreprocessor preprocessor;
+    for (Request &request : requests) {
+        std::string vertex_src, fragment_src;
+        if (preprocessor.preprocess(request.vertex_path, request.features, vertex_src) != PREPROCESS_SHADER_SUCCESS) {
+            submit_failed = true;
+            continue;
+        }
+        request.vertex_name = preprocessor.describe();
+        if (preprocessor.preprocess(request.fragment_path, request.features, fragment_src) != PREPROCESS_SHADER_SUCCESS) {
+            submit_failed = true;
+            continue;
+        }
+        request.fragment_name = preprocessor.describe();
+
+        // Separator, so moving text from one stage to the other changes the hash
+        request.source_hash = fnv1a(vertex_src);
+        request.source_hash = fnv1a("\0", 1, request.source_hash);
+        request.source_hash = fnv1a(fragment_src, request.source_hash);
+
+        if (supported) {
+            GLenum format = 0;
+            std::vector<uint8_t> binary;
+            if (read_entry(request.source_hash, format, binary)
+                && request.program->load_binary(format, binary) == LINK_PROGRAM_SUCCESS) {
+                request.cached = true;
+                continue;
+            }
+        }
+
+        // Cache miss or rejected binary, build from source
+        request.vertex_shader.reset(new Shader(GL_VERTEX_SHADER));
+        request.fragment_shader.reset(new Shader(GL_FRAGMENT_SHADER));
+        request.vertex_shader->submit_source(vertex_src);
+        request.fragment_shader->submit_source(fragment_src);
+        misses.push_back(&request);
+    }
+
+    for (Request *request : misses) {
+        request->program->submit_link(*request->vertex_shader, *request->fragment_shader, supported);
+    }
+}
+
+bool ProgramCache::poll() const
+{
+    for (const Request &request : requests) {
+        if (!request.cached && request.vertex_shader && !request.program->is_link_complete()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int ProgramCache::finish()
+{
+    PROFILE_SCOPE("ProgramCache::finish");
+
+    // Keep the driver threads busy without spinning on the status queries
+    while (!poll()) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    int result = submit_failed ? LOAD_PROGRAM_FAILURE : LOAD_PROGRAM_SUCCESS;
+    for (Request &request : requests) {
+        if (request.cached || !request.vertex_shader) {
+            continue;
+        }
+
+        // Report compile errors first, the link log only repeats them
+        if (request.vertex_shader->check_status(request.vertex_name) != LOAD_SHADER_SUCCESS
+            || request.fragment_shader->check_status(request.fragment_name) != LOAD_SHADER_SUCCESS
+            || request.program->check_link() != LINK_PROGRAM_SUCCESS) {
+            result = LOAD_PROGRAM_FAILURE;
+            continue;
+        }
+
+        if (supported) {
+            GLenum format = 0;
+            std::vector<uint8_t> binary;
+            if (request.program->get_binary(format, binary)) {
+                write_entry(request.source_hash, format, binary);
+            }
+        }
+    }
+
+    requests.clear();
+    submit_failed = false;
+
+    return result;
+}
+
+int ProgramCache::load_program(Program &program, std::string vertex_path, std::string fragment_path, uint32_t features)
+{
+    add(program, vertex_path, fragment_path, features);
+    submit();
+    return finish();
+}
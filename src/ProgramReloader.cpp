@@ -0,0 +1,67 @@
+#include "ProgramReloader.hpp"
+
+// Editors also write backups, swap files and the like into the directory
+static bool is_shader_source(const std::string &path)
+{
+    std::string extension = std::filesystem::path(path).extension().string();
+    return extension == ".vert" || extension == ".frag" || extension == ".glsl";
+}
+
+ProgramReloader::ProgramReloader(ProgramCache &cache, std::string directory, void (*notify)())
+    : cache(cache), watcher(directory, notify) {}
+
+void ProgramReloader::add(std::unique_ptr<Program> &program, std::string vertex_path, std::string fragment_path, uint32_t features)
+{
+    entries.push_back({ program, vertex_path, fragment_path, features, nullptr });
+}
+
+void ProgramReloader::start()
+{
+    watcher.start();
+}
+
+void ProgramReloader::stop()
+{
+    watcher.stop();
+}
+
+bool ProgramReloader::update()
+{
+    for (const std::string &path : watcher.take_changes()) {
+        if (is_shader_source(path)) {
+            pending = true;
+        }
+    }
+
+    // Changes during a build are picked up by the next one
+    if (pending && !building) {
+        PROFILE_SCOPE("ProgramReloader::submit");
+
+        for (Entry &entry : entries) {
+            entry.candidate.reset(new Program());
+            cache.add(*entry.candidate, entry.vertex_path, entry.fragment_path, entry.features);
+        }
+        cache.submit();
+        pending = false;
+        building = true;
+    }
+
+    if (!building || !cache.poll()) {
+        return false;
+    }
+    building = false;
+
+    if (cache.finish() != LOAD_PROGRAM_SUCCESS) {
+        std::cerr << "Shader reload failed, keeping the previous programs" << std::endl;
+        for (Entry &entry : entries) {
+            entry.candidate.reset();
+        }
+        return false;
+    }
+
+    for (Entry &entry : entries) {
+        entry.program = std::move(entry.candidate);
+    }
+
+    return true;
+}
@@ -0,0 +1,46 @@
+#include "RenderState.hpp"
+
+static void set_enabled(GLenum capability, bool enabled)
+{
+    if (enabled) {
+        glEnable(capability);
+    }
+    else {
+        glDisable(capability);
+    }
+}
+
+void RenderStateCache::apply(const RenderState &state)
+{
+    if (!valid || state.depth_test != current.depth_test) {
+        set_enabled(GL_DEPTH_TEST, state.depth_test);
+    }
+    if (!valid || state.depth_write != current.depth_write) {
+        glDepthMask(state.depth_write ? GL_TRUE : GL_FALSE);
+    }
+    if (!valid || state.depth_func != current.depth_func) {
+        glDepthFunc(state.depth_func);
+    }
+    if (!valid || state.cull != current.cull) {
+        set_enabled(GL_CULL_FACE, state.cull);
+    }
+    if (!valid || state.cull_face != current.cull_face) {
+        glCullFace(state.cull_face);
+    }
+    if (!valid || state.front_face != current.front_face) {
+        glFrontFace(state.front_face);
+    }
+    if (!valid || state.blend != current.blend) {
+        set_enabled(GL_BLEND, state.blend);
+        // Only one blend function is ever used
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    current = state;
+    valid = true;
+}
+
+void RenderStateCache::invalidate()
+{
+    valid = false;
+}
@@ -7,10 +7,8 @@ Shader::~Shader()
     glDeleteShader(shader);
 }
 
-int Shader::load_shader(std::string file_path)
+int Shader::read_source(std::string file_path, std::string &src)
 {
-    shader = glCreateShader(type);
-
     std::ifstream file(file_path);
     if (!file) {
         std::cerr << "Could not open " << file_path << "!" << std::endl;
@@ -18,15 +16,47 @@ int Shader::load_shader(std::string file_path)
     }
 
     // Use read buffer to read entire file into stringstream
-    std::stringstream src;
-    src << file.rdbuf();
+    std::stringstream contents;
+    contents << file.rdbuf();
     file.close();
 
-    std::string shader_src = src.str();
-    const char *shader_src_ptr = shader_src.c_str();
+    src = contents.str();
+    return LOAD_SHADER_SUCCESS;
+}
+
+int Shader::load_shader(std::string file_path)
+{
+    std::string src;
+    if (read_source(file_path, src) != LOAD_SHADER_SUCCESS) {
+        return LOAD_SHADER_FAILURE;
+    }
+
+    return compile_source(src, file_path);
+}
+
+int Shader::compile_source(const std::string &src, std::string name)
+{
+    submit_source(src);
+    return check_status(name);
+}
+
+void Shader::submit_source(const std::string &src)
+{
+    PROFILE_SCOPE("Shader::submit_source");
+
+    if (shader == 0) {
+        shader = glCreateShader(type);
+    }
+
+    const char *shader_src_ptr = src.c_str();
     glShaderSource(shader, 1, &shader_src_ptr, nullptr);
 
     glCompileShader(shader);
+}
+
+int Shader::check_status(std::string name) const
+{
+    PROFILE_SCOPE("Shader::check_status");
 
     GLint success = 0;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
@@ -38,7 +68,7 @@ int Shader::load_shader(std::string file_path)
         std::unique_ptr<char> log(log_ptr);
         glGetShaderInfoLog(shader, len, nullptr, log.get());
         
-        std::cerr << "Compilation of " << file_path << " failed!\n" << log.get() << std::endl;
+        std::cerr << "Compilation of " << name << " failed!\n" << log.get() << std::endl;
 
         return LOAD_SHADER_FAILURE;
     }
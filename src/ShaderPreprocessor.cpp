@@ -0,0 +1,126 @@
+#include "ShaderPreprocessor.hpp"
+
+std::string ShaderPreprocessor::feature_defines(uint32_t features)
+{
+    static const struct {
+        shader_feature feature;
+        const char *name;
+    } names[] = {
+        { FEATURE_WIREFRAME, "WIREFRAME" },
+        { FEATURE_NIGHT_LIGHTS, "NIGHT_LIGHTS" },
+        { FEATURE_ATMOSPHERE, "ATMOSPHERE" },
+        { FEATURE_TEXTURE_ARRAY, "TEXTURE_ARRAY" },
+        { FEATURE_REVERSED_Z, "REVERSED_Z" },
+        { FEATURE_LOG_DEPTH, "LOG_DEPTH" },
+        { FEATURE_MULTI_DRAW, "MULTI_DRAW" },
+        { FEATURE_HEATMAP, "HEATMAP" },
+    };
+
+    std::string defines;
+    for (const auto &name : names) {
+        if (features & name.feature) {
+            defines += std::string("#define ") + name.name + " 1\n";
+        }
+    }
+
+    return defines;
+}
+
+int ShaderPreprocessor::preprocess(std::string path, uint32_t features, std::string &out)
+{
+    files.clear();
+
+    std::stringstream result;
+    if (process_file(path, features, result) != PREPROCESS_SHADER_SUCCESS) {
+        return PREPROCESS_SHADER_FAILURE;
+    }
+
+    out = result.str();
+    return PREPROCESS_SHADER_SUCCESS;
+}
+
+int ShaderPreprocessor::process_file(std::string path, uint32_t features, std::stringstream &out)
+{
+    for (const std::string &file : files) {
+        if (file == path) {
+            return PREPROCESS_SHADER_SUCCESS;
+        }
+    }
+    size_t index = files.size();
+    files.push_back(path);
+
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Could not open " << path << "!" << std::endl;
+        return PREPROCESS_SHADER_FAILURE;
+    }
+
+    std::string directory;
+    size_t slash = path.find_last_of("/\\");
+    if (slash != std::string::npos) {
+        directory = path.substr(0, slash + 1);
+    }
+
+    // Included files are not allowed to have a #version
+    if (index > 0) {
+        out << "#line 1 " << index << "\n";
+    }
+
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] != '#') {
+            out << line << "\n";
+            continue;
+        }
+
+        // Whitespace is allowed between # and the directive
+        size_t directive = line.find_first_not_of(" \t", start + 1);
+        if (directive != std::string::npos && line.compare(directive, 7, "version") == 0 && index == 0) {
+            out << line << "\n";
+            out << feature_defines(features);
+            out << "#line " << line_number + 1 << " 0\n";
+        }
+        else if (directive != std::string::npos && line.compare(directive, 7, "include") == 0) {
+            size_t open = line.find('"', directive + 7);
+            size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+            if (close == std::string::npos) {
+                std::cerr << path << ":" << line_number << ": Malformed #include" << std::endl;
+                return PREPROCESS_SHADER_FAILURE;
+            }
+
+            std::string include_path = directory + line.substr(open + 1, close - open - 1);
+            if (process_file(include_path, features, out) != PREPROCESS_SHADER_SUCCESS) {
+                std::cerr << "Included from " << path << ":" << line_number << std::endl;
+                return PREPROCESS_SHADER_FAILURE;
+            }
+            out << "#line " << line_number + 1 << " " << index << "\n";
+        }
+        else {
+            out << line << "\n";
+        }
+    }
+
+    return PREPROCESS_SHADER_SUCCESS;
+}
+
+std::string ShaderPreprocessor::describe() const
+{
+    if (files.empty()) {
+        return "";
+    }
+
+    std::string description = files[0];
+    if (files.size() > 1) {
+        description += " (";
+        for (size_t i = 1; i < files.size(); i++) {
+            description += (i > 1 ? ", " : "") + std::to_string(i) + ": " + files[i];
+        }
+        description += ")";
+    }
+
+    return description;
+}
@@ -0,0 +1,271 @@
+#include "Simulation.hpp"
+
+using std::chrono::steady_clock;
+
+// Gram-Schmidt on the columns of a rotation that drifted by rounding
+static glm::dmat3 orthonormalize(const glm::dmat3 &m)
+{
+    glm::dvec3 x = glm::normalize(m[0]);
+    glm::dvec3 y = glm::normalize(m[1] - x * glm::dot(x, m[1]));
+    return glm::dmat3(x, y, glm::cross(x, y));
+}
+
+Simulation::Simulation(Input &input, TripleBuffer<FrameState> &frames, std::vector<PatchBounds> earth_patches, const Picker &picker, depth_mode depth, void (*notify)())
+    : input(input), frames(frames), notify(notify), camera(EARTH_RADIUS, CAMERA_MIN_ALTITUDE, SPACE_RADIUS),
+      earth_patches(std::move(earth_patches)), picker(picker)
+{
+    camera.set_depth_mode(depth);
+
+    occluder_radius = EARTH_RADIUS;
+    for (const PatchBounds &bounds : this->earth_patches) {
+        occluder_radius = std::min(occluder_radius, bounds.min_radius);
+    }
+
+    // Because of the texture, rotate the earth around one time
+    earth_orientation = glm::dmat3(glm::rotate(
+        glm::dmat4(1.0),
+        PI,
+        glm::dvec3(0.0, 0.0, 1.0)
+    ));
+    model_space_transform = glm::rotate(
+        glm::mat4(1.0f),
+        glm::radians(180.0f),
+        glm::vec3(0.0f, 0.0f, 1.0f)
+    );
+}
+
+Simulation::~Simulation()
+{
+    stop();
+}
+
+void Simulation::start()
+{
+    start_time = steady_clock::now();
+    update();
+    publish();
+
+    running = true;
+    thread = std::thread(&Simulation::run, this);
+}
+
+void Simulation::stop()
+{
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void Simulation::run()
+{
+    Profiler::set_thread_name("update");
+
+    auto next_tick = steady_clock::now();
+    while (running) {
+        if (update()) {
+            publish();
+        }
+
+        next_tick += std::chrono::milliseconds(SIMULATION_TICK_MS);
+        std::this_thread::sleep_until(next_tick);
+    }
+}
+
+bool Simulation::update()
+{
+    PROFILE_SCOPE("Simulation::update");
+
+    bool changed = false;
+
+    int width = input.get_framebuffer_width();
+    int height = input.get_framebuffer_height();
+    if (width > 0 && height > 0 && (width != viewport_width || height != viewport_height)) {
+        viewport_width = width;
+        viewport_height = height;
+        camera.set_viewport(width, height);
+        changed = true;
+    }
+
+    double dx = input.take_dx();
+    double dy = input.take_dy();
+    if (input.is_mouse_pressed() && (dx != 0 || dy != 0)) {
+        float dir = 0.0f;
+        if (std::abs(dx) > std::abs(dy)) {
+            dir = dx;
+        }
+        else {
+            dir = dy;
+        }
+
+        glm::vec3 rot(0.0f);
+        switch (input.get_rotation_mode()) {
+            case X:
+                rot.x = dir;
+                break;
+            case Y:
+                rot.y = dir;
+                break;
+            case Z:
+                rot.z = dir;
+        }
+        // Slower close to the ground, so the surface moves at a similar
+        // speed on screen at any altitude
+        float speed = ROTATION_SPEED * (float) std::min(camera.get_altitude() / EARTH_RADIUS, 1.0);
+        glm::dmat4 drag = glm::rotate(glm::dmat4(1.0), glm::radians((double) speed), glm::normalize(glm::dvec3(rot)));
+        earth_orientation = orthonormalize(earth_orientation * glm::dmat3(drag));
+        changed = true;
+    }
+
+    // The altitude is measured from the ground under the camera, terrain
+    // included, which changes as the globe turns below it
+    glm::dvec3 camera_in_model = glm::transpose(earth_orientation) * camera.get_position();
+    if (camera.set_surface_radius(picker.ground_radius(camera_in_model))) {
+        changed = true;
+    }
+
+    float scroll = input.take_scroll() / SCROLL_SPEED;
+    if (camera.zoom(scroll)) {
+        changed = true;
+    }
+
+    // Again when the globe moved under the cursor
+    double x = input.get_cursor_x();
+    double y = input.get_cursor_y();
+    if (changed || x != cursor_x || y != cursor_y) {
+        cursor_x = x;
+        cursor_y = y;
+        if (pick_cursor()) {
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+bool Simulation::pick_cursor()
+{
+    bool was_on_globe = cursor_on_globe;
+    Geodetic previous = cursor_position;
+
+    cursor_on_globe = false;
+    if (cursor_x >= 0.0 && cursor_y >= 0.0 && cursor_x < viewport_width && cursor_y < viewport_height) {
+        // Pixel centers, y up in normalized device coordinates
+        double x = 2.0 * (cursor_x + 0.5) / viewport_width - 1.0;
+        double y = 1.0 - 2.0 * (cursor_y + 0.5) / viewport_height;
+        // The orientation is orthonormal, its inverse is the transpose
+        glm::dmat3 to_model = glm::transpose(earth_orientation);
+        PickHit hit;
+        if (picker.intersect(to_model * camera.get_position(), glm::normalize(to_model * camera.get_ray_direction(x, y)), hit)) {
+            cursor_on_globe = true;
+            cursor_position = hit.geodetic;
+        }
+    }
+
+    return cursor_on_globe != was_on_globe || (cursor_on_globe
+        && (cursor_position.lat != previous.lat || cursor_position.lon != previous.lon || cursor_position.height != previous.height));
+}
+
+void Simulation::publish()
+{
+    PROFILE_SCOPE("Simulation::publish");
+
+    FrameState &state = frames.write_buffer();
+
+    state.frame = frame++;
+    state.viewport_width = viewport_width;
+    state.viewport_height = viewport_height;
+    state.view = camera.get_view_rotation();
+    state.proj = camera.get_proj();
+    state.view_proj = state.proj * state.view;
+    state.log_depth_coefficient = camera.get_log_depth_coefficient();
+    state.camera_position = camera.get_position();
+    state.time = std::chrono::duration<float>(steady_clock::now() - start_time).count();
+    state.cursor_on_globe = cursor_on_globe;
+    state.cursor_position = cursor_position;
+
+    // Patches below the horizon are culled. A point at distance r from the
+    // center is visible from at most the sum of the tangent lengths of the
+    // camera and of r to the occluder, and no point of a patch is farther
+    // out than the equatorial radius plus its highest terrain. Patch depths
+    // are the distance to their bounding sphere, which also selects the
+    // level of detail. The sky has no depth, its model only orients the
+    // cube map. Centers are rotated in double, only the offsets from them
+    // by the float model.
+    glm::mat4 model_earth_transform = glm::mat4(glm::dmat4(earth_orientation));
+    double camera_horizon = horizon_distance(glm::length(state.camera_position));
+    double pixel_scale = 0.5 * std::max(viewport_height, 1) * state.proj[1][1];
+    state.visible.clear();
+    for (uint32_t patch = 0; patch < earth_patches.size(); patch++) {
+        glm::dvec3 center = earth_orientation * earth_patches[patch].center;
+        double depth = std::max(glm::length(center - state.camera_position) - earth_patches[patch].radius, 0.0);
+        double top = EARTH_RADIUS + std::max(earth_patches[patch].max_height, 0.0);
+        if (depth > camera_horizon + horizon_distance(top)) {
+            continue;
+        }
+        uint32_t lod = 0;
+        float morph = 0.0f;
+        select_lod(earth_patches[patch], depth, pixel_scale, lod, morph);
+        state.visible.push_back({
+            EARTH, PASS_OPAQUE, make_sort_key(PASS_OPAQUE, (float) depth, EARTH),
+            patch, lod, morph, model_earth_transform, center
+        });
+    }
+    // Marker and line positions are relative to the earth's center and
+    // rotate with it. Lines are blended, so they go after the markers.
+    state.visible.push_back({
+        MARKERS, PASS_OVERLAY, make_sort_key(PASS_OVERLAY, 0.0f, MARKERS),
+        0, 0, 0.0f, model_earth_transform, glm::dvec3(0.0)
+    });
+    state.visible.push_back({
+        LINES, PASS_OVERLAY, make_sort_key(PASS_OVERLAY, 0.0f, LINES),
+        0, 0, 0.0f, model_earth_transform, glm::dvec3(0.0)
+    });
+    state.earth_camera_position = glm::transpose(earth_orientation) * state.camera_position;
+    state.pixel_scale = pixel_scale;
+    state.visible.push_back({
+        SPACE, PASS_SKY, make_sort_key(PASS_SKY, 0.0f, SPACE),
+        0, 0, 0.0f, model_space_transform, glm::dvec3(0.0)
+    });
+    // Labels are laid out in the earth's model space by the render thread
+    state.visible.push_back({
+        LABELS, PASS_SCREEN, make_sort_key(PASS_SCREEN, 0.0f, LABELS),
+        0, 0, 0.0f, model_earth_transform, glm::dvec3(0.0)
+    });
+    std::sort(state.visible.begin(), state.visible.end(), [](const DrawItem &a, const DrawItem &b) {
+        return a.sort_key < b.sort_key;
+    });
+
+    frames.publish();
+
+    if (notify != nullptr) {
+        notify();
+    }
+}
+
+double Simulation::horizon_distance(double radius) const
+{
+    return std::sqrt(std::max(radius * radius - occluder_radius * occluder_radius, 0.0));
+}
+
+void Simulation::select_lod(const PatchBounds &bounds, double distance, double pixel_scale, uint32_t &lod, float &morph) const
+{
+    // Level L is good enough from lod_errors[L] / tolerance on
+    double tolerance = GLOBE_LOD_PIXEL_ERROR / pixel_scale;
+    const std::vector<double> &errors = bounds.lod_errors;
+
+    lod = 0;
+    while (lod + 1 < errors.size() && errors[lod + 1] <= distance * tolerance) {
+        lod++;
+    }
+
+    // Fully morphed where the next level takes over, so the switch is
+    // invisible
+    morph = 0.0f;
+    if (lod + 1 < errors.size()) {
+        double begin = errors[lod] / tolerance;
+        double end = errors[lod + 1] / tolerance;
+        double morph_begin = begin + (end - begin) * GLOBE_LOD_MORPH_START;
+        morph = (float) std::clamp((distance - morph_begin) / (end - morph_begin), 0.0, 1.0);
+    }
+}
@@ -0,0 +1,34 @@
+#include "Skybox.hpp"
+
+Skybox::Skybox()
+{
+    glGenVertexArrays(1, &vao);
+}
+
+Skybox::~Skybox()
+{
+    glDeleteVertexArrays(1, &vao);
+}
+
+int Skybox::load(std::string path, int face_size)
+{
+    PROFILE_SCOPE("Skybox::load");
+
+    return texture.load_cube_map(path, face_size);
+}
+
+RenderState Skybox::get_render_state(depth_mode mode)
+{
+    RenderState state;
+    state.depth_write = false;
+    state.depth_func = depth_func_nearer(mode, true);
+    return state;
+}
+
+void Skybox::draw() const
+{
+    texture.use();
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+}
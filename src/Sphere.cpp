@@ -7,17 +7,12 @@ Sphere::Sphere(glm::vec3 center, float radius, uint64_t stack_count, uint64_t se
     std::cout << this->radius << std::endl;
 #endif
     generate();
-    generate_gl();
-}
-
-Sphere::~Sphere()
-{
-    glDeleteBuffers(1, &ebo);
-    glDeleteBuffers(2, vbo);
 }
 
 void Sphere::generate()
 {
+    PROFILE_SCOPE("Sphere::generate");
+
     if (stack_count < SPHERE_MINIMUM_STACK_COUNT || sector_count < SPHERE_MINIMUM_SECTOR_COUNT) {
         initialized = false;
         return;
@@ -34,8 +29,10 @@ void Sphere::generate()
     vertices.reserve(vertex_count * 3);
     indices.reserve(index_count);
     texcoords.reserve(vertex_count * 2);
+#if DEBUG
     std::cout << "vertex_count: " << vertex_count << std::endl;
     std::cout << "index_count:  " << index_count << std::endl;
+#endif
     
     // Push top vertices with same position but different texcoords
     // Correcting the texcoord glitches from the previous build
@@ -68,9 +65,9 @@ void Sphere::generate()
         */
         float phi = PI / 2.0f - PI * ((float) stack_step / (float) stack_count);
         // To connect the last vertex with the initial one
-        GLuint initial_bottom_index = vertices.size() / 3;
-        GLuint prev_bottom_index = initial_bottom_index + (GLuint) sector_count - 2;
-        GLuint next_top_index = initial_bottom_index - (GLuint) sector_count;
+        uint32_t initial_bottom_index = vertices.size() / 3;
+        uint32_t prev_bottom_index = initial_bottom_index + (uint32_t) sector_count - 2;
+        uint32_t next_top_index = initial_bottom_index - (uint32_t) sector_count;
 
         for (uint64_t sector_step = 0; sector_step <= sector_count; sector_step++) {
             float theta = 2.0f * PI * ((float) sector_step / (float) sector_count);
@@ -89,23 +86,23 @@ void Sphere::generate()
             // This is the last iteration for the sectors, so ignore the triangle next to the vertex
             // since it has already been added in the initial, first iteration. Fixes the final Sphere
             // glitch.
-            GLuint bottom_index = vertices.size() / 3 - 1;
-            GLuint top_index = bottom_index - (GLuint) sector_count - 1;
+            uint32_t bottom_index = vertices.size() / 3 - 1;
+            uint32_t top_index = bottom_index - (uint32_t) sector_count - 1;
             if (bottom_index == initial_bottom_index) {
                 indices.insert(indices.end(), {
                     bottom_index,
-                    top_index,
                     next_top_index,
+                    top_index,
                 });
                 next_top_index++;
             }
             else if (next_top_index == initial_bottom_index) {
                 indices.insert(indices.end(), {
                     prev_bottom_index,
-                    top_index,
                     bottom_index,
+                    top_index,
                 });
-                next_top_index = initial_bottom_index - (GLuint) sector_count;
+                next_top_index = initial_bottom_index - (uint32_t) sector_count;
             }
             else {
                 // Per vertex add two triangles
@@ -114,11 +111,11 @@ void Sphere::generate()
                 // of the vertex
                 indices.insert(indices.end(), {
                     prev_bottom_index,
-                    top_index,
-                    bottom_index,
                     bottom_index,
                     top_index,
+                    bottom_index,
                     next_top_index,
+                    top_index,
                 });
                 next_top_index++;
             }
@@ -134,41 +131,6 @@ void Sphere::generate()
     initialized = true;
 }
 
-void Sphere::generate_gl() {
-    if (!initialized) {
-        return;
-    }
-    
-    // Data pointers
-    const float *vertices_ptr = vertices.data();
-    GLsizeiptr vertices_size = vertices.size() * sizeof(float);
-
-    const GLuint *indices_ptr = indices.data();
-    GLsizeiptr indices_size = indices.size() * sizeof(GLuint);
-    
-    const float *texcoords_ptr = texcoords.data();
-    GLsizeiptr texcoords_size = texcoords.size() * sizeof(float);
-
-    glGenBuffers(2, vbo);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo[0]);
-    glBufferData(GL_ARRAY_BUFFER, vertices_size, vertices_ptr, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo[1]);
-    glBufferData(GL_ARRAY_BUFFER, texcoords_size, texcoords_ptr, GL_STATIC_DRAW);
-
-    glGenBuffers(1, &ebo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_size, indices_ptr, GL_STATIC_DRAW);
-}
-
-void Sphere::draw() const
-{
-    GLsizeiptr indices_size = indices.size() * sizeof(GLuint);
-    
-    glDrawElements(GL_TRIANGLES, indices_size, GL_UNSIGNED_INT, nullptr);
-}
-
 void Sphere::log_coords() const
 {
     std::cout << "vertices" << std::endl;
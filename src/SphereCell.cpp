@@ -0,0 +1,225 @@
+#include "SphereCell.hpp"
+
+#include <algorithm>
+
+#include "Constants.hpp"
+
+static const uint32_t CELL_LEAF_SIZE = 1u << CELL_MAX_LEVEL;
+
+// Which face a direction falls on and its (u, v) in [-1, 1] on it, with
+// the axes of S2
+static int face_uv_from_xyz(const glm::dvec3 &p, double &u, double &v)
+{
+    glm::dvec3 a = glm::abs(p);
+    int face = a.x >= a.y ? (a.x >= a.z ? 0 : 2) : (a.y >= a.z ? 1 : 2);
+    if (p[face] < 0.0) {
+        face += 3;
+    }
+    switch (face) {
+        case 0: u = p.y / p.x; v = p.z / p.x; break;
+        case 1: u = -p.x / p.y; v = p.z / p.y; break;
+        case 2: u = -p.x / p.z; v = -p.y / p.z; break;
+        case 3: u = p.z / p.x; v = p.y / p.x; break;
+        case 4: u = p.z / p.y; v = -p.x / p.y; break;
+        default: u = -p.y / p.z; v = -p.x / p.z; break;
+    }
+    return face;
+}
+
+static glm::dvec3 face_uv_to_xyz(int face, double u, double v)
+{
+    switch (face) {
+        case 0: return glm::dvec3(1.0, u, v);
+        case 1: return glm::dvec3(-u, 1.0, v);
+        case 2: return glm::dvec3(-u, -v, 1.0);
+        case 3: return glm::dvec3(-1.0, -v, -u);
+        case 4: return glm::dvec3(v, -1.0, -u);
+        default: return glm::dvec3(v, u, -1.0);
+    }
+}
+
+// The quadratic projection of S2, evens out the cell areas
+static double st_from_uv(double u)
+{
+    return u >= 0.0 ? 0.5 * std::sqrt(1.0 + 3.0 * u) : 1.0 - 0.5 * std::sqrt(1.0 - 3.0 * u);
+}
+
+double cell_uv_from_st(double s)
+{
+    return s >= 0.5 ? (4.0 * s * s - 1.0) / 3.0 : (1.0 - 4.0 * (1.0 - s) * (1.0 - s)) / 3.0;
+}
+
+static uint32_t ij_from_st(double s)
+{
+    double scaled = std::floor(s * CELL_LEAF_SIZE);
+    return (uint32_t) std::clamp(scaled, 0.0, (double) (CELL_LEAF_SIZE - 1));
+}
+
+// Orientation of the curve inside a quadrant: whether x and y are
+// swapped and whether both are inverted. The two commute and each undoes
+// itself, so an orientation is two bits and applying it twice is identity.
+static const uint32_t HILBERT_SWAP = 1;
+static const uint32_t HILBERT_INVERT = 2;
+
+static void hilbert_orient(uint32_t &x, uint32_t &y, uint32_t orientation)
+{
+    if (orientation & HILBERT_INVERT) {
+        x ^= 1;
+        y ^= 1;
+    }
+    if (orientation & HILBERT_SWAP) {
+        std::swap(x, y);
+    }
+}
+
+// One level: the quadrant (x, y) under orientation becomes a position
+// digit and the orientation of the quadrant's own curve
+static uint32_t hilbert_step(uint32_t x, uint32_t y, uint32_t &orientation)
+{
+    hilbert_orient(x, y, orientation);
+    if (y == 0) {
+        orientation ^= x == 1 ? HILBERT_SWAP | HILBERT_INVERT : HILBERT_SWAP;
+    }
+    return (3 * x) ^ y;
+}
+
+// Four levels at a time, for every orientation: 4 bits of x and y to 8
+// bits of position and back, with the orientation after them in the low
+// two bits
+struct HilbertTables
+{
+    uint16_t position[4 << 8];
+    uint16_t xy[4 << 8];
+
+    HilbertTables() {
+        for (uint32_t start = 0; start < 4; start++) {
+            for (uint32_t bits = 0; bits < 256; bits++) {
+                uint32_t orientation = start;
+                uint32_t d = 0;
+                for (int level = 3; level >= 0; level--) {
+                    d = d << 2 | hilbert_step((bits >> (4 + level)) & 1, (bits >> level) & 1, orientation);
+                }
+                position[start << 8 | bits] = (uint16_t) (d << 2 | orientation);
+
+                orientation = start;
+                uint32_t x = 0, y = 0;
+                for (int level = 3; level >= 0; level--) {
+                    uint32_t digit = (bits >> (2 * level)) & 3;
+                    uint32_t rx = digit >> 1;
+                    uint32_t ry = (digit ^ rx) & 1;
+                    // Orientations undo themselves
+                    hilbert_orient(rx, ry, orientation);
+                    hilbert_step(rx, ry, orientation);
+                    x = x << 1 | rx;
+                    y = y << 1 | ry;
+                }
+                xy[start << 8 | bits] = (uint16_t) ((x << 4 | y) << 2 | orientation);
+            }
+        }
+    }
+};
+
+static const HilbertTables HILBERT_TABLES;
+
+// Position on the curve through a 2^level grid. The grid is walked as
+// 2^32 with the leading empty levels, which only swap, cancelled by the
+// starting orientation; the position of a parent is a prefix.
+static uint64_t hilbert_from_xy(int level, uint32_t x, uint32_t y)
+{
+    uint32_t orientation = (32 - level) & 1 ? HILBERT_SWAP : 0;
+    uint64_t d = 0;
+    for (int shift = 28; shift >= 0; shift -= 4) {
+        uint32_t bits = ((x >> shift) & 15) << 4 | ((y >> shift) & 15);
+        uint32_t entry = HILBERT_TABLES.position[orientation << 8 | bits];
+        d = d << 8 | (entry >> 2);
+        orientation = entry & 3;
+    }
+    return d;
+}
+
+static void hilbert_to_xy(int level, uint64_t d, uint32_t &x, uint32_t &y)
+{
+    uint32_t orientation = (32 - level) & 1 ? HILBERT_SWAP : 0;
+    x = 0;
+    y = 0;
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        uint32_t entry = HILBERT_TABLES.xy[orientation << 8 | ((d >> shift) & 255)];
+        x = x << 4 | (entry >> 6);
+        y = y << 4 | ((entry >> 2) & 15);
+        orientation = entry & 3;
+    }
+}
+
+SphereCap SphereCap::horizon(const glm::dvec3 &position, double radius, double max_height)
+{
+    // From the center, the camera sees up to its tangent point, and a point
+    // at max_height is visible up to its own tangent point beyond that
+    double distance = std::max(glm::length(position), radius);
+    double angle = std::acos(radius / distance) + std::acos(radius / (radius + std::max(max_height, 0.0)));
+    return { position / glm::length(position), std::min(angle, PI) };
+}
+
+uint64_t cell_from_face_ij(int face, uint32_t i, uint32_t j, int level)
+{
+    int shift = CELL_MAX_LEVEL - level;
+    uint64_t position = hilbert_from_xy(level, i >> shift, j >> shift);
+    return ((uint64_t) face << 61) | (position << (2 * shift + 1)) | ((uint64_t) 1 << (2 * shift));
+}
+
+uint64_t cell_from_point(const glm::dvec3 &direction)
+{
+    double u = 0.0, v = 0.0;
+    int face = face_uv_from_xyz(direction, u, v);
+    return cell_from_face_ij(face, ij_from_st(st_from_uv(u)), ij_from_st(st_from_uv(v)), CELL_MAX_LEVEL);
+}
+
+void cell_to_face_ij(uint64_t id, int &face, uint32_t &i, uint32_t &j)
+{
+    int level = cell_level(id);
+    int shift = CELL_MAX_LEVEL - level;
+    face = cell_face(id);
+    uint64_t position = (id & ~((uint64_t) 7 << 61)) >> (2 * shift + 1);
+    hilbert_to_xy(level, position, i, j);
+    i <<= shift;
+    j <<= shift;
+}
+
+glm::dvec3 cell_center(uint64_t id)
+{
+    int face = 0;
+    uint32_t i = 0, j = 0;
+    cell_to_face_ij(id, face, i, j);
+    double size = (double) (1u << (CELL_MAX_LEVEL - cell_level(id)));
+    double u = cell_uv_from_st((i + 0.5 * size) / CELL_LEAF_SIZE);
+    double v = cell_uv_from_st((j + 0.5 * size) / CELL_LEAF_SIZE);
+    return glm::normalize(face_uv_to_xyz(face, u, v));
+}
+
+SphereCap cell_bound(uint64_t id)
+{
+    int face = 0;
+    uint32_t i = 0, j = 0;
+    cell_to_face_ij(id, face, i, j);
+    double size = (double) (1u << (CELL_MAX_LEVEL - cell_level(id)));
+
+    glm::dvec3 center = cell_center(id);
+    // Cells are convex on the sphere, the farthest point is a corner
+    double angle = 0.0;
+    for (int corner = 0; corner < 4; corner++) {
+        double u = cell_uv_from_st((i + (corner & 1) * size) / CELL_LEAF_SIZE);
+        double v = cell_uv_from_st((j + (corner >> 1) * size) / CELL_LEAF_SIZE);
+        angle = std::max(angle, sphere_angle(center, face_uv_to_xyz(face, u, v)));
+    }
+    // Slightly larger, so rounding never makes a cell miss a point
+    return { center, angle * (1.0 + 1e-9) + 1e-15 };
+}
+
+int cell_level_for_angle(double angle)
+{
+    // Cells of level 0 are about PI / 2 across, each level halves that
+    int level = 0;
+    while (level < CELL_MAX_LEVEL && PI / 2.0 / (1u << level) > angle) {
+        level++;
+    }
+    return level;
+}
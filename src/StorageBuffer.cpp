@@ -0,0 +1,23 @@
+#include "StorageBuffer.hpp"
+
+StorageBuffer::StorageBuffer(GLuint binding)
+    : binding(binding)
+{
+    glGenBuffers(1, &buffer);
+}
+
+StorageBuffer::~StorageBuffer()
+{
+    glDeleteBuffers(1, &buffer);
+}
+
+void StorageBuffer::upload(const void *data, size_t size)
+{
+    PROFILE_SCOPE("StorageBuffer::upload");
+
+    // Same orphaning as UniformBuffer::upload. Empty buffers cannot be
+    // bound, so there is always at least one byte.
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, size > 0 ? size : 1, data, GL_STREAM_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+}
@@ -0,0 +1,257 @@
+#include "Terrain.hpp"
+
+int Terrain::tile_key(int lat, int lon)
+{
+    return (lat + 90) * 360 + (lon + 180);
+}
+
+bool Terrain::parse_tile_name(const std::string &name, int &lat, int &lon)
+{
+    if (name.size() != 7
+        || (name[0] != 'N' && name[0] != 'S' && name[0] != 'n' && name[0] != 's')
+        || (name[3] != 'E' && name[3] != 'W' && name[3] != 'e' && name[3] != 'w')) {
+        return false;
+    }
+    for (int i : { 1, 2, 4, 5, 6 }) {
+        if (name[i] < '0' || name[i] > '9') {
+            return false;
+        }
+    }
+
+    lat = (name[1] - '0') * 10 + (name[2] - '0');
+    lon = (name[4] - '0') * 100 + (name[5] - '0') * 10 + (name[6] - '0');
+    if (name[0] == 'S' || name[0] == 's') {
+        lat = -lat;
+    }
+    if (name[3] == 'W' || name[3] == 'w') {
+        lon = -lon;
+    }
+
+    return lat >= -90 && lat < 90 && lon >= -180 && lon < 180;
+}
+
+size_t Terrain::load_directory(std::string directory)
+{
+    PROFILE_SCOPE("Terrain::load_directory");
+
+    std::error_code error;
+    if (!std::filesystem::is_directory(directory, error)) {
+        return 0;
+    }
+
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.path().extension() != ".hgt") {
+            continue;
+        }
+
+        int lat = 0, lon = 0;
+        if (!parse_tile_name(entry.path().stem().string(), lat, lon)) {
+            std::cerr << "Skipping " << entry.path().string() << ", not named like N46E007.hgt" << std::endl;
+            continue;
+        }
+
+        std::unique_ptr<Tile> tile(new Tile());
+        if (tile->file.map(entry.path().string()) != MAP_FILE_SUCCESS) {
+            continue;
+        }
+
+        // Square grids of 16 bit samples, the size gives the resolution
+        size_t samples = tile->file.get_size() / 2;
+        int side = (int) std::lround(std::sqrt((double) samples));
+        if (side < 2 || (size_t) side * side != samples || tile->file.get_size() % 2 != 0) {
+            std::cerr << "Skipping " << entry.path().string() << ", not a square grid of 16 bit samples" << std::endl;
+            continue;
+        }
+        tile->side = side;
+
+        tiles[tile_key(lat, lon)] = std::move(tile);
+    }
+
+    return tiles.size();
+}
+
+double Terrain::get_sample(const Tile &tile, int row, int column)
+{
+    const uint8_t *bytes = tile.file.get_data() + ((size_t) row * tile.side + column) * 2;
+    int16_t value = (int16_t) (((uint16_t) bytes[0] << 8) | bytes[1]);
+    // Voids are mostly water and steep shadows, sea level is the least wrong
+    return value == VOID_SAMPLE ? 0.0 : (double) value;
+}
+
+void Terrain::build_tree(const Tile &tile)
+{
+    PROFILE_SCOPE("Terrain::build_tree");
+
+    // The leaves bound the bilinear surface, which stays between the
+    // samples at the corners of each interval
+    int intervals = tile.side - 1;
+    int side = (intervals + TERRAIN_TREE_LEAF - 1) / TERRAIN_TREE_LEAF;
+    std::vector<HeightRange> leaves((size_t) side * side);
+    for (int block_row = 0; block_row < side; block_row++) {
+        for (int block_column = 0; block_column < side; block_column++) {
+            int16_t low = INT16_MAX, high = INT16_MIN;
+            int last_row = std::min((block_row + 1) * TERRAIN_TREE_LEAF, intervals);
+            int last_column = std::min((block_column + 1) * TERRAIN_TREE_LEAF, intervals);
+            for (int row = block_row * TERRAIN_TREE_LEAF; row <= last_row; row++) {
+                for (int column = block_column * TERRAIN_TREE_LEAF; column <= last_column; column++) {
+                    int16_t value = (int16_t) get_sample(tile, row, column);
+                    low = std::min(low, value);
+                    high = std::max(high, value);
+                }
+            }
+            leaves[(size_t) block_row * side + block_column] = { low, high };
+        }
+    }
+    tile.tree.push_back(std::move(leaves));
+    tile.tree_sides.push_back(side);
+
+    while (side > 1) {
+        const std::vector<HeightRange> &below = tile.tree.back();
+        int below_side = side;
+        side = (side + 1) / 2;
+        std::vector<HeightRange> level((size_t) side * side, { INT16_MAX, INT16_MIN });
+        for (int row = 0; row < below_side; row++) {
+            for (int column = 0; column < below_side; column++) {
+                const HeightRange &child = below[(size_t) row * below_side + column];
+                HeightRange &parent = level[(size_t) (row / 2) * side + column / 2];
+                parent.min = std::min(parent.min, child.min);
+                parent.max = std::max(parent.max, child.max);
+            }
+        }
+        tile.tree.push_back(std::move(level));
+        tile.tree_sides.push_back(side);
+    }
+
+    // Widen every block by its neighbours, so a point can move a whole
+    // block in any direction without leaving what its range covers
+    for (size_t level = 0; level < tile.tree.size(); level++) {
+        int side = tile.tree_sides[level];
+        const std::vector<HeightRange> blocks = tile.tree[level];
+        for (int row = 0; row < side; row++) {
+            for (int column = 0; column < side; column++) {
+                HeightRange &range = tile.tree[level][(size_t) row * side + column];
+                for (int r = std::max(row - 1, 0); r <= std::min(row + 1, side - 1); r++) {
+                    for (int c = std::max(column - 1, 0); c <= std::min(column + 1, side - 1); c++) {
+                        range.min = std::min(range.min, blocks[(size_t) r * side + c].min);
+                        range.max = std::max(range.max, blocks[(size_t) r * side + c].max);
+                    }
+                }
+            }
+        }
+    }
+}
+
+const Terrain::Tile *Terrain::find_tile(double lat_degrees, double &lon_degrees, int &tile_lat, int &tile_lon) const
+{
+    lon_degrees -= 360.0 * std::floor((lon_degrees + 180.0) / 360.0);
+
+    tile_lat = (int) std::floor(lat_degrees);
+    tile_lon = (int) std::floor(lon_degrees);
+    // Exactly on 180 degrees east after rounding
+    if (tile_lon >= 180) {
+        tile_lon -= 360;
+        lon_degrees -= 360.0;
+    }
+    if (tile_lat < -90 || tile_lat >= 90) {
+        return nullptr;
+    }
+
+    auto it = tiles.find(tile_key(tile_lat, tile_lon));
+    return it == tiles.end() ? nullptr : it->second.get();
+}
+
+double Terrain::sample(double lat, double lon) const
+{
+    if (tiles.empty()) {
+        return 0.0;
+    }
+
+    double lat_degrees = lat * 180.0 / PI;
+    double lon_degrees = lon * 180.0 / PI;
+    int tile_lat = 0, tile_lon = 0;
+    const Tile *found = find_tile(lat_degrees, lon_degrees, tile_lat, tile_lon);
+    if (found == nullptr) {
+        return 0.0;
+    }
+    const Tile &tile = *found;
+
+    // Rows go from north to south, the last row and column are the edges
+    // of the next tiles
+    double y = (tile_lat + 1 - lat_degrees) * (tile.side - 1);
+    double x = (lon_degrees - tile_lon) * (tile.side - 1);
+    int row = std::min((int) y, tile.side - 2);
+    int column = std::min((int) x, tile.side - 2);
+    double fy = y - row;
+    double fx = x - column;
+
+    double north = get_sample(tile, row, column) * (1.0 - fx) + get_sample(tile, row, column + 1) * fx;
+    double south = get_sample(tile, row + 1, column) * (1.0 - fx) + get_sample(tile, row + 1, column + 1) * fx;
+    return north * (1.0 - fy) + south * fy;
+}
+
+double Terrain::clearance(double lat, double lon, double height, double slope) const
+{
+    // The shortest degree anywhere is one of longitude at the most poleward
+    // latitude of the tile, and meridian degrees are shortest at the
+    // equator, a (1 - e^2) * PI / 180
+    static const double METERS_PER_DEGREE = 6335439.0 * PI / 180.0;
+
+    double lat_degrees = lat * 180.0 / PI;
+    double lon_degrees = lon * 180.0 / PI;
+    int tile_lat = 0, tile_lon = 0;
+    const Tile *found = find_tile(lat_degrees, lon_degrees, tile_lat, tile_lon);
+    double lon_scale = std::cos(std::min(std::max(std::abs((double) tile_lat), std::abs(tile_lat + 1.0)), 90.0) * PI / 180.0);
+    // Height the ray loses per meter, it reaches a level above it after
+    // above / drop
+    double drop = std::max(-slope, 0.0);
+
+    // Outside of tiles the ground is at 0 up to the edge of the tile
+    if (found == nullptr) {
+        double lateral = std::min(
+            std::min(lat_degrees - tile_lat, tile_lat + 1 - lat_degrees),
+            std::min(lon_degrees - tile_lon, tile_lon + 1 - lon_degrees) * lon_scale) * METERS_PER_DEGREE;
+        if (height <= 0.0) {
+            return 0.0;
+        }
+        return std::max(drop * lateral < height ? lateral : height / drop, 0.0);
+    }
+    const Tile &tile = *found;
+    std::call_once(tile.tree_built, build_tree, std::cref(tile));
+
+    // In sample intervals from the north west corner
+    double intervals = tile.side - 1;
+    double y = (tile_lat + 1 - lat_degrees) * intervals;
+    double x = (lon_degrees - tile_lon) * intervals;
+    double meters_per_interval = METERS_PER_DEGREE / intervals;
+
+    // The neighbours of blocks at the edge of the tile are in other tiles,
+    // which the ranges do not cover
+    double edge = std::min(std::min(y, intervals - y), std::min(x, intervals - x) * lon_scale);
+
+    // From the root down. A widened block the ray stays above for a whole
+    // block is skipped at once. One it dips into allows a step down to its
+    // highest sample, and its children, lower but smaller, may allow more.
+    double result = 0.0;
+    double block = TERRAIN_TREE_LEAF * std::ldexp(1.0, (int) tile.tree.size() - 1);
+    for (size_t level = tile.tree.size(); level-- > 0; block *= 0.5) {
+        int side = tile.tree_sides[level];
+        int row = std::min((int) (y / block), side - 1);
+        int column = std::min((int) (x / block), side - 1);
+        double above = height - tile.tree[level][(size_t) row * side + column].max;
+        if (above <= 0.0) {
+            continue;
+        }
+        double lateral = block * lon_scale;
+        if (row == 0 || column == 0 || row == side - 1 || column == side - 1) {
+            lateral = std::min(lateral, edge);
+        }
+        lateral = std::max(lateral, 0.0) * meters_per_interval;
+        if (drop * lateral < above) {
+            return std::max(result, lateral);
+        }
+        result = std::max(result, above / drop);
+    }
+
+    // Among the samples of a leaf the ray goes half a sample at a time
+    return std::max(result, 0.5 * std::max(std::min(lon_scale, edge), 0.0) * meters_per_interval);
+}
@@ -1,9 +1,5 @@
 #include "Texture.hpp"
 
-// NOTE: NOT in header files!
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
 Texture::~Texture()
 {
     glDeleteTextures(1, &texture);
@@ -11,19 +7,33 @@ Texture::~Texture()
 
 int Texture::load_texture(std::string path)
 {
-    glGenTextures(1, &texture);
-    use();
+    PROFILE_SCOPE("Texture::load_texture");
 
-    int width = 0, height = 0;
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    stbi_uc *earth_image = stbi_load(path.c_str(), &width, &height, 0, STBI_rgb);
-    if (earth_image == NULL) {
-        std::cerr << "Could not load " << path << std::endl;
+    Image image;
+    if (image.load(path, 3) != LOAD_IMAGE_SUCCESS) {
         return LOAD_TEXTURE_FAILURE;
     }
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, earth_image);
-    stbi_image_free(earth_image);
+    upload(image);
+
+    return LOAD_TEXTURE_SUCCESS;
+}
+
+void Texture::upload(const Image &image)
+{
+    PROFILE_SCOPE("Texture::upload");
+
+    static const GLenum formats[] = { 0, GL_RED, GL_RG, GL_RGB, GL_RGBA };
+
+    if (texture == 0) {
+        glGenTextures(1, &texture);
+    }
+    target = GL_TEXTURE_2D;
+    use();
+
+    GLenum format = formats[image.get_channels()];
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, image.get_width(), image.get_height(), 0, format, GL_UNSIGNED_BYTE, image.get_pixels());
 
     // Wrapping
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -31,14 +41,59 @@ int Texture::load_texture(std::string path)
 
     // Filtering
     // Use a mipmap (load texture in advance)
-    glGenerateMipmap(GL_TEXTURE_2D);
+    {
+        PROFILE_SCOPE("glGenerateMipmap");
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+}
+
+int Texture::load_cube_map(std::string path, int face_size)
+{
+    PROFILE_SCOPE("Texture::load_cube_map");
+
+    Image image;
+    if (image.load(path, 3) != LOAD_IMAGE_SUCCESS) {
+        return LOAD_TEXTURE_FAILURE;
+    }
+
+    upload_cube(image.equirect_to_cube(face_size));
 
     return LOAD_TEXTURE_SUCCESS;
 }
 
+void Texture::upload_cube(const std::vector<Image> &faces)
+{
+    PROFILE_SCOPE("Texture::upload_cube");
+
+    static const GLenum formats[] = { 0, GL_RED, GL_RG, GL_RGB, GL_RGBA };
+
+    if (texture == 0) {
+        glGenTextures(1, &texture);
+    }
+    target = GL_TEXTURE_CUBE_MAP;
+    use();
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t face = 0; face < faces.size() && face < 6; face++) {
+        GLenum format = formats[faces[face].get_channels()];
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + (GLenum) face, 0, format, faces[face].get_width(), faces[face].get_height(), 0, format, GL_UNSIGNED_BYTE, faces[face].get_pixels());
+    }
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+    {
+        PROFILE_SCOPE("glGenerateMipmap");
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
 void Texture::use() const
 {
-    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindTexture(target, texture);
 }
@@ -0,0 +1,127 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(size_t thread_count)
+{
+    if (thread_count == 0) {
+        thread_count = std::thread::hardware_concurrency();
+    }
+    if (thread_count == 0) {
+        thread_count = 1;
+    }
+
+    for (size_t i = 0; i < thread_count; i++) {
+        workers.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool &ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::work(size_t index)
+{
+    Profiler::set_thread_name("worker " + std::to_string(index));
+
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() {
+                return stopping || !tasks.empty();
+            });
+            if (stopping && tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> task)
+{
+    auto packaged = std::make_shared<std::packaged_task<void()>>(std::move(task));
+    std::future<void> future = packaged->get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.emplace_back([packaged]() {
+            (*packaged)();
+        });
+    }
+    condition.notify_one();
+
+    return future;
+}
+
+void ThreadPool::parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)> &body)
+{
+    if (count == 0) {
+        return;
+    }
+    if (grain == 0) {
+        grain = 1;
+    }
+
+    size_t chunk_count = (count + grain - 1) / grain;
+    if (chunk_count == 1) {
+        body(0, count);
+        return;
+    }
+
+    // Shared with the helpers, which may only get to run after we returned
+    struct State
+    {
+        std::atomic<size_t> next_chunk{ 0 };
+        std::atomic<size_t> done_chunks{ 0 };
+        std::mutex mutex;
+        std::condition_variable condition;
+    };
+    auto state = std::make_shared<State>();
+
+    // Claims chunks until none are left. Helpers may only get to run after
+    // all chunks are done and the caller returned, they must not touch body then.
+    auto run = [state, count, grain, chunk_count, &body]() {
+        size_t chunk = 0;
+        while ((chunk = state->next_chunk.fetch_add(1)) < chunk_count) {
+            size_t begin = chunk * grain;
+            size_t end = begin + grain < count ? begin + grain : count;
+            body(begin, end);
+            if (state->done_chunks.fetch_add(1) + 1 == chunk_count) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->condition.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min(workers.size(), chunk_count - 1);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < helpers; i++) {
+            tasks.emplace_back(run);
+        }
+    }
+    condition.notify_all();
+
+    run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->condition.wait(lock, [&]() {
+        return state->done_chunks.load() == chunk_count;
+    });
+}
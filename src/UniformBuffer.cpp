@@ -0,0 +1,47 @@
+#include "UniformBuffer.hpp"
+
+#include <cstring>
+
+UniformBuffer::UniformBuffer(GLuint binding, size_t block_size)
+    : binding(binding), block_size(block_size)
+{
+    GLint alignment = 1;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    stride = (block_size + alignment - 1) / alignment * alignment;
+
+    glGenBuffers(1, &buffer);
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    glDeleteBuffers(1, &buffer);
+}
+
+void UniformBuffer::set(size_t index, const void *data)
+{
+    if (staging.size() < (index + 1) * stride) {
+        staging.resize((index + 1) * stride);
+    }
+    std::memcpy(staging.data() + index * stride, data, block_size);
+}
+
+void UniformBuffer::upload(size_t count)
+{
+    PROFILE_SCOPE("UniformBuffer::upload");
+
+    // Blocks past the last one set are uploaded too, e.g. of draws that
+    // read their data from elsewhere
+    if (staging.size() < count * stride) {
+        staging.resize(count * stride);
+    }
+
+    // Reallocating lets the driver hand out fresh memory instead of waiting
+    // for draws of the previous frame that still read the old contents
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, count * stride, staging.data(), GL_STREAM_DRAW);
+}
+
+void UniformBuffer::bind(size_t index) const
+{
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, index * stride, block_size);
+}
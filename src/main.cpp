@@ -1,11 +1,13 @@
-#include <chrono>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <string>
-#include <thread>
+#include <vector>
 
 #include <glad/glad.h>
 // NOTE: Contains static initializers that, when GLFW is
@@ -14,53 +16,86 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
 
 #include "Constants.hpp"
+#include "FrameState.hpp"
+#include "Globe.hpp"
+#include "GpuProfiler.hpp"
+#include "HeatmapLayer.hpp"
+#include "HeatmapTexture.hpp"
+#include "Input.hpp"
+#include "LabelBuffer.hpp"
+#include "LabelLayer.hpp"
+#include "LineBuffer.hpp"
+#include "LineLayer.hpp"
+#include "MarkerBuffer.hpp"
+#include "MarkerLayer.hpp"
+#include "PatchPool.hpp"
+#include "Picker.hpp"
+#include "Profiler.hpp"
+#include "Program.hpp"
+#include "ProgramCache.hpp"
+#include "ProgramReloader.hpp"
+#include "RenderState.hpp"
+#include "RenderTarget.hpp"
 #include "Shader.hpp"
-#include "Sphere.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "Simulation.hpp"
+#include "Skybox.hpp"
+#include "StorageBuffer.hpp"
+#include "Terrain.hpp"
 #include "Texture.hpp"
-
-using std::chrono::high_resolution_clock;
+#include "TripleBuffer.hpp"
+#include "UniformBuffer.hpp"
 
 #define CLEAR_COLOR 0.0f, 0.0f, 0.0f, 0.0f
-
-enum axis {
-    X,
-    Y,
-    Z
-};
+#define COASTLINE_COLOR 0.55f, 0.8f, 1.0f, 0.9f
+#define BORDER_COLOR 1.0f, 0.85f, 0.4f, 0.8f
 
 GLFWwindow *window = nullptr;
 const int window_width = 800, window_height = 800;
+const char *window_title = "Cheap Google Earth";
 
-bool mouse_pressed = false;
+// Written by the callbacks, read by the update thread
+Input input;
 
+// Only used on the main thread to turn positions into deltas
 double xpos_prev = 0, ypos_prev = 0;
-double dx = 0, dy = 0;
 
-// Position of camera on X axis
-float pos_x = 2.0f;
-float scroll = 0.0f;
+// Toggled with A, switches to the earth program variant with ATMOSPHERE defined
+bool show_atmosphere = false;
 
-axis rotation_mode = Z;
+// Toggled with C, to compare the GPU time with and without back-face culling
+bool cull_back_faces = true;
 
-// For first draw
-bool redraw = true;
-
-GLuint vao[2] = { 0, 0 };
-GLuint program = 0;
+// Toggled with P, shows GPU pass timings as bars and in the window title
+bool show_gpu_profiler = false;
 
 /* CALLBACKS */
 
 static void cursor_pos_callback(GLFWwindow *window, double xpos, double ypos)
 {
-    (void) window;
-
-    dx = xpos - xpos_prev;
-    dy = ypos - ypos_prev;
+    input.add_cursor_delta(xpos - xpos_prev, ypos - ypos_prev);
     xpos_prev = xpos;
     ypos_prev = ypos;
+
+    // Picking works in framebuffer pixels, which differ from screen
+    // coordinates on high DPI displays
+    int width = 0, height = 0, framebuffer_width = 0, framebuffer_height = 0;
+    glfwGetWindowSize(window, &width, &height);
+    glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+    if (width > 0 && height > 0) {
+        input.set_cursor_pos(xpos * framebuffer_width / width, ypos * framebuffer_height / height);
+    }
+}
+
+static void cursor_enter_callback(GLFWwindow *window, int entered)
+{
+    (void) window;
+
+    if (!entered) {
+        input.set_cursor_pos(-1.0, -1.0);
+    }
 }
 
 static void framebuffer_size_callback(GLFWwindow *window, int width, int height)
@@ -68,6 +103,7 @@ static void framebuffer_size_callback(GLFWwindow *window, int width, int height)
     (void) window;
 
     glViewport(0, 0, width, height);
+    input.set_framebuffer_size(width, height);
 }
 
 static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
@@ -82,13 +118,25 @@ static void key_callback(GLFWwindow* window, int key, int scancode, int action,
     if (action == GLFW_PRESS) {
         switch (key) {
             case GLFW_KEY_1:
-                rotation_mode = X;
+                input.set_rotation_mode(X);
                 break;
             case GLFW_KEY_2:
-                rotation_mode = Y;
+                input.set_rotation_mode(Y);
                 break;
             case GLFW_KEY_3:
-                rotation_mode = Z;
+                input.set_rotation_mode(Z);
+                break;
+            case GLFW_KEY_A:
+                show_atmosphere = !show_atmosphere;
+                glfwPostEmptyEvent();
+                break;
+            case GLFW_KEY_C:
+                cull_back_faces = !cull_back_faces;
+                glfwPostEmptyEvent();
+                break;
+            case GLFW_KEY_P:
+                show_gpu_profiler = !show_gpu_profiler;
+                glfwPostEmptyEvent();
         }
     }
 }
@@ -99,7 +147,7 @@ static void mouse_button_callback(GLFWwindow *window, int button, int action, in
     (void) mods;
 
     if (button == GLFW_MOUSE_BUTTON_LEFT) {
-        mouse_pressed = (action == GLFW_PRESS);
+        input.set_mouse_pressed(action == GLFW_PRESS);
     }
 }
 
@@ -107,13 +155,44 @@ static void scroll_callback(GLFWwindow *window, double xOffset, double yOffset)
     (void) window;
     (void) xOffset;
 
-    scroll += yOffset / SCROLL_SPEED;
+    input.add_scroll(yOffset);
+}
+
+// The coordinates under the cursor and the GPU timings, if there are any
+static std::string make_window_title(const FrameState &state, const std::string &gpu_summary)
+{
+    std::ostringstream title;
+    title << window_title;
+    if (state.cursor_on_globe) {
+        double lat = state.cursor_position.lat * 180.0 / PI;
+        double lon = state.cursor_position.lon * 180.0 / PI;
+        title.setf(std::ios::fixed);
+        title.precision(5);
+        title << " - " << std::abs(lat) << (lat >= 0.0 ? " N " : " S ") << std::abs(lon) << (lon >= 0.0 ? " E" : " W");
+        title.precision(0);
+        title << ", " << state.cursor_position.height << " m";
+    }
+    if (!gpu_summary.empty()) {
+        title << " - " << gpu_summary;
+    }
+    return title.str();
+}
+
+static void wake_render_thread()
+{
+    // Thread-safe, interrupts glfwWaitEvents on the main thread
+    glfwPostEmptyEvent();
 }
 
 /* MAIN */
 
 int main()
 {
+    // Set CGE_TRACE=<file> to record CPU zones, written as Chrome trace JSON on exit
+    const char *trace_path = std::getenv("CGE_TRACE");
+    Profiler::set_enabled(trace_path != nullptr);
+    Profiler::set_thread_name("render");
+
     if (!glfwInit()) {
         const char *error = nullptr;
         glfwGetError(&error);
@@ -125,7 +204,7 @@ int main()
     window = glfwCreateWindow(
         window_width,
         window_height,
-        "Cheap Google Earth",
+        window_title,
         nullptr,
         nullptr);
     if (window == NULL) {
@@ -138,6 +217,7 @@ int main()
     glfwSetWindowSizeLimits(window, 200, 200, 2000, 2000);
 
     glfwSetCursorPosCallback(window, cursor_pos_callback);
+    glfwSetCursorEnterCallback(window, cursor_enter_callback);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetKeyCallback(window, key_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
@@ -150,204 +230,440 @@ int main()
         return EXIT_FAILURE;
     }
 
-    glEnable(GL_DEPTH_TEST);
-
-    glGenVertexArrays(2, vao);
-
-    glBindVertexArray(vao[0]);
-#if DEBUG
-    Sphere earth(glm::vec3(0.0f), EARTH_RADIUS, 3, 3);
-#else
-    Sphere earth(glm::vec3(0.0f), EARTH_RADIUS, 20, 20);
-#endif
+    // Filter across cube map face edges, otherwise the skybox shows seams
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
-    glBindVertexArray(vao[1]);
-    Sphere space(glm::vec3(0.0f), SPACE_RADIUS, 20, 20);
+    // Reversed-Z into a float depth buffer where glClipControl exists,
+    // logarithmic depth written by the vertex shaders otherwise
+    depth_mode depth = (GLAD_GL_VERSION_4_5 || GLAD_GL_ARB_clip_control) ? DEPTH_REVERSED : DEPTH_LOGARITHMIC;
+    uint32_t depth_features = FEATURE_LOG_DEPTH;
+    if (depth == DEPTH_REVERSED) {
+        glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+        depth_features = FEATURE_REVERSED_Z;
+    }
+    glClearDepth(far_depth(depth));
+
+    // Start building every shader program, from the binary cache if possible.
+    // The driver compiles in the background while we create meshes and
+    // decode textures below.
+    // Feature variants are separate programs, so switching features costs
+    // no branches in the shaders.
+    ProgramCache program_cache(PROGRAM_CACHE_DIR);
+    // Optional, the earth programs blend it over the texture when there are events
+    bool has_heatmap = std::filesystem::exists(HEATMAP_SRC);
+    uint32_t earth_features = (DEBUG ? FEATURE_WIREFRAME : 0) | FEATURE_MULTI_DRAW | depth_features
+        | (has_heatmap ? FEATURE_HEATMAP : 0);
+    std::unique_ptr<Program> earth_program(new Program());
+    std::unique_ptr<Program> earth_atmosphere_program(new Program());
+    std::unique_ptr<Program> skybox_program(new Program());
+    program_cache.add(*earth_program, VERTEX_SHADER_SRC, FRAGMENT_SHADER_SRC, earth_features);
+    program_cache.add(*earth_atmosphere_program, VERTEX_SHADER_SRC, FRAGMENT_SHADER_SRC, earth_features | FEATURE_ATMOSPHERE);
+    program_cache.add(*skybox_program, SKYBOX_VERTEX_SHADER_SRC, SKYBOX_FRAGMENT_SHADER_SRC, depth_features);
+    std::unique_ptr<Program> marker_program(new Program());
+    program_cache.add(*marker_program, MARKER_VERTEX_SHADER_SRC, MARKER_FRAGMENT_SHADER_SRC, depth_features);
+    std::unique_ptr<Program> line_program(new Program());
+    program_cache.add(*line_program, LINE_VERTEX_SHADER_SRC, LINE_FRAGMENT_SHADER_SRC, depth_features);
+    // Drawn in window pixels, depth does not apply
+    std::unique_ptr<Program> label_program(new Program());
+    program_cache.add(*label_program, LABEL_VERTEX_SHADER_SRC, LABEL_FRAGMENT_SHADER_SRC);
+    program_cache.submit();
+
+    // Optional, the globe is smooth without tiles
+    Terrain terrain;
+    terrain.load_directory(DEM_DIR);
+    Globe globe(Ellipsoid::wgs84(), terrain, GLOBE_PATCH_ROWS, GLOBE_PATCH_COLUMNS, GLOBE_PATCH_RESOLUTION);
+    // All patches share one set of buffers and are drawn with one call
+    const std::vector<GlobePatch> &patches = globe.get_patches();
+    PatchPool earth_pool((uint32_t) patches[0].vertices.size() / 3, (uint32_t) patches[0].indices.size(), (uint32_t) patches.size());
+    std::vector<uint32_t> earth_slots;
+    for (const GlobePatch &patch : patches) {
+        int slot = earth_pool.allocate(patch);
+        if (slot == ALLOCATE_PATCH_FAILURE) {
+            return EXIT_FAILURE;
+        }
+        earth_slots.push_back((uint32_t) slot);
+    }
 
-    // Load and compile shaders and shader program
-    Shader vertex_shader(GL_VERTEX_SHADER), fragment_shader(GL_FRAGMENT_SHADER);
-    if (vertex_shader.load_shader("shaders/vertex_shader.vert") != LOAD_SHADER_SUCCESS) {
+    Texture earth_texture;
+    if (earth_texture.load_texture(EARTH_TEXTURE_SRC) != LOAD_TEXTURE_SUCCESS) {
         return EXIT_FAILURE;
     }
-    if (fragment_shader.load_shader("shaders/fragment_shader.frag") != LOAD_SHADER_SUCCESS) {
+    
+    Skybox skybox;
+    if (skybox.load(SPACE_TEXTURE_SRC, SKYBOX_FACE_SIZE) != LOAD_TEXTURE_SUCCESS) {
         return EXIT_FAILURE;
     }
 
-    program = glCreateProgram();
-    glAttachShader(program, vertex_shader.get_id());
-    glAttachShader(program, fragment_shader.get_id());
-    glLinkProgram(program);
-
-    {
-        GLint success = 0;
-        glGetProgramiv(program, GL_LINK_STATUS, &success);
-        if (!success) {
-            GLint len = 0;
-            glGetProgramiv(program, GL_INFO_LOG_LENGTH, &len);
-        
-            char *log_ptr = (char*) calloc(len, 1);
-            std::unique_ptr<char> log(log_ptr);
-            glGetProgramInfoLog(program, len, nullptr, log.get());
-
-            std::cerr << "Program linking failed!\n" << log.get() << std::endl;
+    // Optional. Changes to the layer are uploaded at the start of a frame.
+    MarkerLayer markers(Ellipsoid::wgs84());
+    if (std::filesystem::exists(MARKERS_SRC) && markers.load_csv(MARKERS_SRC) != LOAD_MARKERS_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+    MarkerBuffer marker_buffer;
 
+    // Events are counted on worker threads, the shown level follows the view
+    HeatmapLayer heatmap(Ellipsoid::wgs84());
+    if (has_heatmap && heatmap.load_csv(HEATMAP_SRC) != LOAD_EVENTS_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+    HeatmapTexture heatmap_texture;
+
+    // Optional, borders over coastlines. Lines are split for the view on
+    // worker threads, each finished build is uploaded whole.
+    const std::string line_sources[] = { COASTLINES_SRC, BORDERS_SRC };
+    const glm::vec4 line_source_colors[] = { glm::vec4(COASTLINE_COLOR), glm::vec4(BORDER_COLOR) };
+    std::vector<std::unique_ptr<LineLayer>> line_layers;
+    std::vector<std::unique_ptr<LineBuffer>> line_buffers;
+    std::vector<glm::vec4> line_colors;
+    for (size_t i = 0; i < 2; i++) {
+        if (!std::filesystem::exists(line_sources[i])) {
+            continue;
+        }
+        std::unique_ptr<LineLayer> layer(new LineLayer(Ellipsoid::wgs84(), terrain, wake_render_thread));
+        if (layer->load_geojson(line_sources[i]) != LOAD_LINES_SUCCESS) {
             return EXIT_FAILURE;
         }
+        line_layers.push_back(std::move(layer));
+        line_buffers.emplace_back(new LineBuffer());
+        line_colors.push_back(line_source_colors[i]);
     }
 
-    glUseProgram(program);
-
-    GLint pos_attr = glGetAttribLocation(program, "pos_attr");
-    GLint tex_attr = glGetAttribLocation(program, "tex_attr");
-
-    glBindVertexArray(vao[0]);
-
-    // Now that we can get the attribute locations, set the data link to the arrays given
-    glBindBuffer(GL_ARRAY_BUFFER, earth.get_vertex_vbo());
-    glVertexAttribPointer(pos_attr, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
-    glEnableVertexAttribArray(pos_attr);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, earth.get_texcoord_vbo());
-    // NOTE: Fails for some reason (probably optimization by the GPU driver),
-    // if texcoords are not used in shaders
-    glVertexAttribPointer(tex_attr, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
-    glEnableVertexAttribArray(tex_attr);
-
-    glBindVertexArray(vao[1]);
-
-    // Now that we can get the attribute locations, set the data link to the arrays given
-    glBindBuffer(GL_ARRAY_BUFFER, space.get_vertex_vbo());
-    glVertexAttribPointer(pos_attr, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
-    glEnableVertexAttribArray(pos_attr);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, space.get_texcoord_vbo());
-    // NOTE: Fails for some reason (probably optimization by the GPU driver),
-    // if texcoords are not used in shaders
-    glVertexAttribPointer(tex_attr, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
-    glEnableVertexAttribArray(tex_attr);
-
-    // Projections
-    GLint model = glGetUniformLocation(program, "model");
-    GLint view = glGetUniformLocation(program, "view");
-    GLint proj = glGetUniformLocation(program, "proj");
-    
-    // Because of the texture, rotate the earth around one time
-    glm::mat4 model_earth_transform = glm::rotate(
-        glm::mat4(1.0f),
-        glm::radians(180.0f),
-        glm::vec3(0.0f, 0.0f, 1.0f)
-    );
-    glm::mat4 model_space_transform = glm::rotate(
-        glm::mat4(1.0f),
-        glm::radians(180.0f),
-        glm::vec3(0.0f, 0.0f, 1.0f)
-    );
-    glm::mat4 view_transform = glm::lookAt(
-        glm::vec3(pos_x, 0.0f, 0.0f),
-        glm::vec3(0.0f, 0.0f, 0.0f),
-        glm::vec3(0.0f, 0.0f, 1.0f)
-    );
-    glm::mat4 proj_transform = glm::perspective(
-        glm::radians(FOV),
-        (float) window_width / (float) window_height,
-        0.1f,
-        1000.0f
-    );
-
-    glUniformMatrix4fv(view, 1, GL_FALSE, glm::value_ptr(view_transform));
-    glUniformMatrix4fv(proj, 1, GL_FALSE, glm::value_ptr(proj_transform));
+    // Optional, needs both the places and a font. The glyph atlas is built
+    // on the first start and read from the cache after that.
+    GlyphAtlas glyph_atlas;
+    std::unique_ptr<LabelLayer> labels;
+    LabelBuffer label_buffer;
+    if (std::filesystem::exists(LABELS_SRC) && std::filesystem::exists(FONT_SRC)) {
+        if (glyph_atlas.load(FONT_SRC, GLYPH_CACHE_DIR) != LOAD_ATLAS_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+        labels.reset(new LabelLayer(Ellipsoid::wgs84(), glyph_atlas));
+        if (labels->load_csv(LABELS_SRC) != LOAD_LABELS_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+        label_buffer.upload_atlas(glyph_atlas);
+    }
 
-    Texture earth_texture;
-    if (earth_texture.load_texture(EARTH_TEXTURE_SRC) != LOAD_TEXTURE_SUCCESS) {
+    if (program_cache.finish() != LOAD_PROGRAM_SUCCESS) {
         return EXIT_FAILURE;
     }
-    
-    Texture space_texture;
-    if (space_texture.load_texture(SPACE_TEXTURE_SRC) != LOAD_TEXTURE_SUCCESS) {
-        return EXIT_FAILURE;
+
+    // Attribute locations are fixed with layout qualifiers, so they are the
+    // same in every variant and survive shader reloads. Querying them would
+    // fail in variants that do not use texcoords.
+    earth_pool.set_attributes(POS_ATTR_LOCATION, TEX_ATTR_LOCATION, MORPH_ATTR_LOCATION);
+
+    // Transforms live in uniform buffers shared by every program, so
+    // programs can be switched or reloaded without setting uniforms again
+    UniformBuffer frame_uniforms(FRAME_UNIFORM_BINDING, sizeof(FrameUniforms));
+    UniformBuffer object_uniforms(OBJECT_UNIFORM_BINDING, sizeof(ObjectUniforms));
+    // Per-patch data of the multi draw, in draw order
+    StorageBuffer earth_objects(DRAW_OBJECT_STORAGE_BINDING);
+    std::vector<ObjectUniforms> earth_object_data;
+
+    // Rebuilds the programs in the background when a file in shaders/ changes
+    ProgramReloader program_reloader(program_cache, SHADER_DIR, wake_render_thread);
+    program_reloader.add(earth_program, VERTEX_SHADER_SRC, FRAGMENT_SHADER_SRC, earth_features);
+    program_reloader.add(earth_atmosphere_program, VERTEX_SHADER_SRC, FRAGMENT_SHADER_SRC, earth_features | FEATURE_ATMOSPHERE);
+    program_reloader.add(skybox_program, SKYBOX_VERTEX_SHADER_SRC, SKYBOX_FRAGMENT_SHADER_SRC, depth_features);
+    program_reloader.add(marker_program, MARKER_VERTEX_SHADER_SRC, MARKER_FRAGMENT_SHADER_SRC, depth_features);
+    program_reloader.add(line_program, LINE_VERTEX_SHADER_SRC, LINE_FRAGMENT_SHADER_SRC, depth_features);
+    program_reloader.add(label_program, LABEL_VERTEX_SHADER_SRC, LABEL_FRAGMENT_SHADER_SRC);
+    program_reloader.start();
+
+    GpuProfiler gpu_profiler;
+    // Set CGE_GPU_PROFILE=<file> to log per-pass GPU timings as JSON lines
+    const char *gpu_profile_path = std::getenv("CGE_GPU_PROFILE");
+    bool gpu_profile_log = false;
+    if (gpu_profile_path != nullptr) {
+        gpu_profile_log = gpu_profiler.open_log(gpu_profile_path) == OPEN_PROFILER_LOG_SUCCESS;
     }
 
+    // The main thread polls events and renders, camera math runs on the update thread
+    TripleBuffer<FrameState> frames;
+    Picker picker(Ellipsoid::wgs84(), terrain);
+    Simulation simulation(input, frames, globe.get_bounds(), picker, depth, wake_render_thread);
+
+    {
+        int width = 0, height = 0;
+        glfwGetFramebufferSize(window, &width, &height);
+        input.set_framebuffer_size(width, height);
+    }
     glfwGetCursorPos(window, &xpos_prev, &ypos_prev);
-    auto begin = high_resolution_clock::now();
+    simulation.start();
+
+    // Back faces of the closed meshes are always hidden behind front faces
+    RenderState opaque_state;
+    opaque_state.depth_func = depth_func_nearer(depth);
+    RenderState skybox_state = Skybox::get_render_state(depth);
+    RenderState marker_state = MarkerBuffer::get_render_state(depth);
+    RenderState line_state = LineBuffer::get_render_state(depth);
+    RenderState label_state = LabelBuffer::get_render_state();
+    RenderStateCache render_states;
+    // Only used with reversed-Z, the window has no float depth buffer
+    RenderTarget render_target;
+
+    uint64_t rendered_frames = 0;
+    bool drawn_atmosphere = show_atmosphere;
+    bool drawn_culling = cull_back_faces;
+    bool drawn_gpu_profiler = show_gpu_profiler;
+    std::string gpu_summary;
+    std::string current_title = window_title;
     while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
+        // While profiling, render continuously so results keep coming in.
+        // Same while reloading shaders, to poll the compile status.
+        bool profiling = show_gpu_profiler || gpu_profile_log;
+        if (profiling || program_reloader.is_busy()) {
+            PROFILE_SCOPE("glfwPollEvents");
+            glfwPollEvents();
+        }
+        else {
+            PROFILE_SCOPE("glfwWaitEvents");
+            glfwWaitEvents();
+        }
 
-        if (mouse_pressed && (dx != 0 || dy != 0)) {
-            float dir = 0.0f;
-            if (std::abs(dx) > std::abs(dy)) {
-                dir = dx;
-            }
-            else {
-                dir = dy;
+        bool reloaded = program_reloader.update();
+
+        // Key presses that only affect rendering post an empty event
+        bool toggled = show_atmosphere != drawn_atmosphere || cull_back_faces != drawn_culling
+            || show_gpu_profiler != drawn_gpu_profiler;
+        drawn_atmosphere = show_atmosphere;
+        drawn_culling = cull_back_faces;
+        drawn_gpu_profiler = show_gpu_profiler;
+
+        bool fetched = frames.fetch();
+        const FrameState &state = frames.read_buffer();
+
+        // Finished line builds wake the loop, the next build starts from
+        // the latest view
+        bool lines_changed = false;
+        for (size_t l = 0; l < line_layers.size(); l++) {
+            if (line_layers[l]->update(state.earth_camera_position, state.pixel_scale)) {
+                line_buffers[l]->upload(*line_layers[l]);
+                lines_changed = true;
             }
+        }
 
-            glm::vec3 rot(0.0f);
-            switch (rotation_mode) {
-                case X:
-                    rot.x = dir;
-                    break;
-                case Y:
-                    rot.y = dir;
-                    break;
-                case Z:
-                    rot.z = dir;
-            }
-            model_earth_transform = glm::rotate(model_earth_transform, glm::radians(ROTATION_SPEED), glm::normalize(rot));
-            dx = 0;
-            dy = 0;
-            redraw = true;
+        bool heatmap_changed = has_heatmap && heatmap.update(state.earth_camera_position, state.pixel_scale);
+        if (heatmap_changed) {
+            heatmap_texture.upload(heatmap);
         }
 
-        if (scroll != 0.0f && pos_x + scroll > EARTH_RADIUS && pos_x + scroll < SPACE_RADIUS) {
-            pos_x += scroll;
+        bool markers_changed = marker_buffer.upload(markers);
 
-            view_transform = glm::lookAt(
-                glm::vec3(pos_x, 0.0f, 0.0f),
-                glm::vec3(0.0f, 0.0f, 0.0f),
-                glm::vec3(0.0f, 0.0f, 1.0f)
-            );
+        if (!fetched && !profiling && !reloaded && !toggled && !lines_changed && !heatmap_changed && !markers_changed) {
+            continue;
+        }
+        PROFILE_SCOPE("frame");
 
-            glUniformMatrix4fv(view, 1, GL_FALSE, glm::value_ptr(view_transform));
-            redraw = true;
+        gpu_profiler.begin_frame();
+
+        if (depth == DEPTH_REVERSED) {
+            render_target.bind(state.viewport_width, state.viewport_height);
         }
-        scroll = 0.0f;
 
-        if (redraw) {
+        {
+            GpuScope scope(gpu_profiler, "clear");
+            // glClear obeys the depth mask
+            render_states.apply(RenderState());
             glClearColor(CLEAR_COLOR);
             glClear(GL_COLOR_BUFFER_BIT);
-            glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
             glClear(GL_DEPTH_BUFFER_BIT);
+        }
 
+        {
+            PROFILE_SCOPE("uniforms");
+
+            FrameUniforms frame_data;
+            frame_data.view = state.view;
+            frame_data.proj = state.proj;
+            frame_data.view_proj = state.view_proj;
+            split_double(state.camera_position, frame_data.camera_high, frame_data.camera_low);
+            split_double(state.earth_camera_position, frame_data.earth_camera_high, frame_data.earth_camera_low);
+            frame_data.time = state.time;
+            frame_data.log_depth_coefficient = state.log_depth_coefficient;
+            frame_data.viewport_size = glm::vec2(state.viewport_width, state.viewport_height);
+            frame_uniforms.set(0, &frame_data);
+            frame_uniforms.upload(1);
+            frame_uniforms.bind(0);
+
+            earth_object_data.clear();
+            for (size_t i = 0; i < state.visible.size(); i++) {
+                ObjectUniforms object_data = {};
+                object_data.model = state.visible[i].model;
+                split_double(state.visible[i].center, object_data.center_high, object_data.center_low);
+                object_data.morph_factor = state.visible[i].morph;
+                object_data.lod_level = (float) state.visible[i].lod;
+                if (state.visible[i].object == EARTH) {
+                    earth_object_data.push_back(object_data);
+                }
+                else {
+                    object_uniforms.set(i, &object_data);
+                }
+            }
+            object_uniforms.upload(state.visible.size());
+            earth_objects.upload(earth_object_data.data(), earth_object_data.size() * sizeof(ObjectUniforms));
+        }
+
+        PROFILE_SCOPE("draw");
+        // Items are sorted by pass, one GPU timing per pass
+        const Program *current_program = nullptr;
+        int current_pass = -1;
+        bool earth_drawn = false;
+        for (size_t i = 0; i < state.visible.size(); i++) {
+            const DrawItem &item = state.visible[i];
+            if ((item.object == MARKERS && marker_buffer.get_count() == 0) || (item.object == LINES && line_layers.empty())
+                || (item.object == LABELS && !labels)) {
+                continue;
+            }
+
+            if ((int) item.pass != current_pass) {
+                if (current_pass >= 0) {
+                    gpu_profiler.end();
+                }
+                if (item.pass == PASS_SCREEN) {
+                    gpu_profiler.begin("screen");
+                    render_states.apply(label_state);
+                }
+                else if (item.pass == PASS_SKY) {
+                    gpu_profiler.begin("sky");
+                    render_states.apply(skybox_state);
+                }
+                else if (item.pass == PASS_OVERLAY) {
+                    gpu_profiler.begin("overlay");
+                }
+                else {
+                    gpu_profiler.begin("opaque");
+                    opaque_state.cull = cull_back_faces;
+                    render_states.apply(opaque_state);
+                }
+                current_pass = item.pass;
+            }
+            // Overlays differ in blending, the cache skips what is set
+            if (item.pass == PASS_OVERLAY) {
+                render_states.apply(item.object == LINES ? line_state : marker_state);
+            }
+
+            const Program *item_program = skybox_program.get();
+            if (item.object == EARTH) {
+                item_program = show_atmosphere ? earth_atmosphere_program.get() : earth_program.get();
+            }
+            else if (item.object == MARKERS) {
+                item_program = marker_program.get();
+            }
+            else if (item.object == LINES) {
+                item_program = line_program.get();
+            }
+            else if (item.object == LABELS) {
+                item_program = label_program.get();
+            }
+
+            if (item_program != current_program) {
+                item_program->use();
+                current_program = item_program;
+            }
+            object_uniforms.bind(i);
+
+            switch (item.object) {
+                case EARTH: {
+                    // Every visible patch at the first one, in sorted order
+                    // so they still go front to back
+                    if (earth_drawn) {
+                        break;
+                    }
+                    earth_drawn = true;
 #if DEBUG
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+                    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 #endif
-
-            glUniformMatrix4fv(model, 1, GL_FALSE, glm::value_ptr(model_earth_transform));
-            earth_texture.use();
-            glBindVertexArray(vao[0]);
-            earth.draw();
-            
+                    earth_texture.use();
+                    if (has_heatmap) {
+                        heatmap_texture.use();
+                    }
+                    for (const DrawItem &patch_item : state.visible) {
+                        if (patch_item.object == EARTH) {
+                            const PatchLod &lod = patches[patch_item.patch].lods[patch_item.lod];
+                            earth_pool.add_draw(earth_slots[patch_item.patch], lod.first_index, lod.index_count);
+                        }
+                    }
+                    earth_pool.draw();
 #if DEBUG
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+                    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 #endif
+                    break;
+                }
+                case MARKERS: {
+                    glUniform1f(marker_program->get_uniform_location("marker_size"), MARKER_SIZE);
+                    marker_buffer.draw();
+                    break;
+                }
+                case LINES: {
+                    glUniform1f(line_program->get_uniform_location("line_width"), LINE_WIDTH);
+                    GLint color_location = line_program->get_uniform_location("line_color");
+                    for (size_t l = 0; l < line_buffers.size(); l++) {
+                        glUniform4fv(color_location, 1, &line_colors[l][0]);
+                        line_buffers[l]->draw();
+                    }
+                    break;
+                }
+                case LABELS: {
+                    // Placed again every frame, the view decides what fits
+                    labels->layout(state.view_proj, item.model, state.earth_camera_position,
+                        state.viewport_width, state.viewport_height, LABEL_SIZE);
+                    label_buffer.upload(*labels);
+                    glUniform1f(label_program->get_uniform_location("distance_scale"),
+                        2.0f * GLYPH_SDF_SPREAD * LABEL_SIZE / GLYPH_SDF_EM);
+                    glUniform1f(label_program->get_uniform_location("halo_width"), LABEL_HALO);
+                    label_buffer.draw();
+                    break;
+                }
+                case SPACE: {
+                    skybox.draw();
+                }
+            }
+        }
+        if (current_pass >= 0) {
+            gpu_profiler.end();
+        }
 
-            glUniformMatrix4fv(model, 1, GL_FALSE, glm::value_ptr(model_space_transform));
-            space_texture.use();
-            glBindVertexArray(vao[1]);
-            space.draw();
+        if (depth == DEPTH_REVERSED) {
+            GpuScope scope(gpu_profiler, "blit");
+            render_target.blit_to_screen();
+        }
 
-            glfwSwapBuffers(window);
+        gpu_profiler.end_frame();
 
-            redraw = false;
+        if (show_gpu_profiler) {
+            gpu_profiler.draw_overlay(state.viewport_width, state.viewport_height);
+            if (rendered_frames % GPU_PROFILER_AVERAGE_SAMPLES == 0 || gpu_summary.empty()) {
+                gpu_summary = gpu_profiler.summary();
+            }
+        }
+        else {
+            gpu_summary.clear();
         }
 
-        auto end = high_resolution_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
-        std::this_thread::sleep_for(std::chrono::milliseconds(16 - elapsed));
-        begin = high_resolution_clock::now();
+        {
+            // Setting the title is a window system call, only when it changes
+            std::string title = make_window_title(state, gpu_summary);
+            if (title != current_title) {
+                glfwSetWindowTitle(window, title.c_str());
+                current_title = title;
+            }
+        }
+
+        {
+            PROFILE_SCOPE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
+        rendered_frames++;
     }
 
-    glDeleteVertexArrays(2, vao);
+    simulation.stop();
+    program_reloader.stop();
+
+    if (trace_path != nullptr) {
+        Profiler::dump(trace_path);
+    }
 
     glfwDestroyWindow(window);
     glfwTerminate();